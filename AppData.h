@@ -7,6 +7,7 @@
 #include <DirectXMath.h>
 #include <DirectXCollision.h>
 #include "Common/TypeDef.h"
+#include "Common/SmallVector.h"
 #include "Common/VectorMath.h"
 
 using namespace DirectX;
@@ -68,7 +69,66 @@ namespace DX
 		VA_Forward_Shading_Planar_Reflections,
 
 		// Texture.
-		VA_CurrentKB
+		VA_CurrentKB,
+
+		// LOD, LOD0 against the compared LOD, meshes missing from that LOD give 0.
+		VA_LOD_Triangle_Ratio,		// LODn / LOD0 triangles, 1 means the LOD reduces nothing.
+		VA_LOD_Vertex_Delta,		// LOD0 - LODn vertices.
+		VA_LOD_Material_Delta,		// LOD0 - LODn materials.
+
+		// User defined, see FSceneExpression.
+		VA_Custom,
+
+		VA_Count
+	};
+
+	// How VA_CurrentKB charges a texture shared by several meshes.
+	enum ETextureAttribution
+	{
+		TA_Full,			// Every referencing mesh pays the whole texture.
+		TA_SplitByMesh,		// Split evenly across the referencing meshes, the meshes sum back to the texture size.
+		TA_SplitByInstance	// Split evenly across the referencing instances, the instances sum back to the texture size.
+	};
+
+	// Rows of a group by rollup.
+	enum EGroupBySource
+	{
+		GS_Meshes,
+		GS_Instances,
+		GS_Materials,
+		GS_Textures
+	};
+
+	enum EGroupByKey
+	{
+		GK_Name,
+		GK_OwnerName,	// Meshes / instances only.
+		GK_AssetPath,
+		GK_AssetFolder,
+		GK_Material		// Meshes / instances only, a mesh counts once per material it uses.
+	};
+
+	enum EGroupByAggregate
+	{
+		GA_Sum,
+		GA_Count,
+		GA_Min,
+		GA_Max,
+		GA_Avg
+	};
+
+	// How the CPU heatmap spreads an instance over its grid.
+	enum EHeatmapSplat
+	{
+		HS_Coverage,	// Weighted by the part of every cell the box footprint covers, like the additive box pass.
+		HS_Center		// The whole value in the cell of the box centre.
+	};
+
+	// How the FScene boxes are fed to the box pass.
+	enum EFSceneGeometry
+	{
+		FG_Instanced,	// One unit box, drawn once per FSceneBoxInstance (28 bytes per box).
+		FG_Baked		// 8 corners and 36 indices per box in one mesh.
 	};
 
 	enum EVisualizationColorMode
@@ -77,6 +137,114 @@ namespace DX
 		VCM_ColorRGB
 	};
 
+	// Render side buffers built from the imported FScenes.
+	struct RenderFootprint
+	{
+		uint64 NumRenderItems = 0;
+		uint64 NumBoxes = 0;
+		uint64 VertexBufferBytes = 0;		// GPU default heap.
+		uint64 IndexBufferBytes = 0;		// GPU default heap.
+		uint64 InstanceBufferBytes = 0;		// GPU default heap, instanced geometry only.
+		uint64 UploaderBytes = 0;			// Upload heap copies kept by the MeshGeometry.
+		uint64 CPUGeometryBytes = 0;		// VertexBufferCPU / IndexBufferCPU / InstanceBufferCPU blobs.
+		uint64 StructureBufferBytes = 0;	// Upload heap.
+		uint64 CPUStructureBufferBytes = 0;
+		bool   bEstimated = false;			// Headless, nothing was actually created.
+
+		uint64 GetTotalBytes() const
+		{
+			return VertexBufferBytes + IndexBufferBytes + InstanceBufferBytes + UploaderBytes + CPUGeometryBytes + StructureBufferBytes + CPUStructureBufferBytes;
+		}
+	};
+
+	// Assets of all the loaded FScenes, counted as stored per scene and once per UniqueId.
+	struct FSceneAssetSummary
+	{
+		uint64 NumScenes = 0;
+		uint64 NumMaterials = 0;
+		uint64 NumUniqueMaterials = 0;
+		uint64 NumMaterialInstances = 0;
+		uint64 NumUniqueMaterialInstances = 0;
+		uint64 NumTextures = 0;
+		uint64 NumUniqueTextures = 0;
+		double TextureKB = 0.0;
+		double UniqueTextureKB = 0.0;
+	};
+
+	// Statistics of the visualized attribute over all the loaded instances.
+	struct FSceneAttributeSummary
+	{
+		uint64 Count = 0;
+		float Min = 0.0f;
+		float Max = 0.0f;
+		float Mean = 0.0f;
+		float StdDev = 0.0f;
+		float P50 = 0.0f;
+		float P90 = 0.0f;
+		float P99 = 0.0f;
+		std::vector<float> Histogram;
+	};
+
+	// One group of a group by rollup, Count is the number of rows (instances for GS_Instances).
+	struct FSceneGroupRow
+	{
+		std::string Key;
+		double Value = 0.0;
+		double Count = 0.0;
+	};
+
+	// One row of the top N query, Instance is the instance of the mesh or -1 for meshes.
+	struct FSceneTopNRow
+	{
+		std::string Name;
+		std::string OwnerName;
+		std::string AssetPath;
+		int32 Instance = -1;
+		float Value = 0.0f;
+	};
+
+	// What the frustum culling keeps on screen, over all the scenes.
+	struct FSceneViewStats
+	{
+		uint64 NumInstances = 0;
+		uint64 NumVisible = 0;
+		uint32 NumDrawCalls = 0;
+		double CullMs = 0.0;
+	};
+
+	// Offscreen RT 0 of one frame read back from the GPU and rendered by SoftwareRasterizer, compared per channel (RGBA).
+	struct RasterCaptureStats
+	{
+		uint32 Width = 0;
+		uint32 Height = 0;
+		double CPUMs = 0.0;
+		uint64 NumDiffPixels = 0;
+		float MaxDiff = 0.0f;
+		// R of the GPU target, P99 over the pixels RGBPS draws.
+		float MaxValue = 0.0f;
+		float P99 = 0.0f;
+		bool bSaved = false;
+	};
+
+	// One instance hit by a click, nearest first. Materials / Textures are the records of its mesh.
+	struct FScenePickRow
+	{
+		std::string Name;
+		std::string OwnerName;
+		std::string AssetPath;
+		uint32 Scene = 0;
+		int32 Instance = -1;
+		// Instance slot in the attribute columns of its scene.
+		uint32 Slot = 0;
+		float Distance = 0.0f;
+		float Value = 0.0f;
+		uint32 NumVertices = 0;
+		uint32 NumTriangles = 0;
+		uint32 NumLODs = 0;
+		std::vector<std::string> Materials;
+		std::vector<std::string> Textures;
+	};
+
 	struct AppData
 	{
 		// User Data.	
@@ -89,6 +257,28 @@ namespace DX
 		ECameraProjType _ECameraProjType = CP_PerspectiveProj;			
 		EVisualizationAttribute _EVisualizationAttribute = VA_NumActors;		
 		EVisualizationColorMode _EVisualizationColorMode = VCM_ColorWhite;
+		ETextureAttribution _ETextureAttribution = TA_Full;
+		EFSceneGeometry _EFSceneGeometry = FG_Instanced;
+		int CompareLOD = 1;
+
+		// Source of VA_Custom, see FSceneExpression.
+		char CustomExpression[256] = "NumTriangles * NumInstances";
+		std::string CustomExpressionError;
+
+		// Heaviest meshes / instances by the visualized attribute.
+		int TopNCount = 20;
+		bool bTopNInstances = false;
+
+		// Group by rollup, meshes / instances aggregate the visualized attribute, materials / textures the named field.
+		EGroupBySource _EGroupBySource = GS_Instances;
+		EGroupByKey _EGroupByKey = GK_OwnerName;
+		EGroupByAggregate _EGroupByAggregate = GA_Sum;
+		char GroupByField[64] = "CurrentKB";
+		std::string GroupByError;
+
+		// Instances under the cursor on a left click, up to PickCount along the ray.
+		int PickCount = 4;
+		bool bShowPickBounds = true;
 		
 		float GridWidth = 60.0f;
 		float DragSpeed = 1.0f;
@@ -101,10 +291,34 @@ namespace DX
 		bool bClearFScene = false;
 		bool bVisualizationAttributeDirty = true;
 		bool bEnableCalcMax = true;
+		bool bAutoOverflow = true;
+		// Overflow from the P99 of the drawn pixels instead, RT 0 read back every few frames.
+		bool bAutoOverflowPixels = false;
+		bool bAsyncAttributeEvaluation = false;
+		bool bCustomExpressionDirty = true;
+		bool bTopNDirty = false;
+		bool bGroupByDirty = false;
+		bool bTextureAttributionDirty = false;
+		bool bCompareLODDirty = false;
+		bool bFrustumCulling = true;
+		bool bVisibleAttributeStats = false;
+		bool bVisibleSetDirty = true;
+		bool bRasterCaptureDirty = false;
+		bool bFSceneGeometryDirty = false;
+		bool bDataFootprintDirty = false;
 
 		// App Data.
 		std::vector<std::unique_ptr<BlockArea>> BlockAreas;
 		std::wstring AppPath;
+		RenderFootprint FSceneRenderFootprint;
+		FSceneAssetSummary FSceneAssets;
+		FSceneAttributeSummary AttributeStats;
+		FSceneAttributeSummary VisibleAttributeStats;
+		FSceneViewStats ViewStats;
+		RasterCaptureStats RasterCapture;
+		std::vector<FSceneTopNRow> TopN;
+		std::vector<FSceneGroupRow> GroupBy;
+		std::vector<FScenePickRow> Picked;
 		bool bOptionsChanged = false;
 		bool bGridDirdy = false;
 		bool bCameraFarZDirty = false;
@@ -158,6 +372,9 @@ namespace UnrealEngine
 	template<typename T>
 	using TArray = std::vector<T>;
 
+	// Per record index lists, mostly 1~4 entries, kept inline to avoid a heap block each.
+	using TIndexArray = SmallVector<int32, 4>;
+
 	struct FSceneStaticMeshDataSet
 	{
 	public:
@@ -171,10 +388,10 @@ namespace UnrealEngine
 		uint32 NumTriangles;
 		uint32 NumInstances;
 
-		TArray<int32> BoundsIndices;     // First is Mesh...Rest is Instance...
-		TArray<int32> TransformsIndices; // First is Mesh...Rest is Instance...
-		TArray<int32> UsedMaterialsIndices;
-		TArray<int32> UsedMaterialIntancesIndices;
+		TIndexArray BoundsIndices;     // First is Mesh...Rest is Instance...
+		TIndexArray TransformsIndices; // First is Mesh...Rest is Instance...
+		TIndexArray UsedMaterialsIndices;
+		TIndexArray UsedMaterialIntancesIndices;
 
 		uint16 NumLODs;
 		uint16 CurrentLOD;
@@ -195,8 +412,8 @@ namespace UnrealEngine
 
 		int32 BoundsIndex;
 		int32 TransformsIndex;
-		TArray<int32> UsedMaterialsIndices;
-		TArray<int32> UsedMaterialIntancesIndices;
+		TIndexArray UsedMaterialsIndices;
+		TIndexArray UsedMaterialIntancesIndices;
 
 		uint16 NumLODs;
 		uint16 CurrentLOD;
@@ -239,8 +456,8 @@ namespace UnrealEngine
 		uint32 UniqueId;
 		uint32 NumInstances;
 		uint32 NumRefs;
-		TArray<int32> MatInsIndices;
-		TArray<int32> UsedTexturesIndices;
+		TIndexArray MatInsIndices;
+		TIndexArray UsedTexturesIndices;
 		// ShaderInstructionInfo...BPS is Base Pass Shader... 
 		int32 BPSCount;
 		int32 BPSSurfaceLightmap;
@@ -300,7 +517,7 @@ namespace UnrealEngine
 		uint32 UniqueId;
 		uint32 NumRefs;
 		int32  ParentIndex;
-		TArray<int32> UsedTexturesIndices;
+		TIndexArray UsedTexturesIndices;
 
 		bool operator==(const FSceneMaterialInstanceDataSet& InElement) const
 		{
@@ -358,9 +575,16 @@ namespace UnrealEngine
 		}
 	};
 
+	// Scenes are large, they are only ever moved or shared, never copied.
 	struct FSceneDataSet
 	{
 	public:
+		FSceneDataSet() = default;
+		FSceneDataSet(FSceneDataSet&&) = default;
+		FSceneDataSet& operator=(FSceneDataSet&&) = default;
+		FSceneDataSet(const FSceneDataSet&) = delete;
+		FSceneDataSet& operator=(const FSceneDataSet&) = delete;
+
 		TArray<FSceneStaticMeshDataSet>   StaticMeshesTable;
 		TArray<FSceneSkeletalMeshDataSet> SkeletalMeshesTable;
 		TArray<FSceneLandscapeDataSet>    LandscapesTable;
@@ -375,4 +599,7 @@ namespace UnrealEngine
 		// This is an additional table for lightmap.
 		TArray<FSceneTextureDataSet>		  LightMapsAndShadowMaps;
 	};
+
+	// Immutable snapshot of an imported scene, shared by importer, renderer and GUI.
+	using FSceneDataSetPtr = std::shared_ptr<const FSceneDataSet>;
 }
\ No newline at end of file
@@ -3,9 +3,27 @@
 //
 
 #include "AppEntry.h"
+#include "UnrealEngine/FSceneBoxGeometry.h"
 #include "Common/StringManager.h"
+#include "Common/MemoryManager.h"
+#include "Common/ThreadManager.h"
+#include "Common/ImageManager.h"
+#include "Common/RasterManager.h"
+#include "Common/ReductionManager.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 
 using namespace DX::StringManager;
+using namespace DX::MemoryManager;
+using namespace DX::ThreadManager;
+using namespace DX::CullingManager;
+using namespace DX::ImageManager;
+using namespace DX::RasterManager;
+using namespace DX::ReductionManager;
 
 extern void ExitGame();
 
@@ -124,7 +142,17 @@ void AppEntry::Update(const StepTimer& timer)
 				if (!m_appGui->GetImporterData()->GetFSceneData(0)->StaticMeshesTable.empty() ||
 					!m_appGui->GetImporterData()->GetFSceneData(0)->SkeletalMeshesTable.empty())
 				{
-					m_allFSceneDataSets.push_back(*m_appGui->GetImporterData()->GetFSceneData(0));
+					// Share the importer's snapshot, the scene is never copied.
+					m_allFSceneDataSets.push_back(m_appGui->GetImporterData()->GetFSceneDataPtr(0));
+					m_assetRegistry.AddScene(m_allFSceneDataSets.back());
+					// The other LODs are only joined for the LOD attributes.
+					std::vector<const FSceneDataSet*> lods;
+					for (int lod = 1; lod < m_appGui->GetImporterData()->GetLODCount(); ++lod)
+						lods.push_back(m_appGui->GetImporterData()->GetFSceneData(lod));
+					m_fSceneAttributeContexts.push_back(m_attributeEngine.BuildContext(*m_allFSceneDataSets.back(), lods));
+					m_fSceneSpatialIndices.push_back(std::make_unique<FSceneSpatialIndex>(*m_allFSceneDataSets.back()));
+					m_appGui->GetAppData()->FSceneAssets = m_assetRegistry.GetSummary();
+					m_appGui->GetAppData()->bDataFootprintDirty = true;
 					m_deviceResources->ExecuteCommandLists([&]()
 					{
 						BuildFSceneRenderItems(m_appGui->GetImporterData()->GetFSceneData(0));
@@ -132,21 +160,19 @@ void AppEntry::Update(const StepTimer& timer)
 
 					// Above already Call to Wait for Gpu.
 					m_frameResource->ResizeBuffer<ObjectConstant>((UINT)m_allRitems.size());
-					UINT structBufferCount = 0;
-					for (auto& fSceneDataSet : m_allFSceneDataSets)
-					{
-						for (auto& staticMesh : fSceneDataSet.StaticMeshesTable)
-						{
-							structBufferCount += (UINT)staticMesh.BoundsIndices.size();
-						}
-						structBufferCount += (UINT)fSceneDataSet.SkeletalMeshesTable.size();
-					}				
-					m_frameResource->ResizeBuffer<StructureBuffer>(structBufferCount);
-					// After resize StructureBuffer, Update is Needed.
-					m_appGui->GetAppData()->bVisualizationAttributeDirty = true;
+					// Append the new scene's segment, only it needs an evaluation.
+					FSceneSBufferSegment segment;
+					segment.Offset = m_numFSceneBoxes;
+					segment.Count = m_fSceneAttributeContexts.back()->NumInstances;
+					segment.bStale = true;
+					m_fSceneSBufferSegments.push_back(segment);
+					m_numFSceneBoxes += segment.Count;
+					m_perFSceneCPUSBuffer.resize(m_numFSceneBoxes);
+					ReserveFSceneSBuffer(m_numFSceneBoxes);
 					// CBuffer Changed.
 					for (auto& ri : m_allRitems)
 						ri->bObjectDataChanged = true;
+					m_appGui->GetAppData()->bVisibleSetDirty = true;
 				}
 			}		
 		}
@@ -162,25 +188,99 @@ void AppEntry::Update(const StepTimer& timer)
 		m_allRitems.resize(1);
 		m_renderItemLayer[RenderLayer::FScene].clear();
 		m_perFSceneCPUSBuffer.clear();
+		m_assetRegistry.Clear();
+		m_fSceneAttributeContexts.clear();
+		m_fSceneSpatialIndices.clear();
+		m_fSceneSBufferSegments.clear();
+		m_renderItemLayer[RenderLayer::Selected].clear();
+		m_pickRItem = nullptr;
+		m_pickedBounds.clear();
+		m_fSceneVisibleSets.clear();
+		m_attributeCache.Clear();
+		// Millions of small frees, keep them off the render thread.
+		m_releaser.Release(std::move(m_allFSceneDataSets));
+		m_allFSceneDataSets.clear();
+		// The importer still shares the last import and its LODs, unless a new one is being parsed.
+		if (m_appGui->CheckImporterLock())
+			m_releaser.Release(m_appGui->GetImporterData()->Reset());
+		m_appGui->GetAppData()->FSceneAssets = FSceneAssetSummary();
+		m_appGui->GetAppData()->AttributeStats = FSceneAttributeSummary();
+		m_appGui->GetAppData()->TopN.clear();
+		m_appGui->GetAppData()->GroupBy.clear();
+		m_appGui->GetAppData()->Picked.clear();
+		m_appGui->GetAppData()->VisibleAttributeStats = FSceneAttributeSummary();
+		m_appGui->GetAppData()->ViewStats = FSceneViewStats();
+		m_numFSceneBoxes = 0;
 		
 		m_frameResource->ResizeBuffer<ObjectConstant>((UINT)m_allRitems.size());
 		m_frameResource->ResizeBuffer<StructureBuffer>((UINT)m_perFSceneCPUSBuffer.size());
+		UpdateRenderFootprint();
+		m_appGui->GetAppData()->bDataFootprintDirty = true;
+	}
+
+	// Memory Footprint.
+	if (m_appGui->GetAppData()->bDataFootprintDirty)
+	{
+		m_appGui->GetAppData()->bDataFootprintDirty = false;
+		UpdateDataFootprint();
+	}
+
+	// Instanced / baked FScene geometry.
+	if (m_appGui->GetAppData()->bFSceneGeometryDirty)
+	{
+		m_appGui->GetAppData()->bFSceneGeometryDirty = false;
+		RebuildFSceneGeometry();
+	}
+
+	// Outlines of the picked instances.
+	if (m_bPickedBoundsDirty)
+	{
+		m_bPickedBoundsDirty = false;
+		BuildFScenePickRenderItem();
+	}
+
+	// RT 0 capture, read back once the frame that copied it and the CPU raster job are done.
+	if (m_bRasterCapturePending && m_rasterCaptureJob.wait_for(std::chrono::seconds(0)) != std::future_status::timeout)
+	{
+		m_bRasterCapturePending = false;
+		ResolveRasterCapture();
 	}
 
 	// Find Max Pixel On the CPU side.
 	if (m_appGui->GetAppData()->bEnableCalcMax)
 	{		
-		Math::Vector4* mappedData = nullptr;
-		ThrowIfFailed(m_readBackBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mappedData)));
-		Math::Vector4 maxPixel = Math::Vector4(Math::EZeroTag::kZero);
-		for (int i = 0; i < m_height; ++i)
-		{
-			maxPixel = Math::Max(maxPixel, mappedData[i]);
-		}
-		m_appGui->GetAppData()->MaxPixel = maxPixel;
+		float* mappedData = nullptr;
+		ThrowIfFailed(m_readBackBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mappedData)));
+		// One float4 per row.
+		float maxPixel[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		ReduceUtil::Max4(mappedData, m_height, maxPixel);
+		m_appGui->GetAppData()->MaxPixel = Math::Vector4(maxPixel[0], maxPixel[1], maxPixel[2], maxPixel[3]);
 		m_readBackBuffer->Unmap(0, nullptr);
 	}
 
+	// Pixel space Auto Overflow, P99 of the pixels RGBPS draws (R of RT 0 above its 0.001 clip).
+	// The copy is read once its back buffer comes round again, MoveToNextFrame has then waited for it.
+	if (m_bPixelReadBackPending && m_deviceResources->GetCurrentFrameIndex() == m_pixelReadBackFrame)
+	{
+		m_bPixelReadBackPending = false;
+		const UINT width = m_pixelReadBackLayout.Footprint.Width, height = m_pixelReadBackLayout.Footprint.Height;
+		m_pixelValues.resize((size_t)width * height);
+		uint8* mappedData = nullptr;
+		ThrowIfFailed(m_pixelReadBackBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mappedData)));
+		for (UINT row = 0; row < height; ++row)
+		{
+			const float* source = reinterpret_cast<const float*>(mappedData + m_pixelReadBackLayout.Offset + (size_t)row * m_pixelReadBackLayout.Footprint.RowPitch);
+			float* target = m_pixelValues.data() + (size_t)row * width;
+			for (UINT col = 0; col < width; ++col)
+				target[col] = source[col * 4];
+		}
+		m_pixelReadBackBuffer->Unmap(0, nullptr);
+
+		float p99 = ReduceUtil::Percentile(m_pixelValues.data(), m_pixelValues.size(), 0.99f, 0.001f);
+		if (m_appGui->GetAppData()->bAutoOverflowPixels && p99 > 0.0f)
+			m_appGui->GetAppData()->Overflow = p99;
+	}
+
 	// Update Camera & Frame Resource.
 	{
 		// Set Camera View Type.
@@ -249,257 +349,156 @@ void AppEntry::Update(const StepTimer& timer)
 			}			
 		}
 
+		// PerObject Constant Buffer (Selected), same space as the FScene boxes.
+		for (auto& ri : m_renderItemLayer[RenderLayer::Selected])
+		{
+			ObjectConstant objectConstant;
+			objectConstant.World = Matrix4(AffineTransform::MakeScale(m_appGui->GetAppData()->FSceneScale));
+			m_frameResource->CopyData<ObjectConstant>(ri->ObjectCBufferIndex, objectConstant);
+		}
+
+		// Custom attribute, recompiled while no evaluation runs.
+		if (m_appGui->GetAppData()->bCustomExpressionDirty && !m_fSceneSBufferJob.valid())
+		{
+			AppData* appData = m_appGui->GetAppData();
+			appData->bCustomExpressionDirty = false;
+			std::string error;
+			if (m_attributeEngine.RegisterExpression(VA_Custom, appData->CustomExpression, error))
+			{
+				m_attributeCache.InvalidateAttribute(VA_Custom);
+				if (appData->_EVisualizationAttribute == VA_Custom)
+					appData->bVisualizationAttributeDirty = true;
+			}
+			appData->CustomExpressionError = error;
+		}
+
+		// Compared LOD, the LOD columns were joined at import.
+		if (m_appGui->GetAppData()->bCompareLODDirty && !m_fSceneSBufferJob.valid())
+		{
+			AppData* appData = m_appGui->GetAppData();
+			appData->bCompareLODDirty = false;
+			appData->CompareLOD = (std::max)(appData->CompareLOD, 1);
+			if (m_attributeEngine.GetCompareLOD() != appData->CompareLOD)
+			{
+				m_attributeEngine.SetCompareLOD(appData->CompareLOD);
+				m_attributeCache.InvalidateAttribute(VA_LOD_Triangle_Ratio);
+				m_attributeCache.InvalidateAttribute(VA_LOD_Vertex_Delta);
+				m_attributeCache.InvalidateAttribute(VA_LOD_Material_Delta);
+				if (appData->_EVisualizationAttribute >= VA_LOD_Triangle_Ratio && appData->_EVisualizationAttribute <= VA_LOD_Material_Delta)
+					appData->bVisualizationAttributeDirty = true;
+			}
+		}
+
+		// Texture attribution, only the VA_CurrentKB columns are recomputed.
+		if (m_appGui->GetAppData()->bTextureAttributionDirty && !m_fSceneSBufferJob.valid())
+		{
+			AppData* appData = m_appGui->GetAppData();
+			appData->bTextureAttributionDirty = false;
+			if (m_attributeEngine.GetTextureAttribution() != appData->_ETextureAttribution)
+			{
+				m_attributeEngine.SetTextureAttribution(appData->_ETextureAttribution);
+				m_attributeCache.InvalidateAttribute(VA_CurrentKB);
+				if (appData->_EVisualizationAttribute == VA_CurrentKB)
+					appData->bVisualizationAttributeDirty = true;
+			}
+		}
+
 		// Structure Buffer (Visualization Attribute Logic).
-		if (!m_allFSceneDataSets.empty())
+		// An attribute change makes every segment stale, a new scene only its own.
+		if (m_appGui->GetAppData()->bVisualizationAttributeDirty)
+		{
+			m_appGui->GetAppData()->bVisualizationAttributeDirty = false;
+			for (auto& segment : m_fSceneSBufferSegments)
+				segment.bStale = true;
+		}
+
+		// One job at a time, a change made meanwhile is picked up once it is done.
+		if (!m_fSceneSBufferJob.valid())
+			EvaluateFSceneSBuffer(m_appGui->GetAppData()->bAsyncAttributeEvaluation);
+
+		// Async jobs keep the previous colours on screen until they are ready.
+		if (m_fSceneSBufferJob.valid() && m_fSceneSBufferJob.wait_for(std::chrono::seconds(0)) != std::future_status::timeout)
 		{
-			if (m_appGui->GetAppData()->bVisualizationAttributeDirty)
+			FSceneSBufferResult result = m_fSceneSBufferJob.get();
+
+			// Scenes cleared while the job ran, drop the columns it cached for them.
+			for (uint32 sceneId : result.StatsSceneIds)
 			{
-				m_appGui->GetAppData()->bVisualizationAttributeDirty = false;
-				m_perFSceneCPUSBuffer.clear();
-				for (auto& fSceneDataSet : m_allFSceneDataSets)
-				{
-#pragma region LocalUsefulDefine
-#define SetColorX(x, y) case VA_##y: colorX = (float)x.y; break;
-#define SetColorXCaseMatProp(x, y, z) \
-{ \
-	case x: \
-	{ \
-		for (auto& matID : y.UsedMaterialsIndices) \
-			colorX += (float)fSceneDataSet.MaterialsTable[matID].z; \
-		for (auto& matInsID : y.UsedMaterialIntancesIndices) \
-			colorX += (float)fSceneDataSet.MaterialsTable[fSceneDataSet.MaterialInstancesTable[matInsID].ParentIndex].z; \
-	} \
-	break; \
-}
-#define SetColorXCaseMatPropString(x, y, z) \
-{ \
-	case x: \
-	{ \
-		for (auto& matID : y.UsedMaterialsIndices) \
-		{ \
-			colorX += StringUtil::WStringToNumeric<float>( \
-				fSceneDataSet.MaterialsTable[matID].z); \
-		} \
-		for (auto& matInsID : y.UsedMaterialIntancesIndices) \
-		{ \
-			colorX += StringUtil::WStringToNumeric<float>( \
-				fSceneDataSet.MaterialsTable[fSceneDataSet.MaterialInstancesTable[matInsID].ParentIndex].z); \
-		} \
-	} \
-	break; \
-}
-#define SetColorXCaseMatPropStringGetBetween(x, y, z, b1, b2) \
-{ \
-	case x: \
-	{ \
-		for (auto& matID : y.UsedMaterialsIndices) \
-		{ \
-			colorX += StringUtil::WStringToNumeric<float>( \
-				StringUtil::WGetBetween(fSceneDataSet.MaterialsTable[matID].z, b1, b2).front()); \
-		} \
-		for (auto& matInsID : y.UsedMaterialIntancesIndices) \
-		{ \
-			colorX += StringUtil::WStringToNumeric<float>( \
-				StringUtil::WGetBetween(fSceneDataSet.MaterialsTable[fSceneDataSet.MaterialInstancesTable[matInsID].ParentIndex].z, b1, b2).front()); \
-		} \
-	} \
-	break; \
-}
-#pragma endregion
-					for (auto& staticMesh : fSceneDataSet.StaticMeshesTable)
-					{
-						for (int i = 0; i < staticMesh.BoundsIndices.size(); ++i)
-						{
-							// Fill Per FScene CPU Structure Buffer.
-							float colorX = 0.0f;
-
-							// Calculate the unique texture data for StaticMesh.
-							std::map<int32, int32> uniqueTexIDs;
-							{
-								for (auto& matID : staticMesh.UsedMaterialsIndices)
-								{
-									for (auto& texID : fSceneDataSet.MaterialsTable[matID].UsedTexturesIndices)
-									{
-										uniqueTexIDs.emplace(fSceneDataSet.TexturesTable[texID].UniqueId, texID);
-									}
-								}
-								for (auto& matInsID : staticMesh.UsedMaterialIntancesIndices)
-								{
-									for (auto& texID : fSceneDataSet.MaterialInstancesTable[matInsID].UsedTexturesIndices)
-									{
-										uniqueTexIDs.emplace(fSceneDataSet.TexturesTable[texID].UniqueId, texID);
-									}
-								}
-							}
-							
-							// Calculate the specific property for StaticMesh.
-							switch (m_appGui->GetAppData()->_EVisualizationAttribute)
-							{
-
-#define SMSetColorX(x) SetColorX(staticMesh, x)
-#define SMSetColorXCaseMatProp(x, y) SetColorXCaseMatProp(x, staticMesh, y)
-#define SMSetColorXCaseMatPropString(x, y) SetColorXCaseMatPropString(x, staticMesh, y)
-#define SMSetColorXCaseMatPropStringGetBetween(x, y, b1, b2) SetColorXCaseMatPropStringGetBetween(x, staticMesh, y, b1, b2)
-
-							case VA_NumActors: colorX = 1.0f; break;
-
-								SMSetColorX(NumVertices);
-								SMSetColorX(NumTriangles);
-								SMSetColorX(NumInstances);
-								SMSetColorX(NumLODs);
-							case VA_NumMaterials:
-								colorX = (float)(staticMesh.UsedMaterialsIndices.size() + staticMesh.UsedMaterialIntancesIndices.size());
-								break;
-							case VA_NumTextures:
-								colorX = (float)uniqueTexIDs.size();
-								break;
-							case VA_CurrentKB:
-								for (auto& texID : uniqueTexIDs)
-									colorX += fSceneDataSet.TexturesTable[texID.second].CurrentKB;
-								break;
-
-								SMSetColorXCaseMatProp(VA_UniformBufferSize, UniformBufferSize);
-								SMSetColorXCaseMatProp(VA_NumUniformBufferMembers, NumUniformBufferMembers);
-								SMSetColorXCaseMatProp(VA_Stats_Base_Pass_Shader_Instructions, BPSCount);
-								SMSetColorXCaseMatProp(VA_Stats_Base_Pass_Shader_With_Surface_Lightmap, BPSSurfaceLightmap);
-								SMSetColorXCaseMatProp(VA_Stats_Base_Pass_Shader_With_Volumetric_Lightmap, BPSVolumetricLightmap);
-								SMSetColorXCaseMatProp(VA_Stats_Base_Pass_Vertex_Shader, BPSVertex);
-
-								SMSetColorXCaseMatPropStringGetBetween(VA_Stats_Texture_Samplers, TexSamplers, L"_", L"/16");
-								SMSetColorXCaseMatPropStringGetBetween(VA_Stats_User_Interpolators_Scalars, UserInterpolators, L"", L"/");
-								SMSetColorXCaseMatPropStringGetBetween(VA_Stats_User_Interpolators_Vectors, UserInterpolators, L"(", L"/4 Vectors");
-								SMSetColorXCaseMatPropStringGetBetween(VA_Stats_User_Interpolators_TexCoords, UserInterpolators, L"TexCoords: ", L",");
-								SMSetColorXCaseMatPropStringGetBetween(VA_Stats_User_Interpolators_Custom, UserInterpolators, L"Custom: ", L")");
-								SMSetColorXCaseMatPropStringGetBetween(VA_Stats_Texture_Lookups_VS, TexLookups, L"VS(", L")");
-								SMSetColorXCaseMatPropStringGetBetween(VA_Stats_Texture_Lookups_PS, TexLookups, L"PS(", L")");
-								
-								SMSetColorXCaseMatPropString(VA_Stats_Virtual_Texture_Lookups, VTLookups);
-
-								SMSetColorXCaseMatProp(VA_Material_Two_Sided, TwoSided);
-								SMSetColorXCaseMatProp(VA_Material_Cast_Ray_Traced_Shadows, bCastRayTracedShadows);
-								SMSetColorXCaseMatProp(VA_Translucency_Screen_Space_Reflections, bScreenSpaceReflections);
-								SMSetColorXCaseMatProp(VA_Translucency_Contact_Shadows , bContactShadows);
-								SMSetColorXCaseMatProp(VA_Translucency_Directional_Lighting_Intensity, TranslucencyDirectionalLightingIntensity);
-								SMSetColorXCaseMatProp(VA_Translucency_Apply_Fogging, bUseTranslucencyVertexFog);
-								SMSetColorXCaseMatProp(VA_Translucency_Compute_Fog_Per_Pixel, bComputeFogPerPixel);
-								SMSetColorXCaseMatProp(VA_Translucency_Output_Velocity, bOutputTranslucentVelocity);
-								SMSetColorXCaseMatProp(VA_Translucency_Render_After_DOF, bEnableSeparateTranslucency);
-								SMSetColorXCaseMatProp(VA_Translucency_Responsive_AA, bEnableResponsiveAA);
-								SMSetColorXCaseMatProp(VA_Translucency_Mobile_Separate_Translucency, bEnableMobileSeparateTranslucency);
-								SMSetColorXCaseMatProp(VA_Translucency_Disable_Depth_Test, bDisableDepthTest);
-								SMSetColorXCaseMatProp(VA_Translucency_Write_Only_Alpha, bWriteOnlyAlpha);
-								SMSetColorXCaseMatProp(VA_Translucency_Allow_Custom_Depth_Writes, AllowTranslucentCustomDepthWrites);
-								SMSetColorXCaseMatProp(VA_Mobile_Use_Full_Precision, bUseFullPrecision);
-								SMSetColorXCaseMatProp(VA_Mobile_Use_Lightmap_Directionality, bUseLightmapDirectionality);
-								SMSetColorXCaseMatProp(VA_Forward_Shading_High_Quality_Reflections, bUseHQForwardReflections);
-								SMSetColorXCaseMatProp(VA_Forward_Shading_Planar_Reflections, bUsePlanarForwardReflections);
-							default:
-								break;
-							}
-							StructureBuffer sBuffer;
-							sBuffer.Color = Vector4(colorX, colorX, colorX, 1.0f);
-							m_perFSceneCPUSBuffer.push_back(sBuffer);
-						}						
-					}
-					
-					for (auto& skeletalMesh : fSceneDataSet.SkeletalMeshesTable)
-					{
-						// Fill Per FScene CPU Structure Buffer.
-						float colorX = 0.0f;
-
-						// Calculate the unique texture data for SkeletalMesh.
-						std::map<int32, int32> uniqueTexIDs;
-						{
-							for (auto& matID : skeletalMesh.UsedMaterialsIndices)
-							{
-								for (auto& texID : fSceneDataSet.MaterialsTable[matID].UsedTexturesIndices)
-								{
-									uniqueTexIDs.emplace(fSceneDataSet.TexturesTable[texID].UniqueId, texID);
-								}
-							}
-							for (auto& matInsID : skeletalMesh.UsedMaterialIntancesIndices)
-							{
-								for (auto& texID : fSceneDataSet.MaterialInstancesTable[matInsID].UsedTexturesIndices)
-								{
-									uniqueTexIDs.emplace(fSceneDataSet.TexturesTable[texID].UniqueId, texID);
-								}
-							}
-						}
-
-						// Calculate the specific property for SkeletalMesh.
-						switch (m_appGui->GetAppData()->_EVisualizationAttribute)
-						{
-
-#define SKSetColorX(x) SetColorX(skeletalMesh, x)
-#define SKSetColorXCaseMatProp(x, y) SetColorXCaseMatProp(x, skeletalMesh, y)
-#define SKSetColorXCaseMatPropString(x, y) SetColorXCaseMatPropString(x, skeletalMesh, y)
-#define SKSetColorXCaseMatPropStringGetBetween(x, y, b1, b2) SetColorXCaseMatPropStringGetBetween(x, skeletalMesh, y, b1, b2)
-
-						case VA_NumActors: colorX = 1.0f; break;
-
-							SKSetColorX(NumVertices);
-							SKSetColorX(NumTriangles);
-							SKSetColorX(NumLODs);
-						case VA_NumMaterials:
-							colorX = (float)(skeletalMesh.UsedMaterialsIndices.size() + skeletalMesh.UsedMaterialIntancesIndices.size());
-							break;
-						case VA_NumTextures:
-							colorX = (float)uniqueTexIDs.size();
-							break;
-						case VA_CurrentKB:
-							for (auto& texID : uniqueTexIDs)
-								colorX += fSceneDataSet.TexturesTable[texID.second].CurrentKB;
-							break;
-
-							SKSetColorXCaseMatProp(VA_UniformBufferSize, UniformBufferSize);
-							SKSetColorXCaseMatProp(VA_NumUniformBufferMembers, NumUniformBufferMembers);
-							SKSetColorXCaseMatProp(VA_Stats_Base_Pass_Shader_Instructions, BPSCount);
-							SKSetColorXCaseMatProp(VA_Stats_Base_Pass_Shader_With_Surface_Lightmap, BPSSurfaceLightmap);
-							SKSetColorXCaseMatProp(VA_Stats_Base_Pass_Shader_With_Volumetric_Lightmap, BPSVolumetricLightmap);
-							SKSetColorXCaseMatProp(VA_Stats_Base_Pass_Vertex_Shader, BPSVertex);
-
-							SKSetColorXCaseMatPropStringGetBetween(VA_Stats_Texture_Samplers, TexSamplers, L"_", L"/16");
-							SKSetColorXCaseMatPropStringGetBetween(VA_Stats_User_Interpolators_Scalars, UserInterpolators, L"", L"/");
-							SKSetColorXCaseMatPropStringGetBetween(VA_Stats_User_Interpolators_Vectors, UserInterpolators, L"(", L"/4 Vectors");
-							SKSetColorXCaseMatPropStringGetBetween(VA_Stats_User_Interpolators_TexCoords, UserInterpolators, L"TexCoords: ", L",");
-							SKSetColorXCaseMatPropStringGetBetween(VA_Stats_User_Interpolators_Custom, UserInterpolators, L"Custom: ", L")");
-							SKSetColorXCaseMatPropStringGetBetween(VA_Stats_Texture_Lookups_VS, TexLookups, L"VS(", L")");
-							SKSetColorXCaseMatPropStringGetBetween(VA_Stats_Texture_Lookups_PS, TexLookups, L"PS(", L")");
-
-							SKSetColorXCaseMatPropString(VA_Stats_Virtual_Texture_Lookups, VTLookups);
-
-							SKSetColorXCaseMatProp(VA_Material_Two_Sided, TwoSided);
-							SKSetColorXCaseMatProp(VA_Material_Cast_Ray_Traced_Shadows, bCastRayTracedShadows);
-							SKSetColorXCaseMatProp(VA_Translucency_Screen_Space_Reflections, bScreenSpaceReflections);
-							SKSetColorXCaseMatProp(VA_Translucency_Contact_Shadows, bContactShadows);
-							SKSetColorXCaseMatProp(VA_Translucency_Directional_Lighting_Intensity, TranslucencyDirectionalLightingIntensity);
-							SKSetColorXCaseMatProp(VA_Translucency_Apply_Fogging, bUseTranslucencyVertexFog);
-							SKSetColorXCaseMatProp(VA_Translucency_Compute_Fog_Per_Pixel, bComputeFogPerPixel);
-							SKSetColorXCaseMatProp(VA_Translucency_Output_Velocity, bOutputTranslucentVelocity);
-							SKSetColorXCaseMatProp(VA_Translucency_Render_After_DOF, bEnableSeparateTranslucency);
-							SKSetColorXCaseMatProp(VA_Translucency_Responsive_AA, bEnableResponsiveAA);
-							SKSetColorXCaseMatProp(VA_Translucency_Mobile_Separate_Translucency, bEnableMobileSeparateTranslucency);
-							SKSetColorXCaseMatProp(VA_Translucency_Disable_Depth_Test, bDisableDepthTest);
-							SKSetColorXCaseMatProp(VA_Translucency_Write_Only_Alpha, bWriteOnlyAlpha);
-							SKSetColorXCaseMatProp(VA_Translucency_Allow_Custom_Depth_Writes, AllowTranslucentCustomDepthWrites);
-							SKSetColorXCaseMatProp(VA_Mobile_Use_Full_Precision, bUseFullPrecision);
-							SKSetColorXCaseMatProp(VA_Mobile_Use_Lightmap_Directionality, bUseLightmapDirectionality);
-							SKSetColorXCaseMatProp(VA_Forward_Shading_High_Quality_Reflections, bUseHQForwardReflections);
-							SKSetColorXCaseMatProp(VA_Forward_Shading_Planar_Reflections, bUsePlanarForwardReflections);
-						default:
-							break;
-						}
-						StructureBuffer sBuffer;
-						sBuffer.Color = Vector4(colorX, colorX, colorX, 1.0f);
-						m_perFSceneCPUSBuffer.push_back(sBuffer);
-					}
-				}			
-				for (int i = 0; i < m_perFSceneCPUSBuffer.size(); ++i)
+				auto loaded = std::find_if(m_fSceneAttributeContexts.begin(), m_fSceneAttributeContexts.end(),
+					[sceneId](const std::shared_ptr<const FSceneAttributeContext>& context) { return context->SceneId == sceneId; });
+				if (loaded == m_fSceneAttributeContexts.end())
+					m_attributeCache.InvalidateScene(sceneId);
+			}
+
+			for (size_t i = 0; i < result.SceneIds.size(); ++i)
+			{
+				for (size_t s = 0; s < m_fSceneAttributeContexts.size(); ++s)
 				{
-					m_frameResource->CopyData<StructureBuffer>(i, m_perFSceneCPUSBuffer[i]);
+					if (m_fSceneAttributeContexts[s]->SceneId != result.SceneIds[i])
+						continue;
+					const FSceneSBufferSegment& segment = m_fSceneSBufferSegments[s];
+					std::copy(result.SBuffers[i].begin(), result.SBuffers[i].end(), m_perFSceneCPUSBuffer.begin() + segment.Offset);
+					UploadFSceneSBuffer(segment.Offset, segment.Count);
+					break;
 				}
 			}
-		}		
+
+			bool bSameScenes = result.StatsSceneIds.size() == m_fSceneAttributeContexts.size();
+			for (size_t s = 0; bSameScenes && s < m_fSceneAttributeContexts.size(); ++s)
+				bSameScenes = result.StatsSceneIds[s] == m_fSceneAttributeContexts[s]->SceneId;
+			if (bSameScenes)
+			{
+				AppData* appData = m_appGui->GetAppData();
+				appData->AttributeStats = result.Stats.GetSummary();
+				// Colour range from the distribution, a few outliers no longer wash out the rest.
+				if (appData->bAutoOverflow && !appData->bAutoOverflowPixels && appData->AttributeStats.Count > 0)
+					appData->Overflow = appData->AttributeStats.P99 > 0.0f ? appData->AttributeStats.P99 : (std::max)(appData->AttributeStats.Max, 1.0f);
+				appData->bTopNDirty = true;
+				m_bPickedValuesDirty = true;
+				m_bFSceneVisibleStatsDirty = true;
+			}
+			UpdateRenderFootprint();
+		}
+
+		// Queries read the evaluated columns, they wait for the job instead of evaluating on this thread.
+		// Top N query, on demand and whenever new colours land.
+		if (m_appGui->GetAppData()->bTopNDirty && !m_fSceneSBufferJob.valid())
+		{
+			m_appGui->GetAppData()->bTopNDirty = false;
+			UpdateFSceneTopN();
+		}
+
+		// Group by rollup, on demand.
+		if (m_appGui->GetAppData()->bGroupByDirty && !m_fSceneSBufferJob.valid())
+		{
+			AppData* appData = m_appGui->GetAppData();
+			appData->bGroupByDirty = false;
+
+			FSceneGroupByQuery query;
+			query.Source = appData->_EGroupBySource;
+			query.Key = appData->_EGroupByKey;
+			query.Aggregate = appData->_EGroupByAggregate;
+			query.Attribute = appData->_EVisualizationAttribute;
+			query.Field = appData->GroupByField;
+			FSceneGroupBy::Run(m_attributeEngine, query, m_allFSceneDataSets, m_fSceneAttributeContexts, appData->GroupBy, appData->GroupByError);
+		}
+
+		// Values of the picked instances the cache did not hold at pick time.
+		if (m_bPickedValuesDirty && !m_fSceneSBufferJob.valid())
+		{
+			m_bPickedValuesDirty = false;
+			AppData* appData = m_appGui->GetAppData();
+			for (auto& row : appData->Picked)
+				row.Value = m_attributeCache.GetColumn(m_attributeEngine, appData->_EVisualizationAttribute, *m_fSceneAttributeContexts[row.Scene])->Values[row.Slot];
+		}
+
+		// Visible set for this frame's camera, then the statistics of what is on screen.
+		UpdateFSceneVisibleSet();
+		if (m_bFSceneVisibleStatsDirty && m_appGui->GetAppData()->bVisibleAttributeStats && !m_fSceneSBufferJob.valid())
+		{
+			m_bFSceneVisibleStatsDirty = false;
+			UpdateFSceneVisibleStats();
+		}
 	}
 
     PIXEndEvent();
@@ -549,7 +548,7 @@ void AppEntry::Render()
 		{
 			// Drawing on the Offscreen RT.
 			commandList->SetGraphicsRootShaderResourceView(2, m_frameResource->GetBufferGPUVirtualAddress<StructureBuffer>());
-			commandList->SetPipelineState(m_PSOs["BoxBlendAdd"].Get());
+			commandList->SetPipelineState(m_fSceneGeometry == FG_Instanced ? m_PSOs["BoxInstancedBlendAdd"].Get() : m_PSOs["BoxBlendAdd"].Get());
 			commandList->OMSetRenderTargets(1, &m_deviceResources->GetOffscreenRenderTargetView(0), FALSE, nullptr);
 			commandList->ClearRenderTargetView(m_deviceResources->GetOffscreenRenderTargetView(0), 
 				DefaultClearValue::ColorRGBA, 0, nullptr);
@@ -565,6 +564,13 @@ void AppEntry::Render()
 				m_deviceResources->GetCbvSrvUavDescriptorSize());
 			commandList->SetGraphicsRootDescriptorTable(3, srvDescGPUHandle);
 
+			// RT 0 capture, the CPU rasterizer draws the same frame. A click during a capture waits for it.
+			if (m_appGui->GetAppData()->bRasterCaptureDirty && !m_bRasterCapturePending)
+			{
+				m_appGui->GetAppData()->bRasterCaptureDirty = false;
+				CaptureOffscreenTarget();
+			}
+
 			// Find Max Pixel On the GPU side.
 			if (m_appGui->GetAppData()->bEnableCalcMax)
 			{
@@ -586,6 +592,15 @@ void AppEntry::Render()
 					D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
 			}
 
+			// RT 0 for the pixel space Auto Overflow, every PixelOverflowInterval frames, one copy in flight at most.
+			if (m_appGui->GetAppData()->bAutoOverflowPixels && !m_bPixelReadBackPending)
+			{
+				if (m_pixelOverflowCountdown > 0)
+					--m_pixelOverflowCountdown;
+				else
+					CopyPixelReadBack();
+			}
+
 			// Switch to different Color Mode.
 			switch (m_appGui->GetAppData()->_EVisualizationColorMode)
 			{
@@ -609,6 +624,13 @@ void AppEntry::Render()
 				m_deviceResources->GetOffscreenRenderTarget(0),
 				D3D12_RESOURCE_STATE_GENERIC_READ,
 				D3D12_RESOURCE_STATE_RENDER_TARGET));
+
+			// Picked instances, outlined over the composited boxes.
+			if (m_appGui->GetAppData()->bShowPickBounds)
+			{
+				commandList->SetPipelineState(m_PSOs["Line"].Get());
+				DrawRenderItem(m_renderItemLayer[RenderLayer::Selected]);
+			}
 		}						
 	}
 
@@ -715,13 +737,26 @@ void AppEntry::OnMouseDown(WPARAM btnState, int x, int y)
 		
 		SetCapture(m_window);		
 	}
+
+	m_bPickPending = btnState == MK_LBUTTON;
+	m_pickMousePos.x = x;
+	m_pickMousePos.y = y;
 }
 
 void AppEntry::OnMouseUp(WPARAM btnState, int x, int y)
 {
 	if (m_bMousePosInBlockArea)
+	{
+		m_bPickPending = false;
 		return;
+	}
 	ReleaseCapture();
+
+	if (m_bPickPending)
+	{
+		m_bPickPending = false;
+		PickFSceneInstances(x, y);
+	}
 }
 
 void AppEntry::OnMouseMove(WPARAM btnState, int x, int y)
@@ -733,6 +768,10 @@ void AppEntry::OnMouseMove(WPARAM btnState, int x, int y)
 	if (m_bMouseDownInBlockArea)
 		return;
 
+	// Dragging rotates, it is not a click.
+	if (m_bPickPending && (std::abs(x - m_pickMousePos.x) > 2 || std::abs(y - m_pickMousePos.y) > 2))
+		m_bPickPending = false;
+
 	if (btnState == MK_LBUTTON || btnState == MK_MBUTTON)
 	{
 		// Make each pixel correspond to a quarter of a degree.
@@ -886,6 +925,8 @@ void AppEntry::CreateWindowSizeDependentResources()
 		D3D12_RESOURCE_STATE_COPY_DEST,
 		nullptr,
 		IID_PPV_ARGS(&m_readBackBuffer)));
+	m_pixelReadBackBuffer.Reset();
+	m_bPixelReadBackPending = false;
 }
 
 void AppEntry::BuildDescriptorHeaps()
@@ -936,6 +977,7 @@ void AppEntry::BuildShadersAndInputLayout()
 	m_shaderByteCode["PS"] = AppUtil::CompileShader(m_appPath + L"Shaders/common.hlsl", nullptr, "PS", "ps_5_0");
 
 	m_shaderByteCode["BoxVS"] = AppUtil::CompileShader(m_appPath + L"Shaders/common.hlsl", nullptr, "BoxVS", "vs_5_0");
+	m_shaderByteCode["BoxInstancedVS"] = AppUtil::CompileShader(m_appPath + L"Shaders/common.hlsl", nullptr, "BoxInstancedVS", "vs_5_0");
 
 	m_shaderByteCode["FullSQuadVS"] = AppUtil::CompileShader(m_appPath + L"Shaders/fullscreenquad.hlsl", nullptr, "VS", "vs_5_0");
 	m_shaderByteCode["FullSQuadPS"] = AppUtil::CompileShader(m_appPath + L"Shaders/fullscreenquad.hlsl", nullptr, "PS", "ps_5_0");
@@ -948,6 +990,16 @@ void AppEntry::BuildShadersAndInputLayout()
 		{ "POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
 		{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
 	};
+
+	// FSceneBoxInstance.
+	m_boxInstancedInputLayout =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "BOXCENTER", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+		{ "BOXEXTENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 12, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+		{ "BOXSLOT", 0, DXGI_FORMAT_R32_UINT, 1, 24, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 }
+	};
 }
 
 void AppEntry::BuildLineGridGeometry()
@@ -968,60 +1020,690 @@ void AppEntry::BuildLineGridGeometry()
 
 void AppEntry::BuildFSceneRenderItems(const FSceneDataSet* currentFSceneDataSet)
 {
-	MeshData<ColorVertex> boxMesh = GeometryCreator::CreateDefaultBox();
-	MeshData<ColorVertex> fSceneMesh;
-	int perFSceneBoxCount = 0; // bounds to box.
+	auto fSceneRItem = std::make_unique<RenderItem>();
+	fSceneRItem->Name = "box" + std::to_string(fSceneRItem->ObjectCBufferIndex);
+	fSceneRItem->World = Matrix4(AffineTransform::MakeScale(m_appGui->GetAppData()->FSceneScale));
+	fSceneRItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	fSceneRItem->PerFSceneSBufferOffset = (int)m_numFSceneBoxes;
+
+	CreateFSceneGeometry(fSceneRItem.get(), *currentFSceneDataSet);
+
+	m_renderItemLayer[RenderLayer::FScene].push_back(fSceneRItem.get());
+	m_allRitems.push_back(std::move(fSceneRItem));
+}
+
+void AppEntry::CreateFSceneGeometry(RenderItem* ri, const FSceneDataSet& dataSet)
+{
+	std::vector<FSceneBoxInstance> instances;
+	FSceneBoxGeometry::BuildInstances(dataSet, instances);
+
+	// 8 corners and 36 32 bit indices per box, written in place on all the cores.
+	if (m_fSceneGeometry == FG_Baked)
+	{
+		const float white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		ri->CreateCommonGeometry<ColorVertex, uint32>(m_deviceResources.get(), ri->Name,
+			instances.size() * FSceneBoxGeometry::NumCorners, instances.size() * FSceneBoxGeometry::NumIndices,
+			[&](ColorVertex* vertices, uint32* indices)
+		{
+			FSceneBoxGeometry::WriteBakedBoxes(instances.data(), instances.size(), reinterpret_cast<uint8*>(vertices), sizeof(ColorVertex), indices, white);
+		});
+		return;
+	}
+
+	// One unit box, one instance per box.
+	std::vector<ColorVertex> unitCorners(FSceneBoxGeometry::NumCorners);
+	for (uint32 corner = 0; corner < FSceneBoxGeometry::NumCorners; ++corner)
+	{
+		const float* position = FSceneBoxGeometry::UnitCorners[corner];
+		unitCorners[corner] = { Vector3(position[0], position[1], position[2]), Vector4(1.0f, 1.0f, 1.0f, 1.0f) };
+	}
+	std::vector<uint16> unitIndices(FSceneBoxGeometry::UnitIndices, FSceneBoxGeometry::UnitIndices + FSceneBoxGeometry::NumIndices);
+
+	ri->CreateCommonGeometry<ColorVertex, uint16>(m_deviceResources.get(), ri->Name, unitCorners, unitIndices);
+	ri->CreateInstanceStream(m_deviceResources.get(), instances);
+}
+
+void AppEntry::RebuildFSceneGeometry()
+{
+	m_fSceneGeometry = m_appGui->GetAppData()->_EFSceneGeometry;
+	if (m_renderItemLayer[RenderLayer::FScene].empty())
+		return;
+
+	// The old buffers may still be in flight. One render item per scene, in import order.
+	m_deviceResources->WaitForGpu();
+	m_deviceResources->ExecuteCommandLists([&]()
+	{
+		for (size_t scene = 0; scene < m_renderItemLayer[RenderLayer::FScene].size(); ++scene)
+		{
+			RenderItem* ri = m_renderItemLayer[RenderLayer::FScene][scene];
+			ri->bDrawCulled = false;
+			CreateFSceneGeometry(ri, *m_allFSceneDataSets[scene]);
+		}
+	});
+
+	// The culled draws address the old geometry.
+	m_appGui->GetAppData()->bVisibleSetDirty = true;
+	UpdateRenderFootprint();
+}
+
+void AppEntry::UpdateRenderFootprint()
+{
+	RenderFootprint footprint;
+
+	for (auto& ri : m_renderItemLayer[RenderLayer::FScene])
+	{
+		if (ri->Geometry == nullptr)
+			continue;
+
+		auto& geometry = ri->Geometry;
+		footprint.NumRenderItems++;
+		footprint.VertexBufferBytes += geometry->VertexBufferByteSize;
+		footprint.IndexBufferBytes += geometry->IndexBufferByteSize;
+		footprint.InstanceBufferBytes += geometry->InstanceBufferByteSize;
+		if (geometry->VertexBufferUploader != nullptr)
+			footprint.UploaderBytes += geometry->VertexBufferByteSize;
+		if (geometry->IndexBufferUploader != nullptr)
+			footprint.UploaderBytes += geometry->IndexBufferByteSize;
+		if (geometry->InstanceBufferUploader != nullptr)
+			footprint.UploaderBytes += geometry->InstanceBufferByteSize;
+		if (geometry->VertexBufferCPU != nullptr)
+			footprint.CPUGeometryBytes += geometry->VertexBufferCPU->GetBufferSize();
+		if (geometry->IndexBufferCPU != nullptr)
+			footprint.CPUGeometryBytes += geometry->IndexBufferCPU->GetBufferSize();
+		if (geometry->InstanceBufferCPU != nullptr)
+			footprint.CPUGeometryBytes += geometry->InstanceBufferCPU->GetBufferSize();
+	}
+
+	footprint.NumBoxes = m_numFSceneBoxes;
+	footprint.StructureBufferBytes = m_fSceneSBufferCapacity * sizeof(StructureBuffer);
+	footprint.CPUStructureBufferBytes = m_perFSceneCPUSBuffer.capacity() * sizeof(StructureBuffer);
+
+	m_appGui->GetAppData()->FSceneRenderFootprint = footprint;
+}
+
+void AppEntry::UpdateDataFootprint()
+{
+	// Every loaded scene, then the LOD1..N the importer still holds for the last import.
+	std::vector<const FSceneDataSet*> dataSets;
+	std::vector<std::string> names;
+	for (size_t i = 0; i < m_allFSceneDataSets.size(); ++i)
+	{
+		dataSets.push_back(m_allFSceneDataSets[i].get());
+		names.push_back("Scene" + std::to_string(i));
+	}
+	if (m_appGui->CheckImporterLock())
+	{
+		for (int lod = 1; lod < m_appGui->GetImporterData()->GetLODCount(); ++lod)
+		{
+			dataSets.push_back(m_appGui->GetImporterData()->GetFSceneData(lod));
+			names.push_back("LastImport LOD" + std::to_string(lod));
+		}
+	}
+
+	std::vector<FSceneDataFootprint> footprints(dataSets.size());
+	ThreadUtil::ParallelFor(dataSets.size(), [&](size_t i, uint32)
+	{
+		footprints[i] = FSceneFootprintUtil::Calculate(*dataSets[i]);
+		footprints[i].Name = names[i];
+	});
+
+	if (m_assetRegistry.GetSceneCount() > 0)
+		footprints.push_back(m_assetRegistry.GetFootprint());
+
+	m_appGui->SetFootprints(std::move(footprints));
+}
+
+void AppEntry::UpdateFSceneTopN()
+{
+	AppData* appData = m_appGui->GetAppData();
+	uint32 n = (uint32)(std::min)((std::max)(appData->TopNCount, 1), (int)FSceneAttributeQuery::MaxTopN);
+	EVisualizationAttribute attribute = appData->_EVisualizationAttribute;
+
+	std::vector<FSceneQueryHit> hits;
+	if (appData->bTopNInstances)
+	{
+		// The columns stay alive while the query reads them, even if the cache drops them.
+		std::vector<FSceneAttributeColumnPtr> columns;
+		std::vector<const TArray<float>*> values;
+		for (auto& context : m_fSceneAttributeContexts)
+		{
+			columns.push_back(m_attributeCache.GetColumn(m_attributeEngine, attribute, *context));
+			values.push_back(&columns.back()->Values);
+		}
+		hits = FSceneAttributeQuery::TopInstances(m_fSceneAttributeContexts, values, n);
+	}
+	else hits = FSceneAttributeQuery::TopMeshes(m_attributeEngine, attribute, m_fSceneAttributeContexts, n);
+
+	appData->TopN.clear();
+	for (auto& hit : hits)
+	{
+		const FSceneDataSet& dataSet = *m_allFSceneDataSets[hit.Scene];
+		const FSceneAttributeContext& context = *m_fSceneAttributeContexts[hit.Scene];
+
+		FSceneTopNRow row;
+		auto setNames = [&row](const auto& mesh)
+		{
+			row.Name = StringUtil::WStringToString(mesh.Name);
+			row.OwnerName = StringUtil::WStringToString(mesh.OwnerName);
+			row.AssetPath = StringUtil::WStringToString(mesh.AssetPath);
+		};
+		if (hit.Mesh < context.NumStaticMeshes)
+			setNames(dataSet.StaticMeshesTable[hit.Mesh]);
+		else setNames(dataSet.SkeletalMeshesTable[hit.Mesh - context.NumStaticMeshes]);
+		row.Instance = hit.Instance < 0 ? -1 : hit.Instance - context.InstanceOffsets[hit.Mesh];
+		row.Value = hit.Value;
+		appData->TopN.push_back(row);
+	}
+}
+
+void AppEntry::PickFSceneInstances(int x, int y)
+{
+	AppData* appData = m_appGui->GetAppData();
+	appData->Picked.clear();
+	m_pickedBounds.clear();
+	m_bPickedBoundsDirty = true;
+	if (m_fSceneSpatialIndices.empty() || m_width <= 0 || m_height <= 0 || appData->FSceneScale <= 0.0f)
+		return;
 
-	for (auto& staticMesh : currentFSceneDataSet->StaticMeshesTable)
+	// Cursor on the near and far planes, then back to render space (the FScene items are scaled by FSceneScale).
+	float ndcX = 2.0f * (float)x / (float)m_width - 1.0f;
+	float ndcY = 1.0f - 2.0f * (float)y / (float)m_height;
+	XMMATRIX invViewProj = XMMatrixInverse(nullptr, m_camera.GetViewProj());
+	XMVECTOR nearPoint = XMVector3TransformCoord(XMVectorSet(ndcX, ndcY, 0.0f, 1.0f), invViewProj);
+	XMVECTOR farPoint = XMVector3TransformCoord(XMVectorSet(ndcX, ndcY, 1.0f, 1.0f), invViewProj);
+	float invScale = 1.0f / appData->FSceneScale;
+	XMFLOAT3 origin, direction;
+	XMStoreFloat3(&origin, XMVectorScale(nearPoint, invScale));
+	XMStoreFloat3(&direction, XMVector3Normalize(XMVectorSubtract(farPoint, nearPoint)));
+	float length = XMVectorGetX(XMVector3Length(XMVectorSubtract(farPoint, nearPoint))) * invScale;
+
+	// The nearest hits of every scene, then the nearest of all.
+	struct FScenePickHit
+	{
+		uint32 Scene;
+		BVHRayHit Hit;
+	};
+	const uint32 maxHits = (uint32)(std::min)((std::max)(appData->PickCount, 1), 64);
+	std::vector<BVHRayHit> sceneHits(maxHits);
+	std::vector<FScenePickHit> hits;
+	for (uint32 scene = 0; scene < (uint32)m_fSceneSpatialIndices.size(); ++scene)
 	{
-		for (auto& boundsIndex : staticMesh.BoundsIndices)
+		uint32 numHits = m_fSceneSpatialIndices[scene]->GetBVH().RayCast(&origin.x, &direction.x, sceneHits.data(), maxHits, length);
+		for (uint32 i = 0; i < numHits; ++i)
+			hits.push_back({ scene, sceneHits[i] });
+	}
+	std::stable_sort(hits.begin(), hits.end(), [](const FScenePickHit& a, const FScenePickHit& b) { return a.Hit.T < b.Hit.T; });
+	if (hits.size() > maxHits)
+		hits.resize(maxHits);
+
+	for (auto& hit : hits)
+	{
+		const FSceneDataSet& dataSet = *m_allFSceneDataSets[hit.Scene];
+		const FSceneAttributeContext& context = *m_fSceneAttributeContexts[hit.Scene];
+		uint32 instance = hit.Hit.Primitive;
+		uint32 mesh = FSceneAttributeQuery::GetInstanceMesh(context, instance);
+
+		FScenePickRow row;
+		row.Scene = hit.Scene;
+		row.Instance = (int32)instance - context.InstanceOffsets[mesh];
+		row.Distance = hit.Hit.T;
+		row.Slot = instance;
+		// Cached columns only, a miss would evaluate here. Update fills it in once no job is evaluating.
+		FSceneAttributeColumnPtr column = m_attributeCache.FindColumn(context.SceneId, appData->_EVisualizationAttribute);
+		row.Value = column != nullptr ? column->Values[instance] : std::numeric_limits<float>::quiet_NaN();
+		m_bPickedValuesDirty |= column == nullptr;
+
+		auto setMesh = [&row, &dataSet](const auto& meshData)
 		{
-			BoxSphereBounds bounds = currentFSceneDataSet->BoundsTable[boundsIndex];
-			XMFLOAT3 corners[8]; int i = 0;
-			bounds.BoxBounds.GetCorners(corners);
-			for (auto& vertex : boxMesh.Vertices)
+			row.Name = StringUtil::WStringToString(meshData.Name);
+			row.OwnerName = StringUtil::WStringToString(meshData.OwnerName);
+			row.AssetPath = StringUtil::WStringToString(meshData.AssetPath);
+			row.NumVertices = meshData.NumVertices;
+			row.NumTriangles = meshData.NumTriangles;
+			row.NumLODs = meshData.NumLODs;
+			for (auto& index : meshData.UsedMaterialsIndices)
+				row.Materials.push_back(StringUtil::WStringToString(dataSet.MaterialsTable[index].Name));
+			for (auto& index : meshData.UsedMaterialIntancesIndices)
 			{
-				vertex.Pos = Vector3(corners[i++]);
-				vertex.Pos.RightHandToLeft();
-				fSceneMesh.Vertices.push_back(vertex);
+				const FSceneMaterialInstanceDataSet& materialInstance = dataSet.MaterialInstancesTable[index];
+				row.Materials.push_back(StringUtil::WStringToString(materialInstance.Name) + " (" +
+					StringUtil::WStringToString(materialInstance.ParentName) + ")");
 			}
-			for (auto& index : boxMesh.Indices32)
+		};
+		if (mesh < context.NumStaticMeshes)
+			setMesh(dataSet.StaticMeshesTable[mesh]);
+		else setMesh(dataSet.SkeletalMeshesTable[mesh - context.NumStaticMeshes]);
+
+		for (int32 k = context.TextureOffsets[mesh]; k < context.TextureOffsets[mesh + 1]; ++k)
+		{
+			const FSceneTextureDataSet& texture = dataSet.TexturesTable[context.Textures[k]];
+			char currentKB[32];
+			std::snprintf(currentKB, sizeof(currentKB), ", %.1f KB)", texture.CurrentKB);
+			row.Textures.push_back(StringUtil::WStringToString(texture.Name) + " (" + StringUtil::WStringToString(texture.CurrentSize) +
+				", " + StringUtil::WStringToString(texture.PixelFormat) + currentKB);
+		}
+
+		appData->Picked.push_back(row);
+		m_pickedBounds.push_back(hit.Hit.Bounds);
+	}
+}
+
+void AppEntry::BuildFScenePickRenderItem()
+{
+	m_renderItemLayer[RenderLayer::Selected].clear();
+	if (m_pickedBounds.empty())
+		return;
+
+	// 12 edges per box, corner bits are x, y, z. The nearest hit is yellow, the others orange.
+	static const uint16 BoxEdges[24] = { 0, 1, 1, 3, 3, 2, 2, 0, 4, 5, 5, 7, 7, 6, 6, 4, 0, 4, 1, 5, 2, 6, 3, 7 };
+	std::vector<ColorVertex> vertices;
+	std::vector<uint16> indices;
+	for (size_t box = 0; box < m_pickedBounds.size(); ++box)
+	{
+		const BVHBounds& bounds = m_pickedBounds[box];
+		uint16 first = (uint16)vertices.size();
+		ColorVertex vertex;
+		vertex.Color = box == 0 ? Vector4(1.0f, 0.9f, 0.0f, 1.0f) : Vector4(1.0f, 0.5f, 0.0f, 1.0f);
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			vertex.Pos = Vector3(
+				(corner & 1) ? bounds.Max[0] : bounds.Min[0],
+				(corner & 2) ? bounds.Max[1] : bounds.Min[1],
+				(corner & 4) ? bounds.Max[2] : bounds.Min[2]);
+			vertices.push_back(vertex);
+		}
+		for (auto& index : BoxEdges)
+			indices.push_back(first + index);
+	}
+
+	bool bNewItem = m_pickRItem == nullptr;
+	m_deviceResources->ExecuteCommandLists([&]()
+	{
+		m_deviceResources->WaitForGpu();
+		if (bNewItem)
+		{
+			auto pickRItem = std::make_unique<RenderItem>();
+			pickRItem->Name = "pick";
+			pickRItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_LINELIST;
+			m_pickRItem = pickRItem.get();
+			m_allRitems.push_back(std::move(pickRItem));
+		}
+		m_pickRItem->CreateCommonGeometry<ColorVertex, uint16>(m_deviceResources.get(), m_pickRItem->Name, vertices, indices);
+	});
+
+	// Above already Call to Wait for Gpu.
+	if (bNewItem)
+	{
+		m_frameResource->ResizeBuffer<ObjectConstant>((UINT)m_allRitems.size());
+		for (auto& ri : m_allRitems)
+			ri->bObjectDataChanged = true;
+	}
+	m_renderItemLayer[RenderLayer::Selected].push_back(m_pickRItem);
+}
+
+void AppEntry::UpdateFSceneVisibleSet()
+{
+	AppData* appData = m_appGui->GetAppData();
+
+	// The boxes are in render space, so is the frustum of their world view projection.
+	const float scale = appData->FSceneScale;
+	XMFLOAT4X4 viewProj;
+	XMStoreFloat4x4(&viewProj, XMMatrixMultiply(XMMatrixScaling(scale, scale, scale), m_camera.GetViewProj()));
+	if (std::memcmp(&viewProj, &m_fSceneCullViewProj, sizeof(viewProj)) != 0)
+	{
+		m_fSceneCullViewProj = viewProj;
+		appData->bVisibleSetDirty = true;
+	}
+	if (!appData->bVisibleSetDirty)
+		return;
+	appData->bVisibleSetDirty = false;
+
+	auto begin = std::chrono::high_resolution_clock::now();
+	FrustumCuller culler(Math::Frustum::FromViewProjection(Matrix4(XMLoadFloat4x4(&viewProj))));
+	FSceneViewStats stats;
+	std::vector<IndexRange> ranges;
+	m_fSceneVisibleSets.resize(m_fSceneSpatialIndices.size());
+	for (size_t scene = 0; scene < m_fSceneSpatialIndices.size(); ++scene)
+	{
+		// One FScene render item per scene, in import order.
+		RenderItem* ri = m_renderItemLayer[RenderLayer::FScene][scene];
+		const BoundsSoA& bounds = m_fSceneSpatialIndices[scene]->GetBounds();
+		std::vector<uint32>& visible = m_fSceneVisibleSets[scene];
+		stats.NumInstances += bounds.Size();
+
+		if (!appData->bFrustumCulling)
+		{
+			ri->bDrawCulled = false;
+			visible.clear();
+			stats.NumVisible += bounds.Size();
+			stats.NumDrawCalls++;
+			continue;
+		}
+
+		culler.CullIndices(bounds, visible);
+		stats.NumVisible += visible.size();
+
+		// Runs of visible boxes, as instance ranges or ranges of the baked geometry. The smallest gaps are drawn
+		// too past MaxFSceneDrawRanges.
+		CoalesceIndices(visible, MaxFSceneDrawRanges, ranges);
+		const bool bInstanced = ri->Geometry->InstanceBufferGPU != nullptr;
+		ri->CulledDrawArgs.assign(ranges.size(), SubmeshGeometry());
+		for (size_t i = 0; i < ranges.size(); ++i)
+		{
+			SubmeshGeometry& submesh = ri->CulledDrawArgs[i];
+			if (bInstanced)
 			{
-				fSceneMesh.Indices32.push_back(index + perFSceneBoxCount * 8);
+				submesh.IndexCountPerInstance = FSceneBoxIndexCount;
+				submesh.InstanceCount = ranges[i].Count;
+				submesh.StartInstanceLocation = ranges[i].First;
+				continue;
 			}
-			perFSceneBoxCount++;			
-		}		
+			submesh.IndexCountPerInstance = ranges[i].Count * FSceneBoxIndexCount;
+			submesh.StartIndexLocation = ranges[i].First * FSceneBoxIndexCount;
+		}
+		ri->bDrawCulled = true;
+		stats.NumDrawCalls += (uint32)ranges.size();
 	}
+	stats.CullMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count();
+
+	appData->ViewStats = stats;
+	m_bFSceneVisibleStatsDirty = true;
+}
 
-	for (auto& skeletalMesh : currentFSceneDataSet->SkeletalMeshesTable)
+void AppEntry::UpdateFSceneVisibleStats()
+{
+	AppData* appData = m_appGui->GetAppData();
+	const uint32 chunkSize = FrustumCuller::ChunkSize;
+
+	FSceneAttributeStats stats;
+	for (size_t scene = 0; scene < m_fSceneAttributeContexts.size(); ++scene)
 	{
-		BoxSphereBounds bounds = currentFSceneDataSet->BoundsTable[skeletalMesh.BoundsIndex];
-		XMFLOAT3 corners[8]; int i = 0;
-		bounds.BoxBounds.GetCorners(corners);
-		for (auto& vertex : boxMesh.Vertices)
+		FSceneAttributeColumnPtr column = m_attributeCache.GetColumn(m_attributeEngine, appData->_EVisualizationAttribute, *m_fSceneAttributeContexts[scene]);
+		if (!appData->bFrustumCulling || scene >= m_fSceneVisibleSets.size())
 		{
-			vertex.Pos = Vector3(corners[i++]);
-			vertex.Pos.RightHandToLeft();
-			fSceneMesh.Vertices.push_back(vertex);
+			stats.Merge(column->Stats);
+			continue;
 		}
-		for (auto& index : boxMesh.Indices32)
+
+		// Chunks of the visible slots on all the cores, their stats merge exactly.
+		const std::vector<uint32>& visible = m_fSceneVisibleSets[scene];
+		std::vector<FSceneAttributeStats> chunkStats((visible.size() + chunkSize - 1) / chunkSize);
+		ThreadUtil::ParallelFor(chunkStats.size(), [&](size_t chunk, uint32)
 		{
-			fSceneMesh.Indices32.push_back(index + perFSceneBoxCount * 8);
+			size_t end = (std::min)((chunk + 1) * chunkSize, visible.size());
+			for (size_t i = chunk * chunkSize; i < end; ++i)
+				chunkStats[chunk].Add(column->Values[visible[i]]);
+		});
+		for (auto& chunk : chunkStats)
+			stats.Merge(chunk);
+	}
+	appData->VisibleAttributeStats = stats.GetSummary();
+}
+
+void AppEntry::CopyPixelReadBack()
+{
+	auto commandList = m_deviceResources->GetCommandList();
+	ID3D12Resource* offscreenRT = m_deviceResources->GetOffscreenRenderTarget(0);
+
+	// Created on first use, only the users of the option pay for the RT sized readback.
+	if (m_pixelReadBackBuffer == nullptr)
+	{
+		auto device = m_deviceResources->GetD3DDevice();
+		D3D12_RESOURCE_DESC desc = offscreenRT->GetDesc();
+		UINT64 readbackBytes = 0;
+		device->GetCopyableFootprints(&desc, 0, 1, 0, &m_pixelReadBackLayout, nullptr, nullptr, &readbackBytes);
+		ThrowIfFailed(device->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+			D3D12_HEAP_FLAG_NONE,
+			&CD3DX12_RESOURCE_DESC::Buffer(readbackBytes),
+			D3D12_RESOURCE_STATE_COPY_DEST,
+			nullptr,
+			IID_PPV_ARGS(m_pixelReadBackBuffer.ReleaseAndGetAddressOf())));
+	}
+
+	// The RT is in GENERIC_READ here, which includes COPY_SOURCE.
+	CD3DX12_TEXTURE_COPY_LOCATION dst(m_pixelReadBackBuffer.Get(), m_pixelReadBackLayout);
+	CD3DX12_TEXTURE_COPY_LOCATION src(offscreenRT, 0);
+	commandList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+
+	m_pixelReadBackFrame = m_deviceResources->GetCurrentFrameIndex();
+	m_bPixelReadBackPending = true;
+	m_pixelOverflowCountdown = PixelOverflowInterval;
+}
+
+void AppEntry::CaptureOffscreenTarget()
+{
+	auto commandList = m_deviceResources->GetCommandList();
+	auto device = m_deviceResources->GetD3DDevice();
+	AppData* appData = m_appGui->GetAppData();
+	ID3D12Resource* offscreenRT = m_deviceResources->GetOffscreenRenderTarget(0);
+
+	// The RT is in GENERIC_READ here, which includes COPY_SOURCE.
+	D3D12_RESOURCE_DESC desc = offscreenRT->GetDesc();
+	UINT64 readbackBytes = 0;
+	device->GetCopyableFootprints(&desc, 0, 1, 0, &m_rasterCaptureLayout, nullptr, nullptr, &readbackBytes);
+	ThrowIfFailed(device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(readbackBytes),
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(m_rasterCaptureReadback.ReleaseAndGetAddressOf())));
+	CD3DX12_TEXTURE_COPY_LOCATION dst(m_rasterCaptureReadback.Get(), m_rasterCaptureLayout);
+	CD3DX12_TEXTURE_COPY_LOCATION src(offscreenRT, 0);
+	commandList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+
+	// Same geometry, structure buffer and constants as the BoxBlendAdd draws of this frame. The job holds its own
+	// references to the geometry blobs and a copy of the colours, the scenes may change before it is done.
+	// The previous capture stays on the panel until this one is resolved.
+	XMFLOAT4X4 world, viewProj;
+	float scale = appData->FSceneScale;
+	XMStoreFloat4x4(&world, XMMatrixScaling(scale, scale, scale));
+	XMStoreFloat4x4(&viewProj, m_camera.GetViewProj());
+
+	struct CaptureMesh
+	{
+		RasterMesh Mesh;
+		ComPtr<ID3DBlob> Vertices;
+		ComPtr<ID3DBlob> Indices;
+		ComPtr<ID3DBlob> Instances;
+		size_t NumInstances = 0;
+	};
+	std::vector<CaptureMesh> meshes;
+	for (auto& ri : m_renderItemLayer[RenderLayer::FScene])
+	{
+		if (ri->Geometry == nullptr || ri->Geometry->VertexBufferCPU == nullptr || ri->Geometry->IndexBufferCPU == nullptr)
+			continue;
+
+		const MeshGeometry& geometry = *ri->Geometry;
+		CaptureMesh capture;
+		if (geometry.InstanceBufferCPU != nullptr)
+		{
+			capture.Instances = geometry.InstanceBufferCPU;
+			capture.NumInstances = geometry.InstanceBufferByteSize / sizeof(FSceneBoxInstance);
+		}
+		else
+		{
+			capture.Vertices = geometry.VertexBufferCPU;
+			capture.Indices = geometry.IndexBufferCPU;
+			capture.Mesh.Vertices = reinterpret_cast<const uint8*>(geometry.VertexBufferCPU->GetBufferPointer());
+			capture.Mesh.VertexStride = geometry.VertexByteStride;
+			capture.Mesh.NumVertices = geometry.VertexBufferByteSize / geometry.VertexByteStride;
+			capture.Mesh.Indices = geometry.IndexBufferCPU->GetBufferPointer();
+			capture.Mesh.bIndices16 = geometry.IndexFormat == DXGI_FORMAT_R16_UINT;
+			capture.Mesh.NumIndices = geometry.IndexBufferByteSize / (capture.Mesh.bIndices16 ? 2 : 4);
+		}
+		capture.Mesh.ColorOffset = (uint32)ri->PerFSceneSBufferOffset;
+		meshes.push_back(capture);
+	}
+
+	const uint32 width = (uint32)desc.Width, height = desc.Height;
+	m_rasterCaptureJob = std::async(std::launch::async,
+		[meshes = std::move(meshes), colors = m_perFSceneCPUSBuffer, world, viewProj, width, height]() mutable
+	{
+		auto begin = std::chrono::high_resolution_clock::now();
+		SoftwareRasterizer rasterizer(width, height);
+		rasterizer.Clear(DefaultClearValue::ColorRGBA);
+		std::vector<float> bakedVertices;
+		std::vector<uint32> bakedIndices;
+		for (auto& capture : meshes)
+		{
+			RasterMesh& mesh = capture.Mesh;
+			if (capture.Instances != nullptr)
+			{
+				// Instances baked the way BoxInstancedVS places the corners, the colours follow the box order.
+				const FSceneBoxInstance* instances = reinterpret_cast<const FSceneBoxInstance*>(capture.Instances->GetBufferPointer());
+				bakedVertices.resize(capture.NumInstances * FSceneBoxGeometry::NumCorners * 4);
+				bakedIndices.resize(capture.NumInstances * FSceneBoxGeometry::NumIndices);
+				FSceneBoxGeometry::WriteBakedBoxes(instances, capture.NumInstances, reinterpret_cast<uint8*>(bakedVertices.data()), 4 * sizeof(float), bakedIndices.data());
+				mesh.Vertices = reinterpret_cast<const uint8*>(bakedVertices.data());
+				mesh.VertexStride = 4 * sizeof(float);
+				mesh.NumVertices = (uint32)(capture.NumInstances * FSceneBoxGeometry::NumCorners);
+				mesh.Indices = bakedIndices.data();
+				mesh.bIndices16 = false;
+				mesh.NumIndices = (uint32)bakedIndices.size();
+			}
+			mesh.Colors = reinterpret_cast<const float*>(colors.data());
+			mesh.NumColors = (uint32)colors.size();
+			rasterizer.DrawAdditive(mesh, world, viewProj);
+		}
+
+		RasterCaptureResult result;
+		result.Width = width;
+		result.Height = height;
+		result.Pixels = rasterizer.GetPixels();
+		result.CPUMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count();
+		return result;
+	});
+
+	m_bRasterCapturePending = true;
+}
+
+void AppEntry::ResolveRasterCapture()
+{
+	AppData* appData = m_appGui->GetAppData();
+	RasterCaptureResult cpu = m_rasterCaptureJob.get();
+	RasterCaptureStats& stats = appData->RasterCapture;
+	stats = RasterCaptureStats();
+	stats.Width = cpu.Width;
+	stats.Height = cpu.Height;
+	stats.CPUMs = cpu.CPUMs;
+	m_deviceResources->WaitForGpu();
+
+	const size_t rowFloats = (size_t)stats.Width * 4;
+	std::vector<float> gpuPixels(rowFloats * stats.Height);
+	uint8* mappedData = nullptr;
+	ThrowIfFailed(m_rasterCaptureReadback->Map(0, nullptr, reinterpret_cast<void**>(&mappedData)));
+	for (uint32 row = 0; row < stats.Height; ++row)
+	{
+		const uint8* source = mappedData + m_rasterCaptureLayout.Offset + (size_t)row * m_rasterCaptureLayout.Footprint.RowPitch;
+		std::memcpy(gpuPixels.data() + row * rowFloats, source, rowFloats * sizeof(float));
+	}
+	m_rasterCaptureReadback->Unmap(0, nullptr);
+	m_rasterCaptureReadback.Reset();
+
+	// Max pixel and P99 of the pixels RGBPS does not clip (color - 0.001), the accumulated value is in R.
+	float maxPixel[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	ReduceUtil::Max4(gpuPixels.data(), gpuPixels.size() / 4, maxPixel);
+	std::vector<float> values(gpuPixels.size() / 4);
+	for (size_t pixel = 0; pixel < values.size(); ++pixel)
+		values[pixel] = gpuPixels[pixel * 4];
+	stats.MaxValue = maxPixel[0];
+	stats.P99 = ReduceUtil::Percentile(values.data(), values.size(), 0.99f, 0.001f);
+
+	// Exact per channel compare, a pixel differs if any channel does.
+	for (size_t pixel = 0; pixel < gpuPixels.size(); pixel += 4)
+	{
+		float diff = 0.0f;
+		for (size_t c = pixel; c < pixel + 4; ++c)
+			diff = (std::max)(diff, std::abs(gpuPixels[c] - cpu.Pixels[c]));
+		if (diff > 0.0f)
+		{
+			stats.NumDiffPixels++;
+			stats.MaxDiff = (std::max)(stats.MaxDiff, diff);
+		}
+	}
+
+	stats.bSaved = ImageUtil::WritePFM(appData->AppPath + L"Capture_GPU.pfm", stats.Width, stats.Height, 4, gpuPixels.data());
+	stats.bSaved &= ImageUtil::WritePFM(appData->AppPath + L"Capture_CPU.pfm", stats.Width, stats.Height, 4, cpu.Pixels.data());
+}
+
+void AppEntry::EvaluateFSceneSBuffer(bool bAsync)
+{
+	// Only the stale segments are evaluated, the others keep their slots untouched.
+	// The job only touches its own copies, the engine and the (thread safe) cache.
+	std::vector<std::shared_ptr<const FSceneAttributeContext>> contexts;
+	for (size_t s = 0; s < m_fSceneSBufferSegments.size(); ++s)
+	{
+		if (m_fSceneSBufferSegments[s].bStale)
+		{
+			m_fSceneSBufferSegments[s].bStale = false;
+			contexts.push_back(m_fSceneAttributeContexts[s]);
 		}
-		perFSceneBoxCount++;		
 	}
+	if (contexts.empty())
+		return;
 
-	auto fSceneRItem = std::make_unique<RenderItem>();
-	fSceneRItem->Name = "box" + std::to_string(fSceneRItem->ObjectCBufferIndex);
-	fSceneRItem->World = Matrix4(AffineTransform::MakeScale(m_appGui->GetAppData()->FSceneScale));
-	fSceneRItem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-	fSceneRItem->PerFSceneSBufferOffset = (int)m_perFSceneCPUSBuffer.size();
-	fSceneRItem->CreateCommonGeometry<ColorVertex, uint16>(m_deviceResources.get(), fSceneRItem->Name, fSceneMesh.Vertices, fSceneMesh.GetIndices16());
+	EVisualizationAttribute attribute = m_appGui->GetAppData()->_EVisualizationAttribute;
+	auto allContexts = m_fSceneAttributeContexts;
 
-	m_renderItemLayer[RenderLayer::FScene].push_back(fSceneRItem.get());
-	m_allRitems.push_back(std::move(fSceneRItem));
+	m_fSceneSBufferJob = std::async(bAsync ? std::launch::async : std::launch::deferred, [this, contexts, allContexts, attribute]()
+	{
+		FSceneSBufferResult result;
+		result.SceneIds.reserve(contexts.size());
+		result.SBuffers.reserve(contexts.size());
+
+		// Fill one CPU Structure Buffer per FScene, each chunk straight into its slots.
+		for (auto& context : contexts)
+		{
+			// Columns seen before come straight from the cache.
+			FSceneAttributeColumnPtr column = m_attributeCache.GetColumn(m_attributeEngine, attribute, *context);
+			result.SceneIds.push_back(context->SceneId);
+			result.SBuffers.emplace_back(context->NumInstances);
+			StructureBuffer* sBuffer = result.SBuffers.back().data();
+
+			const size_t chunkSize = FSceneAttributeEngine::EvaluateChunkSize;
+			const TArray<float>& values = column->Values;
+			ThreadUtil::ParallelFor((values.size() + chunkSize - 1) / chunkSize, [&](size_t chunk, uint32)
+			{
+				size_t end = (std::min)((chunk + 1) * chunkSize, values.size());
+				for (size_t i = chunk * chunkSize; i < end; ++i)
+				{
+					float colorX = values[i];
+					sBuffer[i].Color = Vector4(colorX, colorX, colorX, 1.0f);
+				}
+			});
+		}
+
+		// Statistics over every loaded scene, the ones not evaluated above are cache hits.
+		for (auto& context : allContexts)
+		{
+			result.StatsSceneIds.push_back(context->SceneId);
+			result.Stats.Merge(m_attributeCache.GetColumn(m_attributeEngine, attribute, *context)->Stats);
+		}
+
+		return result;
+	});
+}
+
+void AppEntry::UploadFSceneSBuffer(UINT first, UINT count)
+{
+	if (count > 0)
+		m_frameResource->CopyStructureBuffer((int)first, m_perFSceneCPUSBuffer.data() + first, count);
+}
+
+void AppEntry::ReserveFSceneSBuffer(UINT count)
+{
+	if (count <= m_fSceneSBufferCapacity)
+		return;
+
+	// A new upload buffer starts empty, copy the slots of the scenes already there (no evaluation).
+	m_fSceneSBufferCapacity = (std::max)(count, m_fSceneSBufferCapacity * 2);
+	m_frameResource->ResizeBuffer<StructureBuffer>(m_fSceneSBufferCapacity);
+	UploadFSceneSBuffer(0, (UINT)m_perFSceneCPUSBuffer.size());
 }
 
+
 void AppEntry::BuildPSO()
 {
 	bool enable4xMsaa = m_deviceResources->GetDeviceOptions() & DeviceResources::c_Enable4xMsaa;
@@ -1080,6 +1762,18 @@ void AppEntry::BuildPSO()
 	m_deviceResources->CreateGraphicsPipelineState(&psoDesc2, &m_PSOs["BoxBlendAdd"]);
 	//////////////////////////////////////////////////////////////////////////
 
+	//////////////////////////////////////////////////////////////////////////
+	// PSO BoxInstancedBlendAdd.
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc2i = psoDesc2;
+	psoDesc2i.InputLayout = { m_boxInstancedInputLayout.data(), (UINT)m_boxInstancedInputLayout.size() };
+	psoDesc2i.VS =
+	{
+		reinterpret_cast<BYTE*>(m_shaderByteCode["BoxInstancedVS"]->GetBufferPointer()),
+		m_shaderByteCode["BoxInstancedVS"]->GetBufferSize()
+	};
+	m_deviceResources->CreateGraphicsPipelineState(&psoDesc2i, &m_PSOs["BoxInstancedBlendAdd"]);
+	//////////////////////////////////////////////////////////////////////////
+
 	//////////////////////////////////////////////////////////////////////////
 	// PSO FullSQuadWhite.
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc3 = psoDesc0;
@@ -1130,6 +1824,10 @@ void AppEntry::OnDeviceLost()
     // TODO: Add Direct3D resource cleanup here.
 	m_outputBuffer.Reset();
 	m_readBackBuffer.Reset();
+	m_pixelReadBackBuffer.Reset();
+	m_bPixelReadBackPending = false;
+	m_rasterCaptureReadback.Reset();
+	m_bRasterCapturePending = false;
 	m_srvCbvDescHeap.Reset();
 	for (auto& e : m_ROOTSIGs)
 		e.second.Reset();
@@ -9,6 +9,13 @@
 #include "Common/GeometryManager.h"
 #include "Common/FrameResource.h"
 #include "Common/Camera.h"
+#include "Common/MemoryManager.h"
+#include "UnrealEngine/FSceneAssetRegistry.h"
+#include "UnrealEngine/FSceneAttributeCache.h"
+#include "UnrealEngine/FSceneAttributeQuery.h"
+#include "UnrealEngine/FSceneGroupBy.h"
+#include "UnrealEngine/FSceneSpatialIndex.h"
+#include <future>
 
 using namespace DX;
 using namespace DX::GeometryManager;
@@ -84,8 +91,36 @@ private:
 	void BuildShadersAndInputLayout();
 	void BuildLineGridGeometry();
 	void BuildFSceneRenderItems(const FSceneDataSet* currentFSceneDataSet);
+	// Geometry of a FScene render item in m_fSceneGeometry, inside ExecuteCommandLists.
+	void CreateFSceneGeometry(RenderItem* ri, const FSceneDataSet& dataSet);
+	void RebuildFSceneGeometry();
 	void BuildPSO();
 
+	// Memory stats of the FScene render side and of the loaded tables.
+	void UpdateRenderFootprint();
+	void UpdateDataFootprint();
+	void UpdateFSceneTopN();
+
+	// Nearest instances under the cursor, through the scene BVHs.
+	void PickFSceneInstances(int x, int y);
+	void BuildFScenePickRenderItem();
+
+	// Instances inside the camera frustum, the FScene draws and the visible statistics only cover them.
+	void UpdateFSceneVisibleSet();
+	void UpdateFSceneVisibleStats();
+
+	// Offscreen RT 0 of this frame copied for readback and drawn by SoftwareRasterizer off the render thread,
+	// both are saved as PFM and compared once the copy and the job are done.
+	void CaptureOffscreenTarget();
+	void ResolveRasterCapture();
+	// RT 0 copied for the pixel space Auto Overflow, read by Update once its frame is done.
+	void CopyPixelReadBack();
+
+	// Visualization attribute into the structure buffer, deferred (run on the next get) or on a worker thread.
+	void EvaluateFSceneSBuffer(bool bAsync);
+	void UploadFSceneSBuffer(UINT first, UINT count);
+	void ReserveFSceneSBuffer(UINT count);
+
 	// GUI Messages
 	bool CheckInBlockAreas(int x, int y);
 
@@ -96,6 +131,15 @@ private:
 	ComPtr<ID3D12Resource> m_outputBuffer = nullptr;
 	ComPtr<ID3D12Resource> m_readBackBuffer = nullptr;
 
+	// Pixel space Auto Overflow (opt-in), RT 0 copied every PixelOverflowInterval frames into one readback.
+	ComPtr<ID3D12Resource> m_pixelReadBackBuffer = nullptr;
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT m_pixelReadBackLayout = {};
+	UINT m_pixelReadBackFrame = 0;
+	bool m_bPixelReadBackPending = false;
+	UINT m_pixelOverflowCountdown = 0;
+	std::vector<float> m_pixelValues;
+	static const UINT PixelOverflowInterval = 30;
+
 	// DescHeap.
 	ComPtr<ID3D12DescriptorHeap> m_srvCbvDescHeap = nullptr;
 	std::unordered_map<std::string, ComPtr<ID3D12RootSignature>> m_ROOTSIGs;
@@ -105,6 +149,8 @@ private:
 	std::unordered_map<std::string, ComPtr<ID3DBlob>> m_shaderByteCode;
 
 	std::vector<D3D12_INPUT_ELEMENT_DESC> m_inputLayout;
+	// Unit box corners in slot 0, FSceneBoxInstance stream in slot 1.
+	std::vector<D3D12_INPUT_ELEMENT_DESC> m_boxInstancedInputLayout;
 
 	// Device Options.
 	DXGI_FORMAT m_backBufferFormat   = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -140,7 +186,75 @@ private:
 	bool   m_bMouseDownInBlockArea = false;
 	bool   m_bMousePosInBlockArea = false;
 
+	// A left click (press and release without dragging) picks.
+	XMINT2 m_pickMousePos;
+	bool   m_bPickPending = false;
+
 	// Others.
 	std::vector<StructureBuffer> m_perFSceneCPUSBuffer;
-	std::vector<FSceneDataSet> m_allFSceneDataSets;
+	UINT m_numFSceneBoxes = 0;
+	std::vector<FSceneDataSetPtr> m_allFSceneDataSets;
+	// Frees the scenes dropped by Clear off the render thread.
+	MemoryManager::BackgroundReleaser m_releaser;
+	FSceneAssetRegistry m_assetRegistry;
+	FSceneAttributeEngine m_attributeEngine;
+	std::vector<std::shared_ptr<const FSceneAttributeContext>> m_fSceneAttributeContexts;
+	FSceneAttributeCache m_attributeCache;
+	// Instance box BVH per scene, parallel to m_fSceneAttributeContexts.
+	std::vector<std::unique_ptr<FSceneSpatialIndex>> m_fSceneSpatialIndices;
+	// Boxes of the picked instances (render space), outlined by the Selected layer.
+	std::vector<BVHBounds> m_pickedBounds;
+	bool m_bPickedBoundsDirty = false;
+	// Picked values the cache did not hold, filled in once no evaluation job is running.
+	bool m_bPickedValuesDirty = false;
+	RenderItem* m_pickRItem = nullptr;
+
+	// Visible instance slots of every scene, parallel to m_fSceneAttributeContexts. Culled again when the
+	// world view projection of the boxes changes.
+	std::vector<std::vector<uint32>> m_fSceneVisibleSets;
+	XMFLOAT4X4 m_fSceneCullViewProj = {};
+	bool m_bFSceneVisibleStatsDirty = false;
+	// Indices per box in the baked FScene geometry, and the draws one scene is split into at most.
+	static const UINT FSceneBoxIndexCount = 36;
+	static const UINT MaxFSceneDrawRanges = 256;
+	// Geometry every FScene render item is built with, the GUI choice is applied by RebuildFSceneGeometry.
+	EFSceneGeometry m_fSceneGeometry = FG_Instanced;
+
+	// RT 0 capture, copied by the frame that asked for it while SoftwareRasterizer draws the same frame on a worker
+	// thread, resolved by the first Update that finds the job done.
+	struct RasterCaptureResult
+	{
+		uint32 Width = 0;
+		uint32 Height = 0;
+		std::vector<float> Pixels;
+		double CPUMs = 0.0;
+	};
+	ComPtr<ID3D12Resource> m_rasterCaptureReadback = nullptr;
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT m_rasterCaptureLayout = {};
+	std::future<RasterCaptureResult> m_rasterCaptureJob;
+	bool m_bRasterCapturePending = false;
+
+	// Slots of one scene in the structure buffer, parallel to m_fSceneAttributeContexts.
+	// Scenes only ever touch their own segment, adding one leaves the others as they are.
+	struct FSceneSBufferSegment
+	{
+		UINT Offset;
+		UINT Count;
+		bool bStale;
+	};
+	std::vector<FSceneSBufferSegment> m_fSceneSBufferSegments;
+	// GPU structure buffer size, grows geometrically so imports seldom reallocate it.
+	UINT m_fSceneSBufferCapacity = 0;
+
+	struct FSceneSBufferResult
+	{
+		// Keyed by scene, scenes cleared meanwhile are not found and their results dropped.
+		std::vector<uint32> SceneIds;
+		std::vector<std::vector<StructureBuffer>> SBuffers;
+		// Over all the scenes loaded when the job started, dropped if that set changed.
+		std::vector<uint32> StatsSceneIds;
+		FSceneAttributeStats Stats;
+	};
+	std::future<FSceneSBufferResult> m_fSceneSBufferJob;
+
 };
\ No newline at end of file
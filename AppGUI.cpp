@@ -8,6 +8,8 @@
 #include "imgui/impl/imgui_impl_dx12.h"
 #include "Common/FileManager.h"
 #include "Common/StringManager.h"
+#include "UnrealEngine/FSceneAttributeQuery.h"
+#include "UnrealEngine/FSceneGroupBy.h"
 
 using namespace DX::StringManager;
 
@@ -204,6 +206,13 @@ void AppGUI::DrawGUI()
 			ImGui::DragFloat(u8"볡", &m_appData->FSceneScale, 0.00001f, 0.0001f, 1000.0f, "%.5f");
 
 			ImGui::Checkbox(u8"ʵʱֵ", &m_appData->bEnableCalcMax);
+			ImGui::Checkbox("Async Attribute Evaluation", &m_appData->bAsyncAttributeEvaluation);
+			// Re-evaluating is a cache hit, it brings the P99 of the current attribute.
+			if (ImGui::Checkbox("Auto Overflow (P99)", &m_appData->bAutoOverflow))
+				m_appData->bVisualizationAttributeDirty = true;
+			// Opt-in, reads RT 0 back every few frames, the range then follows the view.
+			if (ImGui::Checkbox("Auto Overflow from RT 0 (pixel P99)", &m_appData->bAutoOverflowPixels))
+				m_appData->bVisualizationAttributeDirty = true;
 			if (ImGui::Button(u8""))
 				m_appData->Overflow = m_appData->MaxPixel.GetX();
 			ImGui::SameLine();
@@ -231,6 +240,14 @@ void AppGUI::DrawGUI()
 						if (ImGui::TreeNode("Texture"))
 						{
 							GUI_SetAttribute(VA_CurrentKB);
+							const char* textureAttributions[] =
+							{
+								NameOf(TA_Full),
+								NameOf(TA_SplitByMesh),
+								NameOf(TA_SplitByInstance)
+							};
+							if (ImGui::Combo("Shared Textures", &(int)m_appData->_ETextureAttribution, textureAttributions, IM_ARRAYSIZE(textureAttributions)))
+								m_appData->bTextureAttributionDirty = true;
 							ImGui::TreePop();
 						}
 
@@ -269,10 +286,63 @@ void AppGUI::DrawGUI()
 						
 						ImGui::TreePop();
 					}
+
+					if (ImGui::TreeNode("LOD"))
+					{
+						GUI_SetAttribute(VA_LOD_Triangle_Ratio);
+						GUI_SetAttribute(VA_LOD_Vertex_Delta);
+						GUI_SetAttribute(VA_LOD_Material_Delta);
+						if (ImGui::InputInt("Compare LOD", &m_appData->CompareLOD))
+							m_appData->bCompareLODDirty = true;
+						ImGui::TreePop();
+					}
+
+					if (ImGui::TreeNode("Custom"))
+					{
+						GUI_SetAttribute(VA_Custom);
+						if (ImGui::InputText("##CustomExpression", m_appData->CustomExpression, sizeof(m_appData->CustomExpression), ImGuiInputTextFlags_EnterReturnsTrue))
+							m_appData->bCustomExpressionDirty = true;
+						ImGui::SameLine();
+						if (ImGui::Button("Apply"))
+							m_appData->bCustomExpressionDirty = true;
+						if (!m_appData->CustomExpressionError.empty())
+							ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", m_appData->CustomExpressionError.c_str());
+						ImGui::TreePop();
+					}
 					ImGui::TreePop();
 				}
 			}
 
+			if (ImGui::CollapsingHeader("Attribute Statistics"))
+			{
+				DrawAttributeStats();
+			}
+
+			if (ImGui::CollapsingHeader("Visibility"))
+			{
+				DrawVisibility();
+			}
+
+			if (ImGui::CollapsingHeader("Top N"))
+			{
+				DrawTopN();
+			}
+
+			if (ImGui::CollapsingHeader("Group By"))
+			{
+				DrawGroupBy();
+			}
+
+			if (ImGui::CollapsingHeader("Picking"))
+			{
+				DrawPicked();
+			}
+
+			if (ImGui::CollapsingHeader("Memory Footprint"))
+			{
+				DrawFootprint();
+			}
+
 			ImGui::DragFloat("Speed", &m_appData->DragSpeed, 1.0f, 1.0f, 100.0f);
 			ImGui::DragFloat("Overflow", &m_appData->Overflow, m_appData->DragSpeed, 1.0f, std::numeric_limits<float>::max());
 
@@ -327,6 +397,257 @@ void AppGUI::DrawGUI()
 	}
 }
 
+void AppGUI::DrawAttributeStats()
+{
+	if (ImGui::Checkbox("Visible only", &m_appData->bVisibleAttributeStats))
+		m_appData->bVisibleSetDirty = true;
+	const FSceneAttributeSummary& stats = m_appData->bVisibleAttributeStats ? m_appData->VisibleAttributeStats : m_appData->AttributeStats;
+
+	ImGui::Text("Instances: %llu", (unsigned long long)stats.Count);
+	ImGui::Text("Min: %.3f  Max: %.3f", stats.Min, stats.Max);
+	ImGui::Text("Mean: %.3f  StdDev: %.3f", stats.Mean, stats.StdDev);
+	ImGui::Text("P50: %.3f  P90: %.3f  P99: %.3f", stats.P50, stats.P90, stats.P99);
+
+	if (!stats.Histogram.empty())
+		ImGui::PlotHistogram("##AttributeHistogram", stats.Histogram.data(), (int)stats.Histogram.size(), 0, "Min -> Max", 0.0f, FLT_MAX, ImVec2(0.0f, 80.0f));
+}
+
+void AppGUI::DrawVisibility()
+{
+	const FSceneViewStats& stats = m_appData->ViewStats;
+
+	// The loaded scenes are rebuilt with the other geometry.
+	const char* fSceneGeometries[] =
+	{
+		NameOf(FG_Instanced),
+		NameOf(FG_Baked)
+	};
+	if (ImGui::Combo("Box Geometry", &(int)m_appData->_EFSceneGeometry, fSceneGeometries, IM_ARRAYSIZE(fSceneGeometries)))
+		m_appData->bFSceneGeometryDirty = true;
+	if (ImGui::Checkbox("Frustum Culling", &m_appData->bFrustumCulling))
+		m_appData->bVisibleSetDirty = true;
+	ImGui::Text("Visible: %llu / %llu (%.1f%%)", (unsigned long long)stats.NumVisible, (unsigned long long)stats.NumInstances,
+		stats.NumInstances > 0 ? 100.0 * (double)stats.NumVisible / (double)stats.NumInstances : 0.0);
+	ImGui::Text("Draw calls: %u", stats.NumDrawCalls);
+	ImGui::Text("Culling: %.3f ms", stats.CullMs);
+
+	// Offscreen RT 0 from the GPU against SoftwareRasterizer, both saved next to the app.
+	ImGui::Separator();
+	const RasterCaptureStats& capture = m_appData->RasterCapture;
+	if (ImGui::Button("Capture RT 0 (GPU / CPU)") && m_appData->FSceneRenderFootprint.NumBoxes > 0)
+		m_appData->bRasterCaptureDirty = true;
+	if (capture.Width > 0)
+	{
+		ImGui::Text("Capture: %u x %u, CPU raster %.1f ms", capture.Width, capture.Height, capture.CPUMs);
+		ImGui::Text("Differing pixels: %llu, max diff: %g", (unsigned long long)capture.NumDiffPixels, capture.MaxDiff);
+		ImGui::Text("GPU max: %.3f  P99: %.3f", capture.MaxValue, capture.P99);
+		ImGui::SameLine();
+		if (ImGui::Button("Overflow = P99") && capture.P99 > 0.0f)
+			m_appData->Overflow = capture.P99;
+		if (capture.bSaved)
+			ImGui::TextUnformatted("Saved Capture_GPU.pfm / Capture_CPU.pfm");
+	}
+}
+
+void AppGUI::DrawTopN()
+{
+	ImGui::SetNextItemWidth(100);
+	if (ImGui::InputInt("N", &m_appData->TopNCount))
+	{
+		m_appData->TopNCount = (std::min)((std::max)(m_appData->TopNCount, 1), (int)FSceneAttributeQuery::MaxTopN);
+		m_appData->bTopNDirty = true;
+	}
+	ImGui::SameLine();
+	if (ImGui::Checkbox("Instances", &m_appData->bTopNInstances))
+		m_appData->bTopNDirty = true;
+	ImGui::SameLine();
+	if (ImGui::Button("Refresh##TopN"))
+		m_appData->bTopNDirty = true;
+
+	ImGui::Columns(5, "TopNColumns");
+	ImGui::Text("Value"); ImGui::NextColumn();
+	ImGui::Text("Name"); ImGui::NextColumn();
+	ImGui::Text("Owner"); ImGui::NextColumn();
+	ImGui::Text("Instance"); ImGui::NextColumn();
+	ImGui::Text("AssetPath"); ImGui::NextColumn();
+	ImGui::Separator();
+
+	for (auto& row : m_appData->TopN)
+	{
+		ImGui::Text("%.3f", row.Value); ImGui::NextColumn();
+		ImGui::TextUnformatted(row.Name.c_str()); ImGui::NextColumn();
+		ImGui::TextUnformatted(row.OwnerName.c_str()); ImGui::NextColumn();
+		if (row.Instance >= 0)
+			ImGui::Text("%d", row.Instance);
+		else ImGui::Text("-");
+		ImGui::NextColumn();
+		ImGui::TextUnformatted(row.AssetPath.c_str()); ImGui::NextColumn();
+	}
+	ImGui::Columns(1);
+}
+
+void AppGUI::DrawGroupBy()
+{
+	const char* groupBySources[] =
+	{
+		NameOf(GS_Meshes),
+		NameOf(GS_Instances),
+		NameOf(GS_Materials),
+		NameOf(GS_Textures)
+	};
+	ImGui::Combo("Rows", &(int)m_appData->_EGroupBySource, groupBySources, IM_ARRAYSIZE(groupBySources));
+
+	const char* groupByKeys[] =
+	{
+		NameOf(GK_Name),
+		NameOf(GK_OwnerName),
+		NameOf(GK_AssetPath),
+		NameOf(GK_AssetFolder),
+		NameOf(GK_Material)
+	};
+	ImGui::Combo("Key", &(int)m_appData->_EGroupByKey, groupByKeys, IM_ARRAYSIZE(groupByKeys));
+
+	const char* groupByAggregates[] =
+	{
+		NameOf(GA_Sum),
+		NameOf(GA_Count),
+		NameOf(GA_Min),
+		NameOf(GA_Max),
+		NameOf(GA_Avg)
+	};
+	ImGui::Combo("Aggregate", &(int)m_appData->_EGroupByAggregate, groupByAggregates, IM_ARRAYSIZE(groupByAggregates));
+
+	// Mesh / instance rows aggregate the visualized attribute.
+	if (m_appData->_EGroupBySource == GS_Materials || m_appData->_EGroupBySource == GS_Textures)
+		ImGui::InputText("Field", m_appData->GroupByField, sizeof(m_appData->GroupByField));
+
+	if (ImGui::Button("Run##GroupBy"))
+		m_appData->bGroupByDirty = true;
+	ImGui::SameLine();
+	if (ImGui::Button("Export CSV##GroupBy"))
+		FSceneGroupBy::WriteCsv(m_appData->AppPath + L"FSceneGroupBy.csv", m_appData->GroupBy, groupByKeys[m_appData->_EGroupByKey], groupByAggregates[m_appData->_EGroupByAggregate]);
+
+	if (!m_appData->GroupByError.empty())
+		ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", m_appData->GroupByError.c_str());
+
+	ImGui::Text("%d groups", (int)m_appData->GroupBy.size());
+	ImGui::Columns(3, "GroupByColumns");
+	ImGui::Text("Key"); ImGui::NextColumn();
+	ImGui::Text("Value"); ImGui::NextColumn();
+	ImGui::Text("Count"); ImGui::NextColumn();
+	ImGui::Separator();
+
+	// Only the visible rows are submitted, folders / owners can run in the tens of thousands.
+	ImGuiListClipper clipper((int)m_appData->GroupBy.size());
+	while (clipper.Step())
+	{
+		for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i)
+		{
+			auto& row = m_appData->GroupBy[i];
+			ImGui::TextUnformatted(row.Key.c_str()); ImGui::NextColumn();
+			ImGui::Text("%.3f", row.Value); ImGui::NextColumn();
+			ImGui::Text("%.0f", row.Count); ImGui::NextColumn();
+		}
+	}
+	ImGui::Columns(1);
+}
+
+void AppGUI::DrawPicked()
+{
+	ImGui::SetNextItemWidth(100);
+	ImGui::SliderInt("Hits", &m_appData->PickCount, 1, 16);
+	ImGui::SameLine();
+	ImGui::Checkbox("Outline", &m_appData->bShowPickBounds);
+	ImGui::TextDisabled("Left click in the viewport, nearest first.");
+
+	for (size_t i = 0; i < m_appData->Picked.size(); ++i)
+	{
+		auto& row = m_appData->Picked[i];
+		ImGui::PushID((int)i);
+		if (ImGui::TreeNodeEx("Hit", i == 0 ? ImGuiTreeNodeFlags_DefaultOpen : 0, "%s [%d]  %.1f", row.Name.c_str(), row.Instance, row.Distance))
+		{
+			ImGui::Text("Owner: %s", row.OwnerName.c_str());
+			ImGui::Text("AssetPath: %s", row.AssetPath.c_str());
+			ImGui::Text("Scene: %u  Instance: %d  Value: %.3f", row.Scene, row.Instance, row.Value);
+			ImGui::Text("Vertices: %u  Triangles: %u  LODs: %u", row.NumVertices, row.NumTriangles, row.NumLODs);
+			if (ImGui::TreeNode("Materials", "Materials (%d)", (int)row.Materials.size()))
+			{
+				for (auto& material : row.Materials)
+					ImGui::BulletText("%s", material.c_str());
+				ImGui::TreePop();
+			}
+			if (ImGui::TreeNode("Textures", "Textures (%d)", (int)row.Textures.size()))
+			{
+				for (auto& texture : row.Textures)
+					ImGui::BulletText("%s", texture.c_str());
+				ImGui::TreePop();
+			}
+			ImGui::TreePop();
+		}
+		ImGui::PopID();
+	}
+}
+
+void AppGUI::DrawFootprint()
+{
+	if (ImGui::Button("Refresh"))
+		m_appData->bDataFootprintDirty = true;
+
+	ImGui::SameLine();
+	if (ImGui::Button("Export JSON"))
+		FSceneFootprintUtil::WriteJson(m_appData->AppPath + L"FSceneFootprint.json", m_footprints, m_appData->FSceneRenderFootprint);
+
+	auto toMB = [](uint64 bytes) { return (double)bytes / (1024.0 * 1024.0); };
+
+	for (size_t i = 0; i < m_footprints.size(); ++i)
+	{
+		auto& footprint = m_footprints[i];
+		if (!ImGui::TreeNode((void*)(intptr_t)i, "%s  %.2f MB", footprint.Name.c_str(), toMB(footprint.Total.GetTotalBytes())))
+			continue;
+
+		ImGui::Columns(6, "FootprintColumns");
+		ImGui::Text("Table"); ImGui::NextColumn();
+		ImGui::Text("Records"); ImGui::NextColumn();
+		ImGui::Text("Struct MB"); ImGui::NextColumn();
+		ImGui::Text("String MB"); ImGui::NextColumn();
+		ImGui::Text("Index MB"); ImGui::NextColumn();
+		ImGui::Text("Allocs"); ImGui::NextColumn();
+		ImGui::Separator();
+
+		for (auto& table : footprint.Tables)
+		{
+			ImGui::Text("%s", table.TableName.c_str()); ImGui::NextColumn();
+			ImGui::Text("%llu", table.NumRecords); ImGui::NextColumn();
+			ImGui::Text("%.2f", toMB(table.StructBytes)); ImGui::NextColumn();
+			ImGui::Text("%.2f", toMB(table.StringHeapBytes)); ImGui::NextColumn();
+			ImGui::Text("%.2f", toMB(table.IndexArrayBytes)); ImGui::NextColumn();
+			ImGui::Text("%llu", table.NumAllocations); ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+		ImGui::TreePop();
+	}
+
+	auto& render = m_appData->FSceneRenderFootprint;
+	ImGui::Separator();
+	ImGui::Text("Render Items: %llu  Boxes: %llu", render.NumRenderItems, render.NumBoxes);
+	ImGui::Text("VB %.2f MB  IB %.2f MB  Instances %.2f MB  Uploader %.2f MB", toMB(render.VertexBufferBytes), toMB(render.IndexBufferBytes),
+		toMB(render.InstanceBufferBytes), toMB(render.UploaderBytes));
+	ImGui::Text("CPU Geometry %.2f MB  SBuffer %.2f MB  CPU SBuffer %.2f MB", toMB(render.CPUGeometryBytes), toMB(render.StructureBufferBytes), toMB(render.CPUStructureBufferBytes));
+	ImGui::Text("Render Total %.2f MB", toMB(render.GetTotalBytes()));
+
+	// Loaded scenes share assets, unique counts are per UniqueId.
+	auto& assets = m_appData->FSceneAssets;
+	if (assets.NumScenes > 0)
+	{
+		ImGui::Separator();
+		ImGui::Text("Loaded Scenes: %llu", assets.NumScenes);
+		ImGui::Text("Materials %llu (Unique %llu)  MatIns %llu (Unique %llu)",
+			assets.NumMaterials, assets.NumUniqueMaterials, assets.NumMaterialInstances, assets.NumUniqueMaterialInstances);
+		ImGui::Text("Textures %llu (Unique %llu)", assets.NumTextures, assets.NumUniqueTextures);
+		ImGui::Text("Texture %.2f MB (Unique %.2f MB)", assets.TextureKB / 1024.0, assets.UniqueTextureKB / 1024.0);
+	}
+}
+
 void AppGUI::ImportFSceneFromDir(std::wstring path)
 {
 	static std::wstring g_path;
@@ -41,10 +41,19 @@ public:
 
 	bool CheckImporterLock() const { return m_importerLock; }
 
+	// Filled by AppEntry, it owns the loaded scenes.
+	void SetFootprints(std::vector<FSceneDataFootprint>&& footprints) { m_footprints = std::move(footprints); }
+
 private:
 
 	void NewFrame();
 	void DrawGUI();
+	void DrawFootprint();
+	void DrawAttributeStats();
+	void DrawVisibility();
+	void DrawTopN();
+	void DrawGroupBy();
+	void DrawPicked();
 
 	void ImportFSceneFromDir(std::wstring path);
 	void SetBlockAreas(int index, bool bFullScreen = false);
@@ -72,4 +81,7 @@ private:
 	std::atomic<bool> m_importerLock = false;
 	TimerManager::PerformanceCounter m_performanceCounter;
 	bool m_notifyImporterBegin = false;
+
+	// Memory Footprint.
+	std::vector<FSceneDataFootprint> m_footprints;
 };
\ No newline at end of file
@@ -0,0 +1,249 @@
+//
+// AppHeadless.cpp
+//
+
+#include "AppHeadless.h"
+#include "Common/GeometryManager.h"
+#include "Common/FrameResource.h"
+#include "Common/StringManager.h"
+#include "Common/Camera.h"
+#include "Common/ImageManager.h"
+#include "Common/RasterManager.h"
+#include "UnrealEngine/FSceneAttributeExport.h"
+#include "UnrealEngine/FSceneBoxGeometry.h"
+#include "UnrealEngine/FSceneHeatmap.h"
+
+using namespace DX::GeometryManager;
+using namespace DX::StringManager;
+using namespace DX::ImageManager;
+using namespace DX::RasterManager;
+
+bool AppHeadless::Run(const std::wstring& cmdLine, int& exitCode)
+{
+	std::vector<std::wstring> footprintPaths = StringUtil::WGetBetween(cmdLine, L"-footprint [", L"]");
+	std::vector<std::wstring> exportPaths = StringUtil::WGetBetween(cmdLine, L"-export [", L"]");
+	std::vector<std::wstring> heatmapPaths = StringUtil::WGetBetween(cmdLine, L"-heatmap [", L"]");
+	std::vector<std::wstring> rasterPaths = StringUtil::WGetBetween(cmdLine, L"-raster [", L"]");
+	if (footprintPaths.empty() && exportPaths.empty() && heatmapPaths.empty() && rasterPaths.empty())
+		return false;
+
+	exitCode = 1;
+
+	std::vector<std::wstring> dirs = StringUtil::WGetBetween(cmdLine, L"-dir [", L"]");
+	if (dirs.empty())
+		return true;
+
+	FSceneDataImporter importer;
+	importer.FillDataSets(dirs.front());
+
+	bool bSucceeded = true;
+	if (!footprintPaths.empty())
+		bSucceeded &= DumpFootprint(importer, footprintPaths.front());
+	if (!exportPaths.empty())
+	{
+		std::vector<std::wstring> csvPaths = StringUtil::WGetBetween(cmdLine, L"-csv [", L"]");
+		bSucceeded &= ExportAttributes(importer, exportPaths.front(), csvPaths.empty() ? std::wstring() : csvPaths.front());
+	}
+	if (!heatmapPaths.empty())
+		bSucceeded &= WriteHeatmap(importer, cmdLine, heatmapPaths.front());
+	if (!rasterPaths.empty())
+		bSucceeded &= RasterizeView(importer, cmdLine, rasterPaths.front());
+
+	if (bSucceeded)
+		exitCode = 0;
+
+	return true;
+}
+
+RenderFootprint AppHeadless::EstimateRenderFootprint(const FSceneDataSet& dataSet, EFSceneGeometry geometry)
+{
+	RenderFootprint footprint;
+	footprint.bEstimated = true;
+	footprint.NumRenderItems = 1;
+
+	for (auto& staticMesh : dataSet.StaticMeshesTable)
+		footprint.NumBoxes += staticMesh.BoundsIndices.size();
+	footprint.NumBoxes += dataSet.SkeletalMeshesTable.size();
+
+	// One unit box and an instance per box, or 8 corners and 36 indices per box, see CreateFSceneGeometry.
+	if (geometry == FG_Instanced)
+	{
+		footprint.VertexBufferBytes = FSceneBoxGeometry::NumCorners * sizeof(ColorVertex);
+		footprint.IndexBufferBytes = FSceneBoxGeometry::NumIndices * sizeof(uint16);
+		footprint.InstanceBufferBytes = footprint.NumBoxes * sizeof(FSceneBoxInstance);
+	}
+	else
+	{
+		footprint.VertexBufferBytes = footprint.NumBoxes * FSceneBoxGeometry::NumCorners * sizeof(ColorVertex);
+		footprint.IndexBufferBytes = footprint.NumBoxes * FSceneBoxGeometry::NumIndices * sizeof(uint32);
+	}
+	footprint.UploaderBytes = footprint.VertexBufferBytes + footprint.IndexBufferBytes + footprint.InstanceBufferBytes;
+	footprint.CPUGeometryBytes = footprint.UploaderBytes;
+	footprint.StructureBufferBytes = footprint.NumBoxes * sizeof(StructureBuffer);
+	footprint.CPUStructureBufferBytes = footprint.StructureBufferBytes;
+
+	return footprint;
+}
+
+bool AppHeadless::DumpFootprint(const FSceneDataImporter& importer, const std::wstring& path)
+{
+	RenderFootprint renderFootprint;
+	if (importer.GetFSceneData(0))
+		renderFootprint = EstimateRenderFootprint(*importer.GetFSceneData(0));
+
+	return FSceneFootprintUtil::WriteJson(path, importer.GetAllFootprints(), renderFootprint);
+}
+
+bool AppHeadless::ExportAttributes(const FSceneDataImporter& importer, const std::wstring& binPath, const std::wstring& csvPath)
+{
+	if (!importer.GetFSceneData(0))
+		return false;
+
+	std::vector<const FSceneDataSet*> lods;
+	for (int lod = 1; lod < importer.GetLODCount(); ++lod)
+		lods.push_back(importer.GetFSceneData(lod));
+
+	FSceneAttributeEngine engine;
+	std::string error;
+	return FSceneAttributeExport::Run(engine, *importer.GetFSceneData(0), lods, binPath, csvPath, error);
+}
+
+bool AppHeadless::WriteHeatmap(const FSceneDataImporter& importer, const std::wstring& cmdLine, const std::wstring& pngPath)
+{
+	if (!importer.GetFSceneData(0))
+		return false;
+
+	std::vector<const FSceneDataSet*> lods;
+	for (int lod = 1; lod < importer.GetLODCount(); ++lod)
+		lods.push_back(importer.GetFSceneData(lod));
+
+	FSceneHeatmapOptions options;
+	if (!ParseAttribute(cmdLine, options.Attribute))
+		return false;
+
+	std::vector<std::wstring> resolutions = StringUtil::WGetBetween(cmdLine, L"-resolution [", L"]");
+	if (!resolutions.empty())
+		options.Resolution = StringUtil::WStringToNumeric<uint32>(resolutions.front());
+
+	std::vector<std::wstring> splats = StringUtil::WGetBetween(cmdLine, L"-splat [", L"]");
+	if (!splats.empty())
+		options.Splat = splats.front() == L"Center" ? HS_Center : HS_Coverage;
+
+	std::vector<std::wstring> overflows = StringUtil::WGetBetween(cmdLine, L"-overflow [", L"]");
+	if (!overflows.empty())
+		options.Overflow = StringUtil::WStringToNumeric<float>(overflows.front());
+
+	FSceneAttributeEngine engine;
+	FSceneHeatmap heatmap;
+	heatmap.Build(engine, *importer.GetFSceneData(0), lods, options);
+	if (heatmap.GetCells().empty())
+		return false;
+
+	bool bSucceeded = heatmap.WritePNG(pngPath, options.Overflow);
+	std::vector<std::wstring> pfmPaths = StringUtil::WGetBetween(cmdLine, L"-pfm [", L"]");
+	if (!pfmPaths.empty())
+		bSucceeded &= heatmap.WritePFM(pfmPaths.front());
+	return bSucceeded;
+}
+
+bool AppHeadless::RasterizeView(const FSceneDataImporter& importer, const std::wstring& cmdLine, const std::wstring& pfmPath)
+{
+	if (!importer.GetFSceneData(0))
+		return false;
+
+	const FSceneDataSet& dataSet = *importer.GetFSceneData(0);
+	std::vector<const FSceneDataSet*> lods;
+	for (int lod = 1; lod < importer.GetLODCount(); ++lod)
+		lods.push_back(importer.GetFSceneData(lod));
+
+	EVisualizationAttribute attribute = VA_NumActors;
+	if (!ParseAttribute(cmdLine, attribute))
+		return false;
+
+	// Same defaults as the window.
+	AppData appData;
+	int width = 1280, height = 720;
+	float scale = appData.FSceneScale;
+	std::vector<std::wstring> args = StringUtil::WGetBetween(cmdLine, L"-width [", L"]");
+	if (!args.empty())
+		width = (std::min)((std::max)(StringUtil::WStringToNumeric<int>(args.front()), 1), (int)SoftwareRasterizer::MaxSize);
+	args = StringUtil::WGetBetween(cmdLine, L"-height [", L"]");
+	if (!args.empty())
+		height = (std::min)((std::max)(StringUtil::WStringToNumeric<int>(args.front()), 1), (int)SoftwareRasterizer::MaxSize);
+	args = StringUtil::WGetBetween(cmdLine, L"-scale [", L"]");
+	if (!args.empty())
+		scale = StringUtil::WStringToNumeric<float>(args.front());
+
+	XMFLOAT3 eye(0.0f, 8.0f, -25.0f), target(0.0f, 0.0f, 0.0f);
+	args = StringUtil::WGetBetween(cmdLine, L"-eye [", L"]");
+	std::vector<float> values = args.empty() ? std::vector<float>() : StringUtil::WStringToArray<float>(args.front(), L',');
+	if (values.size() == 3)
+		eye = XMFLOAT3(values[0], values[1], values[2]);
+	args = StringUtil::WGetBetween(cmdLine, L"-target [", L"]");
+	values = args.empty() ? std::vector<float>() : StringUtil::WStringToArray<float>(args.front(), L',');
+	if (values.size() == 3)
+		target = XMFLOAT3(values[0], values[1], values[2]);
+
+	Camera camera;
+	camera.SetFrustum(0.25f*XM_PI, width, height, 1.0f, appData.CameraFarZ);
+	camera.LookAt(eye, target, XMFLOAT3(0.0f, 1.0f, 0.0f));
+	camera.UpdateViewMatrix();
+
+	// Colours like EvaluateFSceneSBuffer.
+	FSceneAttributeEngine engine;
+	std::unique_ptr<FSceneAttributeContext> context = engine.BuildContext(dataSet, lods);
+	TArray<float> attributeValues(context->NumInstances);
+	engine.Evaluate(attribute, *context, attributeValues.data());
+	std::vector<float> colors(attributeValues.size() * 4);
+	for (size_t i = 0; i < attributeValues.size(); ++i)
+	{
+		colors[i * 4 + 0] = colors[i * 4 + 1] = colors[i * 4 + 2] = attributeValues[i];
+		colors[i * 4 + 3] = 1.0f;
+	}
+
+	// The baked boxes, positions only.
+	std::vector<FSceneBoxInstance> instances;
+	FSceneBoxGeometry::BuildInstances(dataSet, instances);
+	std::vector<float> vertices(instances.size() * FSceneBoxGeometry::NumCorners * 4);
+	std::vector<uint32> indices(instances.size() * FSceneBoxGeometry::NumIndices);
+	FSceneBoxGeometry::WriteBakedBoxes(instances.data(), instances.size(), reinterpret_cast<uint8*>(vertices.data()), 4 * sizeof(float), indices.data());
+
+	RasterMesh rasterMesh;
+	rasterMesh.Vertices = reinterpret_cast<const uint8*>(vertices.data());
+	rasterMesh.VertexStride = 4 * sizeof(float);
+	rasterMesh.NumVertices = (uint32)(instances.size() * FSceneBoxGeometry::NumCorners);
+	rasterMesh.Indices = indices.data();
+	rasterMesh.bIndices16 = false;
+	rasterMesh.NumIndices = (uint32)indices.size();
+	rasterMesh.Colors = colors.data();
+	rasterMesh.NumColors = (uint32)attributeValues.size();
+
+	XMFLOAT4X4 world, viewProj;
+	XMStoreFloat4x4(&world, XMMatrixScaling(scale, scale, scale));
+	XMStoreFloat4x4(&viewProj, camera.GetViewProj());
+
+	SoftwareRasterizer rasterizer((uint32)width, (uint32)height);
+	const float clearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	rasterizer.Clear(clearColor);
+	rasterizer.DrawAdditive(rasterMesh, world, viewProj);
+
+	return ImageUtil::WritePFM(pfmPath, (uint32)width, (uint32)height, 4, rasterizer.GetPixels().data());
+}
+
+bool AppHeadless::ParseAttribute(const std::wstring& cmdLine, EVisualizationAttribute& attribute)
+{
+	std::vector<std::wstring> attributes = StringUtil::WGetBetween(cmdLine, L"-attribute [", L"]");
+	if (attributes.empty())
+		return true;
+
+	std::string name = StringUtil::WStringToString(attributes.front());
+	for (int i = 0; i < VA_Count; ++i)
+	{
+		if (name == FSceneAttributeExport::GetAttributeName((EVisualizationAttribute)i))
+		{
+			attribute = (EVisualizationAttribute)i;
+			return true;
+		}
+	}
+	return false;
+}
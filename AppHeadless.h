@@ -0,0 +1,39 @@
+//
+// AppHeadless.h
+// Command line jobs that run without creating a window or a D3D12 device.
+//
+
+#pragma once
+
+#include "AppData.h"
+#include "UnrealEngine/FSceneDataImporter.h"
+
+using namespace DX;
+using namespace UnrealEngine;
+
+class AppHeadless
+{
+public:
+
+	// Returns false if the command line holds no headless job, the app then starts as usual.
+	// -dir [FScene folder] -footprint [output .json]
+	// -dir [FScene folder] -export [output .bin] (-csv [output .csv]), see FSceneAttributeExport.
+	// -dir [FScene folder] -heatmap [output .png] (-pfm [output .pfm]) (-attribute [NumTriangles]) (-resolution [1024])
+	//   (-splat [Coverage|Center]) (-overflow [value]), see FSceneHeatmap.
+	// -dir [FScene folder] -raster [output .pfm] (-width [1280]) (-height [720]) (-eye [x,y,z]) (-target [x,y,z])
+	//   (-attribute [NumTriangles]) (-scale [0.001]), offscreen RT 0 rendered by SoftwareRasterizer.
+	static bool Run(const std::wstring& cmdLine, int& exitCode);
+
+	// What BuildFSceneRenderItems would create for this scene.
+	static RenderFootprint EstimateRenderFootprint(const FSceneDataSet& dataSet, EFSceneGeometry geometry = FG_Instanced);
+
+private:
+
+	static bool DumpFootprint(const FSceneDataImporter& importer, const std::wstring& path);
+	static bool ExportAttributes(const FSceneDataImporter& importer, const std::wstring& binPath, const std::wstring& csvPath);
+	static bool WriteHeatmap(const FSceneDataImporter& importer, const std::wstring& cmdLine, const std::wstring& pngPath);
+	static bool RasterizeView(const FSceneDataImporter& importer, const std::wstring& cmdLine, const std::wstring& pfmPath);
+
+	// -attribute [Name], false if the name is unknown.
+	static bool ParseAttribute(const std::wstring& cmdLine, EVisualizationAttribute& attribute);
+};
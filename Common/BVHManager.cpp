@@ -0,0 +1,594 @@
+//
+// BVHManager.cpp
+//
+
+#include "BVHManager.h"
+#include "ThreadManager.h"
+#include <chrono>
+#include <functional>
+
+using namespace DX;
+using namespace DX::BVHManager;
+using namespace DX::ThreadManager;
+
+namespace
+{
+	// Placeholder of a subtree built by a worker, RightOrFirst is the task index.
+	const uint32 SubtreeMarker = 0xFFFFFFFF;
+
+	// Ranges larger than this bin and bound their primitives in parallel.
+	const uint32 ParallelRangeSize = 64 * 1024;
+
+	// Build time record, partitioned in place so every pass reads memory in order.
+	struct Primitive
+	{
+		BVHBounds Bounds;
+		float Centroid[3];
+		uint32 Index;
+	};
+
+	// Boxes and centroids of a range.
+	struct RangeBounds
+	{
+		BVHBounds Bounds;
+		BVHBounds Centroids;
+		uint32 Count = 0;
+
+		void Add(const Primitive& primitive)
+		{
+			Bounds.Grow(primitive.Bounds);
+			Centroids.Grow(primitive.Centroid);
+			++Count;
+		}
+
+		void Merge(const RangeBounds& other)
+		{
+			Bounds.Grow(other.Bounds);
+			Centroids.Grow(other.Centroids);
+			Count += other.Count;
+		}
+	};
+
+	struct Bin
+	{
+		BVHBounds Bounds;
+		uint32 Count = 0;
+
+		void Merge(const Bin& other)
+		{
+			Bounds.Grow(other.Bounds);
+			Count += other.Count;
+		}
+	};
+
+	// One bin set per axis.
+	struct BinSet
+	{
+		Bin Bins[3][BVH::NumBins];
+
+		void Merge(const BinSet& other)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				for (uint32 b = 0; b < BVH::NumBins; ++b)
+					Bins[axis][b].Merge(other.Bins[axis][b]);
+			}
+		}
+	};
+
+	// Entry distance of the ray in the box, false if it misses or enters after tMax.
+	bool IntersectRay(const float min[3], const float max[3], const float origin[3], const float invDirection[3], float tMax, float& tEnter)
+	{
+		float t0 = 0.0f, t1 = tMax;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			float tNear = (min[axis] - origin[axis]) * invDirection[axis];
+			float tFar = (max[axis] - origin[axis]) * invDirection[axis];
+			if (tNear > tFar)
+				std::swap(tNear, tFar);
+			t0 = tNear > t0 ? tNear : t0;
+			t1 = tFar < t1 ? tFar : t1;
+			if (t0 > t1)
+				return false;
+		}
+		tEnter = t0;
+		return true;
+	}
+}
+
+class BVH::Builder
+{
+public:
+
+	struct Task
+	{
+		uint32 Begin;
+		uint32 End;
+		uint32 Depth;
+		RangeBounds Range;
+	};
+
+	explicit Builder(const std::vector<BVHBounds>& bounds)
+	{
+		m_primitives.resize(bounds.size());
+		ForRange(0, (uint32)bounds.size(), true, [&](uint32 begin, uint32 end, uint32)
+		{
+			for (uint32 i = begin; i < end; ++i)
+			{
+				Primitive& primitive = m_primitives[i];
+				primitive.Bounds = bounds[i];
+				for (int axis = 0; axis < 3; ++axis)
+					primitive.Centroid[axis] = (bounds[i].Min[axis] + bounds[i].Max[axis]) * 0.5f;
+				primitive.Index = i;
+			}
+		});
+	}
+
+	const std::vector<Primitive>& GetPrimitives() const { return m_primitives; }
+
+	RangeBounds ComputeRange(uint32 begin, uint32 end, bool bParallel) const
+	{
+		std::vector<RangeBounds> partials(bParallel ? ThreadUtil::GetWorkerCount() : 1);
+		ForRange(begin, end, bParallel, [&](uint32 rangeBegin, uint32 rangeEnd, uint32 worker)
+		{
+			for (uint32 i = rangeBegin; i < rangeEnd; ++i)
+				partials[worker].Add(m_primitives[i]);
+		});
+		for (size_t worker = 1; worker < partials.size(); ++worker)
+			partials[0].Merge(partials[worker]);
+		return partials[0];
+	}
+
+	// Builds [begin, end) depth first into nodes, returns the node index. Below taskSize primitives
+	// the range is handed to tasks instead (when set) and a placeholder node is emitted.
+	// The bounds of the children are gathered while partitioning, every level reads the primitives twice.
+	uint32 BuildNode(std::vector<BVHNode>& nodes, uint32 begin, uint32 end, uint32 depth, const RangeBounds& range, std::vector<Task>* tasks, uint32 taskSize)
+	{
+		uint32 nodeIndex = (uint32)nodes.size();
+		nodes.emplace_back();
+		const uint32 count = end - begin;
+
+		if (tasks != nullptr && count <= taskSize && count > MaxLeafSize)
+		{
+			nodes[nodeIndex].RightOrFirst = (uint32)tasks->size();
+			nodes[nodeIndex].Count = SubtreeMarker;
+			Task task = { begin, end, depth, range };
+			tasks->push_back(task);
+			return nodeIndex;
+		}
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			nodes[nodeIndex].Min[axis] = range.Bounds.Min[axis];
+			nodes[nodeIndex].Max[axis] = range.Bounds.Max[axis];
+		}
+
+		if (count <= MaxLeafSize || depth + 1 >= MaxDepth)
+		{
+			nodes[nodeIndex].RightOrFirst = begin;
+			nodes[nodeIndex].Count = count;
+			return nodeIndex;
+		}
+
+		RangeBounds left, right;
+		uint32 middle = Split(begin, end, range, tasks != nullptr, left, right);
+		BuildNode(nodes, begin, middle, depth + 1, left, tasks, taskSize);
+		uint32 rightIndex = BuildNode(nodes, middle, end, depth + 1, right, tasks, taskSize);
+		nodes[nodeIndex].RightOrFirst = rightIndex;
+		nodes[nodeIndex].Count = 0;
+		return nodeIndex;
+	}
+
+private:
+
+	// Runs lambda(begin, end, worker) over [begin, end), in chunks on all the cores when bParallel is set.
+	template<typename TLambda>
+	static void ForRange(uint32 begin, uint32 end, bool bParallel, const TLambda& lambda)
+	{
+		const uint32 chunkSize = ParallelRangeSize;
+		if (!bParallel || end - begin <= chunkSize)
+		{
+			lambda(begin, end, 0u);
+			return;
+		}
+		size_t numChunks = (end - begin + chunkSize - 1) / chunkSize;
+		ThreadUtil::ParallelFor(numChunks, [&](size_t chunk, uint32 worker)
+		{
+			uint32 chunkBegin = begin + (uint32)chunk * chunkSize;
+			lambda(chunkBegin, (std::min)(chunkBegin + chunkSize, end), worker);
+		});
+	}
+
+	// Binned SAH over the 3 axes, partitions the primitives and returns the first index of the right child.
+	uint32 Split(uint32 begin, uint32 end, const RangeBounds& range, bool bParallel, RangeBounds& left, RangeBounds& right)
+	{
+		const uint32 numBins = NumBins;
+		float scale[3];
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			float extent = range.Centroids.Max[axis] - range.Centroids.Min[axis];
+			scale[axis] = extent > 0.0f ? numBins / extent : 0.0f;
+		}
+
+		auto getBin = [&](const Primitive& primitive, int axis)
+		{
+			uint32 bin = (uint32)((primitive.Centroid[axis] - range.Centroids.Min[axis]) * scale[axis]);
+			return (std::min)(bin, numBins - 1);
+		};
+
+		int bestAxis = -1;
+		uint32 bestBin = 0;
+		if (scale[0] > 0.0f || scale[1] > 0.0f || scale[2] > 0.0f)
+		{
+			// Only the top levels bin in parallel, the subtrees keep theirs on the stack.
+			BinSet binSet;
+			std::vector<BinSet> partialBins(bParallel && end - begin > ParallelRangeSize ? ThreadUtil::GetWorkerCount() : 0);
+			ForRange(begin, end, !partialBins.empty(), [&](uint32 rangeBegin, uint32 rangeEnd, uint32 worker)
+			{
+				BinSet& bins = partialBins.empty() ? binSet : partialBins[worker];
+				for (uint32 i = rangeBegin; i < rangeEnd; ++i)
+				{
+					const Primitive& primitive = m_primitives[i];
+					for (int axis = 0; axis < 3; ++axis)
+					{
+						Bin& bin = bins.Bins[axis][getBin(primitive, axis)];
+						bin.Bounds.Grow(primitive.Bounds);
+						++bin.Count;
+					}
+				}
+			});
+			for (auto& partial : partialBins)
+				binSet.Merge(partial);
+
+			// Cost of splitting after bin b: area(left) * count(left) + area(right) * count(right).
+			float bestCost = std::numeric_limits<float>::max();
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				if (scale[axis] == 0.0f)
+					continue;
+
+				float rightCosts[NumBins];
+				Bin rightBins;
+				for (uint32 b = numBins - 1; b > 0; --b)
+				{
+					rightBins.Merge(binSet.Bins[axis][b]);
+					rightCosts[b - 1] = rightBins.Count > 0 ? rightBins.Bounds.GetHalfArea() * rightBins.Count : -1.0f;
+				}
+
+				Bin leftBins;
+				for (uint32 b = 0; b + 1 < numBins; ++b)
+				{
+					leftBins.Merge(binSet.Bins[axis][b]);
+					if (leftBins.Count == 0 || rightCosts[b] < 0.0f)
+						continue;
+					float cost = leftBins.Bounds.GetHalfArea() * leftBins.Count + rightCosts[b];
+					if (cost < bestCost)
+					{
+						bestCost = cost;
+						bestAxis = axis;
+						bestBin = b;
+					}
+				}
+			}
+
+		}
+
+		// Every centroid is the same point, halve the range.
+		if (bestAxis < 0)
+		{
+			uint32 middle = begin + (end - begin) / 2;
+			left = ComputeRange(begin, middle, bParallel);
+			right = ComputeRange(middle, end, bParallel);
+			return middle;
+		}
+
+		// Hoare partition, the primitives are accumulated into their side as they are visited.
+		auto isLeft = [&](const Primitive& primitive) { return getBin(primitive, bestAxis) <= bestBin; };
+		uint32 i = begin, j = end;
+		for (;;)
+		{
+			while (i < j && isLeft(m_primitives[i]))
+				left.Add(m_primitives[i++]);
+			while (i < j && !isLeft(m_primitives[j - 1]))
+				right.Add(m_primitives[--j]);
+			if (i >= j)
+				break;
+			std::swap(m_primitives[i], m_primitives[j - 1]);
+			left.Add(m_primitives[i++]);
+			right.Add(m_primitives[--j]);
+		}
+		return i;
+	}
+
+	std::vector<Primitive> m_primitives;
+};
+
+void BVH::Build(const std::vector<BVHBounds>& bounds)
+{
+	auto startTime = std::chrono::high_resolution_clock::now();
+	Clear();
+	if (bounds.empty())
+		return;
+
+	const uint32 numPrimitives = (uint32)bounds.size();
+	Builder builder(bounds);
+
+	// Top levels on this thread, a few subtrees per worker below.
+	const uint32 taskSize = (std::max)(numPrimitives / (ThreadUtil::GetWorkerCount() * 8), 4096u);
+	std::vector<BVHNode> topNodes;
+	std::vector<Builder::Task> tasks;
+	builder.BuildNode(topNodes, 0, numPrimitives, 0, builder.ComputeRange(0, numPrimitives, true), &tasks, taskSize);
+
+	// Largest subtrees first.
+	std::vector<uint32> taskOrder(tasks.size());
+	for (uint32 i = 0; i < (uint32)tasks.size(); ++i)
+		taskOrder[i] = i;
+	std::sort(taskOrder.begin(), taskOrder.end(), [&](uint32 a, uint32 b)
+	{
+		return tasks[a].End - tasks[a].Begin > tasks[b].End - tasks[b].Begin;
+	});
+	std::vector<std::vector<BVHNode>> subtrees(tasks.size());
+	ThreadUtil::ParallelFor(tasks.size(), [&](size_t i, uint32)
+	{
+		const Builder::Task& task = tasks[taskOrder[i]];
+		builder.BuildNode(subtrees[taskOrder[i]], task.Begin, task.End, task.Depth, task.Range, nullptr, 0);
+	});
+
+	// Splice the subtrees in place of their placeholders, depth first.
+	size_t numNodes = topNodes.size();
+	for (auto& subtree : subtrees)
+		numNodes += subtree.size() - 1;
+	m_nodes.reserve(numNodes);
+
+	std::function<void(uint32)> emit = [&](uint32 topIndex)
+	{
+		const BVHNode& node = topNodes[topIndex];
+		if (node.Count == SubtreeMarker)
+		{
+			uint32 offset = (uint32)m_nodes.size();
+			for (auto subtreeNode : subtrees[node.RightOrFirst])
+			{
+				if (subtreeNode.Count == 0)
+					subtreeNode.RightOrFirst += offset;
+				m_nodes.push_back(subtreeNode);
+			}
+			return;
+		}
+
+		uint32 nodeIndex = (uint32)m_nodes.size();
+		m_nodes.push_back(node);
+		if (node.Count > 0)
+			return;
+		emit(topIndex + 1);
+		m_nodes[nodeIndex].RightOrFirst = (uint32)m_nodes.size();
+		emit(node.RightOrFirst);
+	};
+	emit(0);
+
+	// Leaf order, leaf tests then walk the boxes in order.
+	const std::vector<Primitive>& primitives = builder.GetPrimitives();
+	m_primitiveIndices.resize(numPrimitives);
+	m_primitiveBounds.resize(numPrimitives);
+	ThreadUtil::ParallelFor((numPrimitives + ParallelRangeSize - 1) / ParallelRangeSize, [&](size_t chunk, uint32)
+	{
+		uint32 end = (std::min)((uint32)(chunk + 1) * ParallelRangeSize, numPrimitives);
+		for (uint32 i = (uint32)chunk * ParallelRangeSize; i < end; ++i)
+		{
+			m_primitiveIndices[i] = primitives[i].Index;
+			m_primitiveBounds[i] = primitives[i].Bounds;
+		}
+	});
+
+	m_buildMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+}
+
+void BVH::Clear()
+{
+	m_nodes.clear();
+	m_primitiveIndices.clear();
+	m_primitiveBounds.clear();
+	m_buildMs = 0.0;
+}
+
+size_t BVH::GetBytes() const
+{
+	return m_nodes.capacity() * sizeof(BVHNode) + m_primitiveIndices.capacity() * sizeof(uint32) + m_primitiveBounds.capacity() * sizeof(BVHBounds);
+}
+
+void BVH::QueryFrustum(const BVHPlane* planes, uint32 numPlanes, std::vector<uint32>& hits) const
+{
+	if (m_nodes.empty())
+		return;
+
+	// Planes the node is fully inside of are dropped from the mask, an empty mask takes the whole subtree.
+	struct Entry
+	{
+		uint32 Node;
+		uint32 Mask;
+	};
+	Entry stack[MaxDepth + 1];
+	uint32 stackSize = 0;
+	stack[stackSize++] = { 0, (1u << numPlanes) - 1 };
+
+	while (stackSize > 0)
+	{
+		Entry entry = stack[--stackSize];
+		const BVHNode& node = m_nodes[entry.Node];
+
+		bool bOutside = false;
+		for (uint32 p = 0; p < numPlanes && !bOutside; ++p)
+		{
+			if ((entry.Mask & (1u << p)) == 0)
+				continue;
+			const BVHPlane& plane = planes[p];
+			float farthest = plane.Distance, nearest = plane.Distance;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				float a = plane.Normal[axis] * node.Min[axis];
+				float b = plane.Normal[axis] * node.Max[axis];
+				farthest += (std::max)(a, b);
+				nearest += (std::min)(a, b);
+			}
+			if (farthest < 0.0f)
+				bOutside = true;
+			else if (nearest >= 0.0f)
+				entry.Mask &= ~(1u << p);
+		}
+		if (bOutside)
+			continue;
+
+		if (entry.Mask == 0)
+		{
+			// Leaves of a subtree cover a contiguous range, from its leftmost to its rightmost leaf.
+			uint32 first = entry.Node, last = entry.Node;
+			while (m_nodes[first].Count == 0)
+				++first;
+			while (m_nodes[last].Count == 0)
+				last = m_nodes[last].RightOrFirst;
+			hits.insert(hits.end(), m_primitiveIndices.begin() + m_nodes[first].RightOrFirst,
+				m_primitiveIndices.begin() + m_nodes[last].RightOrFirst + m_nodes[last].Count);
+			continue;
+		}
+
+		if (node.Count > 0)
+		{
+			for (uint32 i = node.RightOrFirst; i < node.RightOrFirst + node.Count; ++i)
+			{
+				const BVHBounds& box = m_primitiveBounds[i];
+				bool bInside = true;
+				for (uint32 p = 0; p < numPlanes && bInside; ++p)
+				{
+					if ((entry.Mask & (1u << p)) == 0)
+						continue;
+					const BVHPlane& plane = planes[p];
+					float farthest = plane.Distance;
+					for (int axis = 0; axis < 3; ++axis)
+						farthest += (std::max)(plane.Normal[axis] * box.Min[axis], plane.Normal[axis] * box.Max[axis]);
+					bInside = farthest >= 0.0f;
+				}
+				if (bInside)
+					hits.push_back(m_primitiveIndices[i]);
+			}
+			continue;
+		}
+
+		stack[stackSize++] = { node.RightOrFirst, entry.Mask };
+		stack[stackSize++] = { entry.Node + 1, entry.Mask };
+	}
+}
+
+void BVH::QueryOverlap(const BVHBounds& box, std::vector<uint32>& hits) const
+{
+	if (m_nodes.empty())
+		return;
+
+	uint32 stack[MaxDepth + 1];
+	uint32 stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		uint32 nodeIndex = stack[--stackSize];
+		const BVHNode& node = m_nodes[nodeIndex];
+		if (node.Min[0] > box.Max[0] || node.Max[0] < box.Min[0] ||
+			node.Min[1] > box.Max[1] || node.Max[1] < box.Min[1] ||
+			node.Min[2] > box.Max[2] || node.Max[2] < box.Min[2])
+			continue;
+
+		if (node.Count > 0)
+		{
+			for (uint32 i = node.RightOrFirst; i < node.RightOrFirst + node.Count; ++i)
+			{
+				if (m_primitiveBounds[i].Overlaps(box))
+					hits.push_back(m_primitiveIndices[i]);
+			}
+			continue;
+		}
+
+		stack[stackSize++] = node.RightOrFirst;
+		stack[stackSize++] = nodeIndex + 1;
+	}
+}
+
+int32 BVH::RayCast(const float origin[3], const float direction[3], float& tHit, float tMax) const
+{
+	BVHRayHit hit;
+	if (RayCast(origin, direction, &hit, 1, tMax) == 0)
+		return -1;
+	tHit = hit.T;
+	return (int32)hit.Primitive;
+}
+
+uint32 BVH::RayCast(const float origin[3], const float direction[3], BVHRayHit* hits, uint32 maxHits, float tMax) const
+{
+	uint32 numHits = 0;
+	if (m_nodes.empty() || maxHits == 0)
+		return numHits;
+
+	float invDirection[3];
+	for (int axis = 0; axis < 3; ++axis)
+		invDirection[axis] = 1.0f / direction[axis];
+
+	float tEnter;
+	if (!IntersectRay(m_nodes[0].Min, m_nodes[0].Max, origin, invDirection, tMax, tEnter))
+		return numHits;
+
+	// Nearest child first. hits stays sorted, once it is full nodes entered after the last one are skipped.
+	struct Entry
+	{
+		uint32 Node;
+		float TEnter;
+	};
+	Entry stack[MaxDepth + 1];
+	uint32 stackSize = 0;
+	stack[stackSize++] = { 0, tEnter };
+
+	while (stackSize > 0)
+	{
+		Entry entry = stack[--stackSize];
+		if (entry.TEnter > tMax)
+			continue;
+		const BVHNode& node = m_nodes[entry.Node];
+
+		if (node.Count > 0)
+		{
+			for (uint32 i = node.RightOrFirst; i < node.RightOrFirst + node.Count; ++i)
+			{
+				const BVHBounds& box = m_primitiveBounds[i];
+				if (!IntersectRay(box.Min, box.Max, origin, invDirection, tMax, tEnter) || (numHits == maxHits && tEnter >= tMax))
+					continue;
+
+				uint32 slot = numHits < maxHits ? numHits++ : maxHits - 1;
+				for (; slot > 0 && hits[slot - 1].T > tEnter; --slot)
+					hits[slot] = hits[slot - 1];
+				hits[slot].Primitive = m_primitiveIndices[i];
+				hits[slot].T = tEnter;
+				hits[slot].Bounds = box;
+				if (numHits == maxHits)
+					tMax = hits[maxHits - 1].T;
+			}
+			continue;
+		}
+
+		uint32 left = entry.Node + 1, right = node.RightOrFirst;
+		float tLeft, tRight;
+		bool bLeft = IntersectRay(m_nodes[left].Min, m_nodes[left].Max, origin, invDirection, tMax, tLeft);
+		bool bRight = IntersectRay(m_nodes[right].Min, m_nodes[right].Max, origin, invDirection, tMax, tRight);
+		if (bLeft && bRight)
+		{
+			if (tLeft > tRight)
+			{
+				std::swap(left, right);
+				std::swap(tLeft, tRight);
+			}
+			stack[stackSize++] = { right, tRight };
+			stack[stackSize++] = { left, tLeft };
+		}
+		else if (bLeft)
+			stack[stackSize++] = { left, tLeft };
+		else if (bRight)
+			stack[stackSize++] = { right, tRight };
+	}
+
+	return numHits;
+}
@@ -0,0 +1,125 @@
+//
+// BVHManager.h
+//
+
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include "TypeDef.h"
+
+namespace DX
+{
+	namespace BVHManager
+	{
+		struct BVHBounds
+		{
+			float Min[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+			float Max[3] = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+
+			void Grow(const BVHBounds& other)
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					Min[axis] = (std::min)(Min[axis], other.Min[axis]);
+					Max[axis] = (std::max)(Max[axis], other.Max[axis]);
+				}
+			}
+
+			void Grow(const float point[3])
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					Min[axis] = (std::min)(Min[axis], point[axis]);
+					Max[axis] = (std::max)(Max[axis], point[axis]);
+				}
+			}
+
+			bool IsValid() const { return Min[0] <= Max[0] && Min[1] <= Max[1] && Min[2] <= Max[2]; }
+
+			// Half the surface area, the SAH only compares ratios.
+			float GetHalfArea() const
+			{
+				if (!IsValid())
+					return 0.0f;
+				float x = Max[0] - Min[0], y = Max[1] - Min[1], z = Max[2] - Min[2];
+				return x * y + y * z + z * x;
+			}
+
+			bool Overlaps(const BVHBounds& other) const
+			{
+				return Min[0] <= other.Max[0] && Max[0] >= other.Min[0] &&
+					Min[1] <= other.Max[1] && Max[1] >= other.Min[1] &&
+					Min[2] <= other.Max[2] && Max[2] >= other.Min[2];
+			}
+		};
+
+		// 32 bytes. Nodes are stored depth first, the left child of an interior node is the next node.
+		struct BVHNode
+		{
+			float Min[3];
+			uint32 RightOrFirst;	// Interior: right child node. Leaf: first entry in the primitive indices.
+			float Max[3];
+			uint32 Count;			// Leaf: number of primitives, 0 for interior nodes.
+		};
+
+		// Points p with Dot(Normal, p) + Distance >= 0 are inside.
+		struct BVHPlane
+		{
+			float Normal[3];
+			float Distance;
+		};
+
+		// One box entered by a ray, T is 0 when the origin is inside.
+		struct BVHRayHit
+		{
+			uint32 Primitive = 0;
+			float T = 0.0f;
+			BVHBounds Bounds;
+		};
+
+		// Bounding volume hierarchy over axis aligned boxes, the primitive ids are the indices of the boxes given to Build.
+		// Binned SAH, the top levels are split on the calling thread (binning in parallel), the subtrees below are then
+		// built on all the cores and spliced into one flattened node array. Queries are read only and thread safe.
+		class BVH
+		{
+		public:
+
+			void Build(const std::vector<BVHBounds>& bounds);
+			void Clear();
+
+			// Primitives inside or crossing all the planes (conservative, box against plane).
+			void QueryFrustum(const BVHPlane* planes, uint32 numPlanes, std::vector<uint32>& hits) const;
+
+			// Primitives overlapping the box.
+			void QueryOverlap(const BVHBounds& box, std::vector<uint32>& hits) const;
+
+			// Closest primitive whose box the ray enters within [0, tMax], -1 if none. tHit is 0 when the origin is inside.
+			int32 RayCast(const float origin[3], const float direction[3], float& tHit, float tMax = std::numeric_limits<float>::max()) const;
+
+			// The (up to) maxHits closest primitives entered within [0, tMax], nearest first, returns their number.
+			uint32 RayCast(const float origin[3], const float direction[3], BVHRayHit* hits, uint32 maxHits, float tMax = std::numeric_limits<float>::max()) const;
+
+			const std::vector<BVHNode>& GetNodes() const { return m_nodes; }
+			const std::vector<uint32>& GetPrimitiveIndices() const { return m_primitiveIndices; }
+			size_t GetNumPrimitives() const { return m_primitiveBounds.size(); }
+			size_t GetBytes() const;
+			double GetBuildMs() const { return m_buildMs; }
+
+			static const uint32 NumBins = 16;
+			static const uint32 MaxLeafSize = 4;
+			static const uint32 MaxDepth = 64;
+
+		private:
+
+			class Builder;
+
+			std::vector<BVHNode> m_nodes;
+			std::vector<uint32> m_primitiveIndices;
+			// Leaf tests read the boxes in leaf order.
+			std::vector<BVHBounds> m_primitiveBounds;
+			double m_buildMs = 0.0;
+		};
+	}
+}
@@ -0,0 +1,208 @@
+//
+// CullingManager.cpp
+//
+
+#include "CullingManager.h"
+#include "ThreadManager.h"
+#include <algorithm>
+#include <bitset>
+#include <xmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace DX;
+using namespace DX::CullingManager;
+using namespace DX::ThreadManager;
+
+namespace
+{
+	inline uint32 CountTrailingZeros(uint32 word)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, word);
+		return (uint32)index;
+#else
+		return (uint32)__builtin_ctz(word);
+#endif
+	}
+
+	inline uint32 CountBits(uint32 word)
+	{
+		return (uint32)std::bitset<32>(word).count();
+	}
+}
+
+void BoundsSoA::Resize(size_t size)
+{
+	MinX.resize(size);
+	MinY.resize(size);
+	MinZ.resize(size);
+	MaxX.resize(size);
+	MaxY.resize(size);
+	MaxZ.resize(size);
+}
+
+void BoundsSoA::Set(size_t index, const float min[3], const float max[3])
+{
+	MinX[index] = min[0];
+	MinY[index] = min[1];
+	MinZ[index] = min[2];
+	MaxX[index] = max[0];
+	MaxY[index] = max[1];
+	MaxZ[index] = max[2];
+}
+
+FrustumCuller::FrustumCuller(const Math::Frustum& frustum)
+{
+	for (uint32 plane = 0; plane < NumPlanes; ++plane)
+	{
+		Math::Vector4 equation = Math::Vector4(frustum.GetFrustumPlane((Math::Frustum::PlaneID)plane));
+		m_normals[plane][0] = equation.GetX();
+		m_normals[plane][1] = equation.GetY();
+		m_normals[plane][2] = equation.GetZ();
+		m_distances[plane] = equation.GetW();
+		for (int axis = 0; axis < 3; ++axis)
+			m_bMaxCorner[plane][axis] = m_normals[plane][axis] > 0.0f;
+	}
+}
+
+void FrustumCuller::CullMask(const BoundsSoA& bounds, size_t begin, size_t end, uint32* mask) const
+{
+	std::fill(mask, mask + (end - begin + 31) / 32, 0u);
+
+	// 8 boxes per step, two SSE groups of 4, each plane only reads the corner farthest along its normal.
+	const __m128 zero = _mm_setzero_ps();
+	size_t i = begin;
+	for (; i + 8 <= end; i += 8)
+	{
+		__m128 inside0 = _mm_cmpeq_ps(zero, zero);
+		__m128 inside1 = inside0;
+		for (uint32 plane = 0; plane < NumPlanes; ++plane)
+		{
+			const float* x = m_bMaxCorner[plane][0] ? &bounds.MaxX[i] : &bounds.MinX[i];
+			const float* y = m_bMaxCorner[plane][1] ? &bounds.MaxY[i] : &bounds.MinY[i];
+			const float* z = m_bMaxCorner[plane][2] ? &bounds.MaxZ[i] : &bounds.MinZ[i];
+			const __m128 nx = _mm_set1_ps(m_normals[plane][0]);
+			const __m128 ny = _mm_set1_ps(m_normals[plane][1]);
+			const __m128 nz = _mm_set1_ps(m_normals[plane][2]);
+			const __m128 d = _mm_set1_ps(m_distances[plane]);
+
+			__m128 distance0 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, _mm_loadu_ps(x)), _mm_mul_ps(ny, _mm_loadu_ps(y))),
+				_mm_add_ps(_mm_mul_ps(nz, _mm_loadu_ps(z)), d));
+			__m128 distance1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, _mm_loadu_ps(x + 4)), _mm_mul_ps(ny, _mm_loadu_ps(y + 4))),
+				_mm_add_ps(_mm_mul_ps(nz, _mm_loadu_ps(z + 4)), d));
+			inside0 = _mm_and_ps(inside0, _mm_cmpge_ps(distance0, zero));
+			inside1 = _mm_and_ps(inside1, _mm_cmpge_ps(distance1, zero));
+
+			if (_mm_movemask_ps(_mm_or_ps(inside0, inside1)) == 0)
+				break;
+		}
+
+		uint32 bits = (uint32)_mm_movemask_ps(inside0) | ((uint32)_mm_movemask_ps(inside1) << 4);
+		size_t offset = i - begin;
+		mask[offset / 32] |= bits << (offset % 32);
+	}
+
+	for (; i < end; ++i)
+	{
+		bool bInside = true;
+		for (uint32 plane = 0; plane < NumPlanes && bInside; ++plane)
+		{
+			float x = m_bMaxCorner[plane][0] ? bounds.MaxX[i] : bounds.MinX[i];
+			float y = m_bMaxCorner[plane][1] ? bounds.MaxY[i] : bounds.MinY[i];
+			float z = m_bMaxCorner[plane][2] ? bounds.MaxZ[i] : bounds.MinZ[i];
+			bInside = m_normals[plane][0] * x + m_normals[plane][1] * y + (m_normals[plane][2] * z + m_distances[plane]) >= 0.0f;
+		}
+		if (bInside)
+		{
+			size_t offset = i - begin;
+			mask[offset / 32] |= 1u << (offset % 32);
+		}
+	}
+}
+
+size_t FrustumCuller::CullIndices(const BoundsSoA& bounds, size_t begin, size_t end, uint32* out) const
+{
+	std::vector<uint32> mask((end - begin + 31) / 32);
+	CullMask(bounds, begin, end, mask.data());
+
+	size_t count = 0;
+	for (size_t word = 0; word < mask.size(); ++word)
+	{
+		for (uint32 bits = mask[word]; bits != 0; bits &= bits - 1)
+			out[count++] = (uint32)(begin + word * 32 + CountTrailingZeros(bits));
+	}
+	return count;
+}
+
+void FrustumCuller::CullIndices(const BoundsSoA& bounds, std::vector<uint32>& visible) const
+{
+	const size_t numBoxes = bounds.Size();
+	const size_t numChunks = (numBoxes + ChunkSize - 1) / ChunkSize;
+	const size_t chunkWords = ChunkSize / 32;
+
+	// Masks then counts per chunk, the prefix sum places every chunk's indices.
+	std::vector<uint32> mask((numBoxes + 31) / 32);
+	std::vector<size_t> offsets(numChunks + 1, 0);
+	ThreadUtil::ParallelFor(numChunks, [&](size_t chunk, uint32)
+	{
+		size_t begin = chunk * ChunkSize;
+		size_t end = (std::min)(begin + ChunkSize, numBoxes);
+		uint32* words = mask.data() + chunk * chunkWords;
+		CullMask(bounds, begin, end, words);
+
+		size_t count = 0;
+		for (size_t word = 0; word < (end - begin + 31) / 32; ++word)
+			count += CountBits(words[word]);
+		offsets[chunk + 1] = count;
+	});
+	for (size_t chunk = 0; chunk < numChunks; ++chunk)
+		offsets[chunk + 1] += offsets[chunk];
+
+	visible.resize(offsets[numChunks]);
+	ThreadUtil::ParallelFor(numChunks, [&](size_t chunk, uint32)
+	{
+		size_t begin = chunk * ChunkSize;
+		size_t end = (std::min)(begin + ChunkSize, numBoxes);
+		const uint32* words = mask.data() + chunk * chunkWords;
+		uint32* out = visible.data() + offsets[chunk];
+		for (size_t word = 0; word < (end - begin + 31) / 32; ++word)
+		{
+			for (uint32 bits = words[word]; bits != 0; bits &= bits - 1)
+				*out++ = (uint32)(begin + word * 32 + CountTrailingZeros(bits));
+		}
+	});
+}
+
+void DX::CullingManager::CoalesceIndices(const std::vector<uint32>& indices, uint32 maxRanges, std::vector<IndexRange>& ranges)
+{
+	ranges.clear();
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		if (!ranges.empty() && ranges.back().First + ranges.back().Count == indices[i])
+			++ranges.back().Count;
+		else ranges.push_back({ indices[i], 1 });
+	}
+	if (ranges.size() <= maxRanges || maxRanges == 0)
+		return;
+
+	// The gap every merge must close, the (n - maxRanges) smallest ones.
+	std::vector<uint32> gaps(ranges.size() - 1);
+	for (size_t i = 0; i + 1 < ranges.size(); ++i)
+		gaps[i] = ranges[i + 1].First - (ranges[i].First + ranges[i].Count);
+	size_t numMerges = ranges.size() - maxRanges;
+	std::nth_element(gaps.begin(), gaps.begin() + (numMerges - 1), gaps.end());
+	const uint32 maxGap = gaps[numMerges - 1];
+
+	size_t last = 0;
+	for (size_t i = 1; i < ranges.size(); ++i)
+	{
+		IndexRange& range = ranges[last];
+		if (ranges[i].First - (range.First + range.Count) <= maxGap)
+			range.Count = ranges[i].First + ranges[i].Count - range.First;
+		else ranges[++last] = ranges[i];
+	}
+	ranges.resize(last + 1);
+}
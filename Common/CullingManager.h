@@ -0,0 +1,66 @@
+//
+// CullingManager.h
+//
+
+#pragma once
+
+#include <vector>
+#include "TypeDef.h"
+#include "../Math/Frustum.h"
+
+namespace DX
+{
+	namespace CullingManager
+	{
+		// Axis aligned boxes as one array per component, the batch tests load 4 boxes per component at a time.
+		struct BoundsSoA
+		{
+			std::vector<float> MinX, MinY, MinZ;
+			std::vector<float> MaxX, MaxY, MaxZ;
+
+			size_t Size() const { return MinX.size(); }
+			void Resize(size_t size);
+			void Set(size_t index, const float min[3], const float max[3]);
+		};
+
+		// [First, First + Count) of a sorted index list.
+		struct IndexRange
+		{
+			uint32 First;
+			uint32 Count;
+		};
+
+		// Tests boxes against the 6 planes of a frustum (inside or crossing all of them, conservative),
+		// SSE 4 boxes at a time, 8 per step. The planes and the boxes must be in the same space.
+		class FrustumCuller
+		{
+		public:
+
+			explicit FrustumCuller(const Math::Frustum& frustum);
+
+			// Bit (i - begin) % 32 of mask[(i - begin) / 32] is set when box i in [begin, end) is visible.
+			// mask holds (end - begin + 31) / 32 words.
+			void CullMask(const BoundsSoA& bounds, size_t begin, size_t end, uint32* mask) const;
+
+			// Visible boxes of [begin, end) in increasing order, out holds end - begin entries. Returns their number.
+			size_t CullIndices(const BoundsSoA& bounds, size_t begin, size_t end, uint32* out) const;
+
+			// Every box on all the cores, visible gets the indices in increasing order.
+			void CullIndices(const BoundsSoA& bounds, std::vector<uint32>& visible) const;
+
+			static const uint32 NumPlanes = 6;
+			static const uint32 ChunkSize = 64 * 1024;
+
+		private:
+
+			// Per plane, the normal, the distance, and for each axis whether the farthest corner along the normal is the max.
+			float m_normals[NumPlanes][3];
+			float m_distances[NumPlanes];
+			bool m_bMaxCorner[NumPlanes][3];
+		};
+
+		// Merges the runs of consecutive indices of a sorted list into at most maxRanges ranges, the smallest gaps
+		// are closed first (the indices in them are covered too).
+		void CoalesceIndices(const std::vector<uint32>& indices, uint32 maxRanges, std::vector<IndexRange>& ranges);
+	}
+}
@@ -96,6 +96,11 @@ namespace DX
 			else if (std::is_same<StructureBuffer, TConstantType>::value) m_structureBuffer->CopyData<TConstantType>(elementIndex, data);
 		}
 
+		void CopyStructureBuffer(int firstElementIndex, const StructureBuffer* data, UINT elementCount)
+		{
+			m_structureBuffer->CopyData(firstElementIndex, data, elementCount);
+		}
+
 		template<typename TConstantType>
 		D3D12_GPU_VIRTUAL_ADDRESS GetBufferGPUVirtualAddress()
 		{
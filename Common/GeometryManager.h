@@ -53,6 +53,13 @@ namespace DX
 			DXGI_FORMAT IndexFormat = DXGI_FORMAT_R16_UINT;
 			uint32 IndexBufferByteSize = 0;
 
+			// Optional per instance vertex stream, bound to slot 1 when present.
+			ComPtr<ID3DBlob> InstanceBufferCPU = nullptr;
+			ComPtr<ID3D12Resource> InstanceBufferGPU = nullptr;
+			ComPtr<ID3D12Resource> InstanceBufferUploader = nullptr;
+			uint32 InstanceByteStride = 0;
+			uint32 InstanceBufferByteSize = 0;
+
 			// A MeshGeometry may store multiple geometries in one vertex/index buffer.
 			// Use this container to define the Submesh geometries so we can draw
 			// the Submeshes individually.
@@ -78,11 +85,22 @@ namespace DX
 				return ibv;
 			}
 
+			D3D12_VERTEX_BUFFER_VIEW InstanceBufferView() const
+			{
+				D3D12_VERTEX_BUFFER_VIEW vbv;
+				vbv.BufferLocation = InstanceBufferGPU->GetGPUVirtualAddress();
+				vbv.StrideInBytes = InstanceByteStride;
+				vbv.SizeInBytes = InstanceBufferByteSize;
+
+				return vbv;
+			}
+
 			// We can free this memory after we finish upload to the GPU.
 			void DisposeUploaders()
 			{
 				VertexBufferUploader = nullptr;
 				IndexBufferUploader = nullptr;
+				InstanceBufferUploader = nullptr;
 			}
 		};
 
@@ -124,28 +142,41 @@ namespace DX
 			///////////////////////////////////////////////////////
 			// Custom Data Field. / Per FScene Structure Buffer Offset.
 			int PerFSceneSBufferOffset = 0;
+			// Visible part of the geometry, drawn instead of the DrawArgs when bDrawCulled.
+			std::vector<SubmeshGeometry> CulledDrawArgs;
+			bool bDrawCulled = false;
 			///////////////////////////////////////////////////////
 
 			// NOTE: NO SubmeshGeometry.
 			template<typename _T1, typename _T2>
 			void CreateCommonGeometry(DeviceResources* deviceResources, const std::string& name, const std::vector< _T1>& vertices, const std::vector< _T2>& indices)
 			{
-				const UINT vbByteSize = (UINT)vertices.size() * sizeof(_T1);
-				const UINT ibByteSize = (UINT)indices.size() * sizeof(_T2);
+				CreateCommonGeometry<_T1, _T2>(deviceResources, name, vertices.size(), indices.size(), [&](_T1* vertexData, _T2* indexData)
+				{
+					std::copy(vertices.begin(), vertices.end(), vertexData);
+					std::copy(indices.begin(), indices.end(), indexData);
+				});
+			}
+
+			// Same, fill(vertexData, indexData) writes the numVertices / numIndices elements straight into the CPU copies,
+			// which are then uploaded. Nothing else holds the geometry.
+			template<typename _T1, typename _T2, typename TLambda>
+			void CreateCommonGeometry(DeviceResources* deviceResources, const std::string& name, size_t numVertices, size_t numIndices, const TLambda& fill)
+			{
+				const UINT vbByteSize = (UINT)numVertices * sizeof(_T1);
+				const UINT ibByteSize = (UINT)numIndices * sizeof(_T2);
 
 				Name = name;
 
 				Geometry = std::make_unique<MeshGeometry>();
 
 				ThrowIfFailed(D3DCreateBlob(vbByteSize, &Geometry->VertexBufferCPU));
-				CopyMemory(Geometry->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
 				ThrowIfFailed(D3DCreateBlob(ibByteSize, &Geometry->IndexBufferCPU));
-				CopyMemory(Geometry->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+				fill(reinterpret_cast<_T1*>(Geometry->VertexBufferCPU->GetBufferPointer()), reinterpret_cast<_T2*>(Geometry->IndexBufferCPU->GetBufferPointer()));
 
-				deviceResources->CreateDefaultBuffer(vertices.data(), vbByteSize,
+				deviceResources->CreateDefaultBuffer(Geometry->VertexBufferCPU->GetBufferPointer(), vbByteSize,
 					&Geometry->VertexBufferGPU, &Geometry->VertexBufferUploader);
-				deviceResources->CreateDefaultBuffer(indices.data(), ibByteSize,
+				deviceResources->CreateDefaultBuffer(Geometry->IndexBufferCPU->GetBufferPointer(), ibByteSize,
 					&Geometry->IndexBufferGPU, &Geometry->IndexBufferUploader);
 
 				// Vertex Buffer View Data.
@@ -160,7 +191,7 @@ namespace DX
 				Geometry->IndexBufferByteSize = ibByteSize;
 
 				SubmeshGeometry submesh;
-				submesh.IndexCountPerInstance = (UINT)indices.size();
+				submesh.IndexCountPerInstance = (UINT)numIndices;
 				submesh.InstanceCount = 1;
 				submesh.StartIndexLocation = 0;
 				submesh.BaseVertexLocation = 0;
@@ -168,26 +199,61 @@ namespace DX
 
 				Geometry->DrawArgs[name] = submesh;
 			}
+
+			// Adds the per instance stream to the geometry of CreateCommonGeometry, every draw of it is
+			// instances.size() instances of the whole index buffer.
+			template<typename _T>
+			void CreateInstanceStream(DeviceResources* deviceResources, const std::vector<_T>& instances)
+			{
+				const UINT byteSize = (UINT)instances.size() * sizeof(_T);
+
+				ThrowIfFailed(D3DCreateBlob(byteSize, &Geometry->InstanceBufferCPU));
+				CopyMemory(Geometry->InstanceBufferCPU->GetBufferPointer(), instances.data(), byteSize);
+
+				deviceResources->CreateDefaultBuffer(instances.data(), byteSize,
+					&Geometry->InstanceBufferGPU, &Geometry->InstanceBufferUploader);
+
+				Geometry->InstanceByteStride = sizeof(_T);
+				Geometry->InstanceBufferByteSize = byteSize;
+
+				for (auto& e : Geometry->DrawArgs)
+					e.second.InstanceCount = (uint32)instances.size();
+			}
 							
 			template<typename TLambda = PFVOID>
 			void Draw(ID3D12GraphicsCommandList* commandList, const TLambda& lambda = defalut)
 			{
-				commandList->IASetVertexBuffers(0, 1, &Geometry->VertexBufferView());
+				if (Geometry->InstanceBufferGPU != nullptr)
+				{
+					D3D12_VERTEX_BUFFER_VIEW views[2] = { Geometry->VertexBufferView(), Geometry->InstanceBufferView() };
+					commandList->IASetVertexBuffers(0, 2, views);
+				}
+				else
+					commandList->IASetVertexBuffers(0, 1, &Geometry->VertexBufferView());
 				commandList->IASetIndexBuffer(&Geometry->IndexBufferView());
 				commandList->IASetPrimitiveTopology(PrimitiveType);
 
 				// Set/Bind Per Object Data.
 				lambda();
 				
-				for (auto& e : Geometry->DrawArgs)
+				auto drawSubmesh = [commandList](const SubmeshGeometry& submesh)
 				{
-					SubmeshGeometry& submesh = e.second;
 					commandList->DrawIndexedInstanced(submesh.IndexCountPerInstance,
 						submesh.InstanceCount,
 						submesh.StartIndexLocation,
 						submesh.BaseVertexLocation,
 						submesh.StartInstanceLocation);
+				};
+
+				if (bDrawCulled)
+				{
+					for (auto& submesh : CulledDrawArgs)
+						drawSubmesh(submesh);
+					return;
 				}
+
+				for (auto& e : Geometry->DrawArgs)
+					drawSubmesh(e.second);
 			}
 
 		private:
@@ -0,0 +1,175 @@
+//
+// ImageManager.cpp
+//
+
+#include "ImageManager.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+using namespace DX;
+using namespace DX::ImageManager;
+
+namespace
+{
+	// Largest payload of a stored deflate block.
+	const uint32 MaxStoredBlock = 65535;
+
+	struct Crc32Table
+	{
+		uint32 Values[256];
+
+		Crc32Table()
+		{
+			for (uint32 n = 0; n < 256; ++n)
+			{
+				uint32 c = n;
+				for (int k = 0; k < 8; ++k)
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				Values[n] = c;
+			}
+		}
+	};
+
+	void AppendBigEndian(std::vector<uint8>& bytes, uint32 value)
+	{
+		bytes.push_back((uint8)(value >> 24));
+		bytes.push_back((uint8)(value >> 16));
+		bytes.push_back((uint8)(value >> 8));
+		bytes.push_back((uint8)value);
+	}
+
+	void WriteChunk(std::ofstream& fout, const char type[4], const std::vector<uint8>& data)
+	{
+		std::vector<uint8> chunk;
+		chunk.reserve(data.size() + 12);
+		AppendBigEndian(chunk, (uint32)data.size());
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data.begin(), data.end());
+		AppendBigEndian(chunk, ImageUtil::Crc32(chunk.data() + 4, chunk.size() - 4));
+		fout.write((const char*)chunk.data(), chunk.size());
+	}
+}
+
+bool ImageUtil::WritePFM(const std::wstring& path, uint32 width, uint32 height, uint32 channels, const float* pixels)
+{
+	if (channels != 1 && channels != 3 && channels != 4)
+		return false;
+
+	std::ofstream fout(path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+	if (!fout.good())
+		return false;
+
+	// A negative scale means little endian. The rows go from the bottom to the top.
+	char header[64];
+	int length = std::snprintf(header, sizeof(header), "%s\n%u %u\n-1.0\n", channels == 1 ? "Pf" : "PF", width, height);
+	fout.write(header, length);
+	const size_t rowFloats = (size_t)width * channels;
+	std::vector<float> rgb(channels == 4 ? (size_t)width * 3 : 0);
+	for (uint32 row = height; row-- > 0;)
+	{
+		const float* rowPixels = pixels + row * rowFloats;
+		if (channels != 4)
+		{
+			fout.write((const char*)rowPixels, rowFloats * sizeof(float));
+			continue;
+		}
+		for (uint32 x = 0; x < width; ++x)
+			std::copy(rowPixels + x * 4, rowPixels + x * 4 + 3, rgb.begin() + x * 3);
+		fout.write((const char*)rgb.data(), rgb.size() * sizeof(float));
+	}
+
+	fout.close();
+	return !fout.fail();
+}
+
+bool ImageUtil::WritePNG(const std::wstring& path, uint32 width, uint32 height, uint32 channels, const uint8* pixels)
+{
+	static const uint8 colorTypes[] = { 0, 0, 0, 2, 6 };
+	if (channels != 1 && channels != 3 && channels != 4)
+		return false;
+
+	std::ofstream fout(path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+	if (!fout.good())
+		return false;
+
+	static const uint8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	fout.write((const char*)signature, sizeof(signature));
+
+	std::vector<uint8> header;
+	AppendBigEndian(header, width);
+	AppendBigEndian(header, height);
+	header.push_back(8);					// Bit depth.
+	header.push_back(colorTypes[channels]);
+	header.push_back(0);					// Deflate.
+	header.push_back(0);					// Adaptive filters, every row uses none.
+	header.push_back(0);					// No interlace.
+	WriteChunk(fout, "IHDR", header);
+
+	// Every row is prefixed by its filter type (0, none).
+	const size_t rowBytes = (size_t)width * channels;
+	std::vector<uint8> raw;
+	raw.reserve((rowBytes + 1) * height);
+	for (uint32 row = 0; row < height; ++row)
+	{
+		raw.push_back(0);
+		raw.insert(raw.end(), pixels + row * rowBytes, pixels + (row + 1) * rowBytes);
+	}
+
+	// zlib header (deflate, 32K window, no preset dictionary, check bits), stored blocks, Adler-32.
+	std::vector<uint8> zlib;
+	zlib.reserve(raw.size() + raw.size() / MaxStoredBlock * 5 + 16);
+	zlib.push_back(0x78);
+	zlib.push_back(0x01);
+	size_t offset = 0;
+	do
+	{
+		uint32 blockSize = (uint32)(std::min)((size_t)MaxStoredBlock, raw.size() - offset);
+		bool bFinal = offset + blockSize == raw.size();
+		zlib.push_back(bFinal ? 1 : 0);
+		zlib.push_back((uint8)blockSize);
+		zlib.push_back((uint8)(blockSize >> 8));
+		zlib.push_back((uint8)~blockSize);
+		zlib.push_back((uint8)(~blockSize >> 8));
+		zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+		offset += blockSize;
+	} while (offset < raw.size());
+	AppendBigEndian(zlib, Adler32(raw.data(), raw.size()));
+	WriteChunk(fout, "IDAT", zlib);
+
+	WriteChunk(fout, "IEND", std::vector<uint8>());
+
+	fout.close();
+	return !fout.fail();
+}
+
+uint32 ImageUtil::Crc32(const uint8* data, size_t size, uint32 crc)
+{
+	static const Crc32Table table;
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; ++i)
+		crc = table.Values[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+uint32 ImageUtil::Adler32(const uint8* data, size_t size, uint32 adler)
+{
+	// The sums are reduced every 5552 bytes, the most that can't overflow 32 bits.
+	uint32 a = adler & 0xFFFF, b = adler >> 16;
+	while (size > 0)
+	{
+		size_t block = (std::min)(size, (size_t)5552);
+		for (size_t i = 0; i < block; ++i)
+		{
+			a += data[i];
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+		data += block;
+		size -= block;
+	}
+	return (b << 16) | a;
+}
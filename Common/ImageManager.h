@@ -0,0 +1,30 @@
+//
+// ImageManager.h
+//
+
+#pragma once
+
+#include <string>
+#include "TypeDef.h"
+
+namespace DX
+{
+	namespace ImageManager
+	{
+		// Minimal image writers, no codec dependency. Pixels are row major, the first row is the top one.
+		class ImageUtil
+		{
+		public:
+
+			// Portable float map, channels is 1 ("Pf"), 3 or 4 ("PF", the alpha is dropped), little endian.
+			static bool WritePFM(const std::wstring& path, uint32 width, uint32 height, uint32 channels, const float* pixels);
+
+			// 8 bit PNG, channels is 1 (gray), 3 (RGB) or 4 (RGBA). The zlib stream uses stored (uncompressed)
+			// deflate blocks, every decoder reads them and nothing has to be compressed.
+			static bool WritePNG(const std::wstring& path, uint32 width, uint32 height, uint32 channels, const uint8* pixels);
+
+			static uint32 Crc32(const uint8* data, size_t size, uint32 crc = 0);
+			static uint32 Adler32(const uint8* data, size_t size, uint32 adler = 1);
+		};
+	}
+}
@@ -0,0 +1,105 @@
+//
+// MemoryManager.cpp
+//
+
+#include "MemoryManager.h"
+#include <algorithm>
+
+using namespace DX::MemoryManager;
+
+MemoryArena::MemoryArena(size_t blockSize)
+	: m_blockSize(blockSize)
+{
+}
+
+MemoryArena::~MemoryArena()
+{
+	for (auto& block : m_blocks)
+		::operator delete(block.Data);
+}
+
+void MemoryArena::NewBlock(size_t minSize)
+{
+	Block block;
+	block.Size = (std::max)(m_blockSize, minSize);
+	block.Data = static_cast<byte*>(::operator new(block.Size));
+	m_blocks.push_back(block);
+
+	m_current = block.Data;
+	m_end = block.Data + block.Size;
+	m_bytesReserved += block.Size;
+}
+
+void* MemoryArena::Allocate(size_t size, size_t alignment)
+{
+	size_t padding = (alignment - reinterpret_cast<uintptr_t>(m_current) % alignment) % alignment;
+	if (m_current == nullptr || padding + size > (size_t)(m_end - m_current))
+	{
+		// Larger requests get a block of their own size.
+		NewBlock(size + alignment);
+		padding = (alignment - reinterpret_cast<uintptr_t>(m_current) % alignment) % alignment;
+	}
+
+	void* result = m_current + padding;
+	m_current += padding + size;
+	m_bytesUsed += size;
+
+	return result;
+}
+
+void MemoryArena::Reset()
+{
+	if (m_blocks.empty())
+		return;
+
+	for (size_t i = 1; i < m_blocks.size(); ++i)
+		::operator delete(m_blocks[i].Data);
+	m_blocks.resize(1);
+
+	m_current = m_blocks[0].Data;
+	m_end = m_blocks[0].Data + m_blocks[0].Size;
+	m_bytesUsed = 0;
+	m_bytesReserved = m_blocks[0].Size;
+}
+
+BackgroundReleaser::BackgroundReleaser()
+	: m_thread(&BackgroundReleaser::Run, this)
+{
+}
+
+BackgroundReleaser::~BackgroundReleaser()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStop = true;
+	}
+	m_condition.notify_one();
+	m_thread.join();
+}
+
+void BackgroundReleaser::Push(std::unique_ptr<HolderBase> holder)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push_back(std::move(holder));
+	}
+	m_condition.notify_one();
+}
+
+void BackgroundReleaser::Run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		m_condition.wait(lock, [this]() { return m_bStop || !m_queue.empty(); });
+		if (m_queue.empty())
+			return;
+
+		// Free outside the lock, Release never waits on the frees.
+		std::unique_ptr<HolderBase> holder = std::move(m_queue.front());
+		m_queue.pop_front();
+		lock.unlock();
+		holder.reset();
+		lock.lock();
+	}
+}
@@ -0,0 +1,134 @@
+//
+// MemoryManager.h
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "TypeDef.h"
+
+namespace DX
+{
+	namespace MemoryManager
+	{
+		// Monotonic arena, allocations only bump a pointer and nothing is freed
+		// piece by piece, all the blocks are released at once by Reset or the destructor.
+		// Not thread safe, use one arena per job / worker thread.
+		class MemoryArena
+		{
+		public:
+
+			explicit MemoryArena(size_t blockSize = 256 * 1024);
+			~MemoryArena();
+
+			MemoryArena(const MemoryArena&) = delete;
+			MemoryArena& operator=(const MemoryArena&) = delete;
+
+			void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+			template<typename T>
+			T* Allocate(size_t count) { return static_cast<T*>(Allocate(count * sizeof(T), alignof(T))); }
+
+			// Keep the first block for reuse, release all the others.
+			void Reset();
+
+			size_t GetBytesUsed() const { return m_bytesUsed; }
+			size_t GetBytesReserved() const { return m_bytesReserved; }
+
+		private:
+
+			struct Block
+			{
+				byte* Data;
+				size_t Size;
+			};
+
+			void NewBlock(size_t minSize);
+
+			std::vector<Block> m_blocks;
+			byte* m_current = nullptr;
+			byte* m_end = nullptr;
+			size_t m_blockSize;
+			size_t m_bytesUsed = 0;
+			size_t m_bytesReserved = 0;
+		};
+
+		// STL allocator on top of a MemoryArena, deallocate does nothing.
+		template<typename T>
+		class ArenaAllocator
+		{
+		public:
+
+			using value_type = T;
+
+			ArenaAllocator(MemoryArena* arena) : m_arena(arena) {}
+
+			template<typename U>
+			ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.GetArena()) {}
+
+			T* allocate(size_t count) { return m_arena->Allocate<T>(count); }
+			void deallocate(T*, size_t) {}
+
+			MemoryArena* GetArena() const { return m_arena; }
+
+			template<typename U>
+			bool operator==(const ArenaAllocator<U>& other) const { return m_arena == other.GetArena(); }
+			template<typename U>
+			bool operator!=(const ArenaAllocator<U>& other) const { return m_arena != other.GetArena(); }
+
+		private:
+
+			MemoryArena* m_arena;
+		};
+
+		// One background thread that frees what it is handed, in hand-over order.
+		// The caller returns at once, the destructor frees what is still queued and joins the thread.
+		class BackgroundReleaser
+		{
+		public:
+
+			BackgroundReleaser();
+			~BackgroundReleaser();
+
+			BackgroundReleaser(const BackgroundReleaser&) = delete;
+			BackgroundReleaser& operator=(const BackgroundReleaser&) = delete;
+
+			// Takes the last reference of a large resource.
+			template<typename T>
+			void Release(T&& resource)
+			{
+				Push(std::make_unique<Holder<typename std::decay<T>::type>>(std::move(resource)));
+			}
+
+		private:
+
+			struct HolderBase
+			{
+				virtual ~HolderBase() {}
+			};
+
+			template<typename T>
+			struct Holder : HolderBase
+			{
+				explicit Holder(T&& resource) : Resource(std::move(resource)) {}
+				T Resource;
+			};
+
+			void Push(std::unique_ptr<HolderBase> holder);
+			void Run();
+
+			std::mutex m_mutex;
+			std::condition_variable m_condition;
+			std::deque<std::unique_ptr<HolderBase>> m_queue;
+			bool m_bStop = false;
+			std::thread m_thread;
+		};
+	}
+}
@@ -0,0 +1,351 @@
+//
+// RasterManager.cpp
+//
+
+#include "RasterManager.h"
+#include "ThreadManager.h"
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+
+using namespace DX;
+using namespace DX::RasterManager;
+using namespace DX::ThreadManager;
+using namespace DirectX;
+
+namespace
+{
+	const uint32 VertexChunkSize = 64 * 1024;
+	const uint32 TriangleChunkSize = 16 * 1024;
+	// A clipped triangle has at most 3 + 6 vertices.
+	const uint32 MaxPolygonVertices = 16;
+
+	struct ClipVertex
+	{
+		float X, Y, Z, W;
+	};
+
+	struct TriangleSetup
+	{
+		int32 X[3], Y[3];					// Fixed point, SubPixelBits.
+		int32 MinX, MinY, MaxX, MaxY;		// Pixels whose centre may be covered, inside the target.
+		float Color[4];
+	};
+
+	inline int32 FloorDiv(int32 a, int32 b)
+	{
+		return a >= 0 ? a / b : -((-a + b - 1) / b);
+	}
+
+	inline int32 CeilDiv(int32 a, int32 b)
+	{
+		return -FloorDiv(-a, b);
+	}
+
+	// One Sutherland-Hodgman step, the vertices with distance(v) >= 0 are kept.
+	template<typename TDistance>
+	uint32 ClipPolygon(const ClipVertex* in, uint32 count, ClipVertex* out, const TDistance& distance)
+	{
+		uint32 outCount = 0;
+		for (uint32 i = 0; i < count; ++i)
+		{
+			const ClipVertex& a = in[i];
+			const ClipVertex& b = in[(i + 1) % count];
+			float da = distance(a), db = distance(b);
+			if (da >= 0.0f)
+				out[outCount++] = a;
+			if ((da >= 0.0f) != (db >= 0.0f))
+			{
+				float t = da / (da - db);
+				out[outCount++] = { a.X + (b.X - a.X) * t, a.Y + (b.Y - a.Y) * t, a.Z + (b.Z - a.Z) * t, a.W + (b.W - a.W) * t };
+			}
+		}
+		return outCount;
+	}
+
+	// Adds the triangle to the pixels of [x0, x1] x [y0, y1] (inclusive) it covers.
+	void DrawTriangle(const TriangleSetup& setup, int32 x0, int32 y0, int32 x1, int32 y1, float* pixels, uint32 width)
+	{
+		x0 = (std::max)(x0, setup.MinX);
+		y0 = (std::max)(y0, setup.MinY);
+		x1 = (std::min)(x1, setup.MaxX);
+		y1 = (std::min)(y1, setup.MaxY);
+		if (x0 > x1 || y0 > y1)
+			return;
+
+		// Edge functions at the centre of pixel (x0, y0) and their steps per pixel. They are integers below 2^50
+		// (see GuardBand), exact in doubles. Pixels on a edge belong to the triangle only if it is a top or left edge.
+		const int64 scale = (int64)1 << SoftwareRasterizer::SubPixelBits;
+		const int64 sampleX = x0 * scale + scale / 2, sampleY = y0 * scale + scale / 2;
+		double edges[3], stepsX[3], stepsY[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			int64 ax = setup.X[k], ay = setup.Y[k];
+			int64 dx = setup.X[(k + 1) % 3] - ax, dy = setup.Y[(k + 1) % 3] - ay;
+			bool bTopLeft = dy < 0 || (dy == 0 && dx > 0);
+			edges[k] = (double)(dx * (sampleY - ay) - dy * (sampleX - ax) - (bTopLeft ? 0 : 1));
+			stepsX[k] = (double)(-dy * scale);
+			stepsY[k] = (double)(dx * scale);
+		}
+
+		// RGB added, alpha replaced (SrcBlendAlpha ONE, DestBlendAlpha ZERO).
+		const __m128 color = _mm_loadu_ps(setup.Color);
+		const __m128 alpha = _mm_set_ps(setup.Color[3], 0.0f, 0.0f, 0.0f);
+		const __m128 rgbMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+		auto blend = [&](int32 x, int32 y)
+		{
+			float* pixel = pixels + ((size_t)y * width + x) * 4;
+			__m128 sum = _mm_add_ps(_mm_loadu_ps(pixel), color);
+			_mm_storeu_ps(pixel, _mm_or_ps(_mm_and_ps(sum, rgbMask), alpha));
+		};
+
+		const int32 blockSize = SoftwareRasterizer::BlockSize;
+		const __m128d zero = _mm_setzero_pd();
+		for (int32 by = y0; by <= y1; by = (by / blockSize + 1) * blockSize)
+		{
+			const int32 byEnd = (std::min)(y1, (by / blockSize + 1) * blockSize - 1);
+			for (int32 bx = x0; bx <= x1; bx = (bx / blockSize + 1) * blockSize)
+			{
+				const int32 bxEnd = (std::min)(x1, (bx / blockSize + 1) * blockSize - 1);
+
+				// The block is skipped when it is outside an edge, filled when it is inside all of them.
+				double blockEdges[3];
+				bool bOutside = false, bInside = true;
+				for (int k = 0; k < 3; ++k)
+				{
+					blockEdges[k] = edges[k] + stepsX[k] * (bx - x0) + stepsY[k] * (by - y0);
+					double spanX = stepsX[k] * (bxEnd - bx), spanY = stepsY[k] * (byEnd - by);
+					double minEdge = blockEdges[k] + (std::min)(spanX, 0.0) + (std::min)(spanY, 0.0);
+					double maxEdge = blockEdges[k] + (std::max)(spanX, 0.0) + (std::max)(spanY, 0.0);
+					bOutside |= maxEdge < 0.0;
+					bInside &= minEdge >= 0.0;
+				}
+				if (bOutside)
+					continue;
+
+				if (bInside)
+				{
+					for (int32 y = by; y <= byEnd; ++y)
+					{
+						for (int32 x = bx; x <= bxEnd; ++x)
+							blend(x, y);
+					}
+					continue;
+				}
+
+				// 4 pixels per step, 2 per SSE register.
+				for (int32 y = by; y <= byEnd; ++y)
+				{
+					__m128d lo[3], hi[3], steps[3];
+					for (int k = 0; k < 3; ++k)
+					{
+						double edge = blockEdges[k] + stepsY[k] * (y - by);
+						lo[k] = _mm_set_pd(edge + stepsX[k], edge);
+						hi[k] = _mm_set_pd(edge + stepsX[k] * 3.0, edge + stepsX[k] * 2.0);
+						steps[k] = _mm_set1_pd(stepsX[k] * 4.0);
+					}
+
+					for (int32 x = bx; x <= bxEnd; x += 4)
+					{
+						int mask = (1 << (std::min)(4, bxEnd - x + 1)) - 1;
+						for (int k = 0; k < 3; ++k)
+						{
+							mask &= _mm_movemask_pd(_mm_cmpge_pd(lo[k], zero)) | (_mm_movemask_pd(_mm_cmpge_pd(hi[k], zero)) << 2);
+							lo[k] = _mm_add_pd(lo[k], steps[k]);
+							hi[k] = _mm_add_pd(hi[k], steps[k]);
+						}
+						for (int bit = 0; bit < 4; ++bit)
+						{
+							if (mask & (1 << bit))
+								blend(x + bit, y);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+SoftwareRasterizer::SoftwareRasterizer(uint32 width, uint32 height)
+{
+	m_width = (std::min)((std::max)(width, 1u), MaxSize);
+	m_height = (std::min)((std::max)(height, 1u), MaxSize);
+	m_pixels.assign((size_t)m_width * m_height * 4, 0.0f);
+}
+
+void SoftwareRasterizer::Clear(const float color[4])
+{
+	for (size_t i = 0; i < m_pixels.size(); i += 4)
+		std::copy(color, color + 4, m_pixels.begin() + i);
+}
+
+void SoftwareRasterizer::DrawAdditive(const RasterMesh& mesh, const XMFLOAT4X4& world, const XMFLOAT4X4& viewProj)
+{
+	const size_t numTriangles = mesh.NumIndices / 3;
+	if (numTriangles == 0 || mesh.NumVertices == 0)
+		return;
+
+	// Vertex stage, mul(gWorld, PosL) then mul(gViewProj, PosW).
+	std::vector<ClipVertex> clipVertices(mesh.NumVertices);
+	ThreadUtil::ParallelFor((mesh.NumVertices + VertexChunkSize - 1) / VertexChunkSize, [&](size_t chunk, uint32)
+	{
+		uint32 end = (std::min)((uint32)(chunk + 1) * VertexChunkSize, mesh.NumVertices);
+		for (uint32 v = (uint32)chunk * VertexChunkSize; v < end; ++v)
+		{
+			const float* position = reinterpret_cast<const float*>(mesh.Vertices + (size_t)v * mesh.VertexStride);
+			float posW[4], posH[4];
+			for (int j = 0; j < 4; ++j)
+				posW[j] = position[0] * world.m[0][j] + position[1] * world.m[1][j] + position[2] * world.m[2][j] + position[3] * world.m[3][j];
+			for (int j = 0; j < 4; ++j)
+				posH[j] = posW[0] * viewProj.m[0][j] + posW[1] * viewProj.m[1][j] + posW[2] * viewProj.m[2][j] + posW[3] * viewProj.m[3][j];
+			clipVertices[v] = { posH[0], posH[1], posH[2], posH[3] };
+		}
+	});
+
+	// Clipped against 0 <= z <= w and the guard band, snapped, back faces and empty triangles dropped.
+	const float guardX = 1.0f + 2.0f * (float)GuardBand / (float)m_width;
+	const float guardY = 1.0f + 2.0f * (float)GuardBand / (float)m_height;
+	const float subPixelScale = (float)(1 << SubPixelBits);
+	const float maxFixed = (float)((MaxSize + 2 * GuardBand) << SubPixelBits);
+	const int32 pixelScale = 1 << SubPixelBits;
+	auto getIndex = [&](size_t i)
+	{
+		return mesh.bIndices16 ? (uint32)static_cast<const uint16*>(mesh.Indices)[i] : static_cast<const uint32*>(mesh.Indices)[i];
+	};
+	auto getDistance = [&](const ClipVertex& v, uint32 plane)
+	{
+		switch (plane)
+		{
+		case 0: return v.Z;
+		case 1: return v.W - v.Z;
+		case 2: return v.X + guardX * v.W;
+		case 3: return guardX * v.W - v.X;
+		case 4: return v.Y + guardY * v.W;
+		default: return guardY * v.W - v.Y;
+		}
+	};
+
+	auto setupTriangle = [&](size_t triangle, const auto& emit)
+	{
+		uint32 indices[3] = { getIndex(triangle * 3), getIndex(triangle * 3 + 1), getIndex(triangle * 3 + 2) };
+		if (indices[0] >= mesh.NumVertices || indices[1] >= mesh.NumVertices || indices[2] >= mesh.NumVertices)
+			return;
+
+		ClipVertex polygons[2][MaxPolygonVertices];
+		uint32 count = 3, current = 0;
+		for (int k = 0; k < 3; ++k)
+			polygons[0][k] = clipVertices[indices[k]];
+		for (uint32 plane = 0; plane < 6; ++plane)
+		{
+			uint32 numOutside = 0;
+			for (uint32 k = 0; k < count; ++k)
+				numOutside += getDistance(polygons[current][k], plane) < 0.0f ? 1 : 0;
+			if (numOutside == count)
+				return;
+			if (numOutside == 0)
+				continue;
+			count = ClipPolygon(polygons[current], count, polygons[1 - current], [&](const ClipVertex& v) { return getDistance(v, plane); });
+			current = 1 - current;
+			if (count < 3)
+				return;
+		}
+
+		// Viewport transform, then 1/256 pixel snapping.
+		int32 fixedX[MaxPolygonVertices], fixedY[MaxPolygonVertices];
+		for (uint32 k = 0; k < count; ++k)
+		{
+			const ClipVertex& v = polygons[current][k];
+			if (!(v.W > 0.0f))
+				return;
+			float invW = 1.0f / v.W;
+			float x = (v.X * invW * 0.5f + 0.5f) * (float)m_width * subPixelScale;
+			float y = (0.5f - v.Y * invW * 0.5f) * (float)m_height * subPixelScale;
+			if (!std::isfinite(x) || !std::isfinite(y))
+				return;
+			fixedX[k] = (int32)std::floor((std::min)((std::max)(x, -maxFixed), maxFixed) + 0.5f);
+			fixedY[k] = (int32)std::floor((std::min)((std::max)(y, -maxFixed), maxFixed) + 0.5f);
+		}
+
+		TriangleSetup setup;
+		uint32 colorIndex = mesh.ColorOffset + indices[0] / (std::max)(mesh.VerticesPerColor, 1u);
+		for (int c = 0; c < 4; ++c)
+			setup.Color[c] = colorIndex < mesh.NumColors ? mesh.Colors[(size_t)colorIndex * 4 + c] : 0.0f;
+
+		// Fan, in the order of the polygon.
+		for (uint32 k = 1; k + 1 < count; ++k)
+		{
+			const uint32 corners[3] = { 0, k, k + 1 };
+			for (int c = 0; c < 3; ++c)
+			{
+				setup.X[c] = fixedX[corners[c]];
+				setup.Y[c] = fixedY[corners[c]];
+			}
+			int64 area = (int64)(setup.X[1] - setup.X[0]) * (setup.Y[2] - setup.Y[0]) - (int64)(setup.X[2] - setup.X[0]) * (setup.Y[1] - setup.Y[0]);
+			if (area <= 0)
+				continue;
+
+			int32 minX = (std::min)({ setup.X[0], setup.X[1], setup.X[2] }), maxX = (std::max)({ setup.X[0], setup.X[1], setup.X[2] });
+			int32 minY = (std::min)({ setup.Y[0], setup.Y[1], setup.Y[2] }), maxY = (std::max)({ setup.Y[0], setup.Y[1], setup.Y[2] });
+			setup.MinX = (std::max)(CeilDiv(minX - pixelScale / 2, pixelScale), 0);
+			setup.MinY = (std::max)(CeilDiv(minY - pixelScale / 2, pixelScale), 0);
+			setup.MaxX = (std::min)(FloorDiv(maxX - pixelScale / 2, pixelScale), (int32)m_width - 1);
+			setup.MaxY = (std::min)(FloorDiv(maxY - pixelScale / 2, pixelScale), (int32)m_height - 1);
+			if (setup.MinX <= setup.MaxX && setup.MinY <= setup.MaxY)
+				emit(setup);
+		}
+	};
+
+	// Bin the triangles to the tiles they touch: count per chunk and tile, prefix sum, fill.
+	// The lists of a tile keep the primitive order.
+	const uint32 tileSize = TileSize;
+	const uint32 tilesX = (m_width + tileSize - 1) / tileSize;
+	const uint32 tilesY = (m_height + tileSize - 1) / tileSize;
+	const size_t numTiles = (size_t)tilesX * tilesY;
+	const size_t numChunks = (numTriangles + TriangleChunkSize - 1) / TriangleChunkSize;
+	std::vector<std::vector<TriangleSetup>> chunkSetups(numChunks);
+	std::vector<size_t> offsets(numTiles * numChunks + 1, 0);
+
+	auto forEachTile = [&](const TriangleSetup& setup, const auto& lambda)
+	{
+		for (uint32 ty = setup.MinY / tileSize; ty <= setup.MaxY / tileSize; ++ty)
+		{
+			for (uint32 tx = setup.MinX / tileSize; tx <= setup.MaxX / tileSize; ++tx)
+				lambda((size_t)ty * tilesX + tx);
+		}
+	};
+
+	ThreadUtil::ParallelFor(numChunks, [&](size_t chunk, uint32)
+	{
+		size_t end = (std::min)((chunk + 1) * TriangleChunkSize, numTriangles);
+		for (size_t triangle = chunk * TriangleChunkSize; triangle < end; ++triangle)
+		{
+			setupTriangle(triangle, [&](const TriangleSetup& setup)
+			{
+				chunkSetups[chunk].push_back(setup);
+				forEachTile(setup, [&](size_t tile) { ++offsets[tile * numChunks + chunk + 1]; });
+			});
+		}
+	});
+	for (size_t slot = 1; slot < offsets.size(); ++slot)
+		offsets[slot] += offsets[slot - 1];
+
+	std::vector<const TriangleSetup*> entries(offsets.back());
+	ThreadUtil::ParallelFor(numChunks, [&](size_t chunk, uint32)
+	{
+		std::vector<size_t> cursors(numTiles);
+		for (size_t tile = 0; tile < numTiles; ++tile)
+			cursors[tile] = offsets[tile * numChunks + chunk];
+		for (const TriangleSetup& setup : chunkSetups[chunk])
+			forEachTile(setup, [&](size_t tile) { entries[cursors[tile]++] = &setup; });
+	});
+
+	// Every tile by one worker, its pixels are written by no one else.
+	ThreadUtil::ParallelFor(numTiles, [&](size_t tile, uint32)
+	{
+		const int32 tileX0 = (int32)((tile % tilesX) * tileSize), tileY0 = (int32)((tile / tilesX) * tileSize);
+		const int32 tileX1 = (std::min)(tileX0 + (int32)tileSize, (int32)m_width) - 1;
+		const int32 tileY1 = (std::min)(tileY0 + (int32)tileSize, (int32)m_height) - 1;
+		for (size_t entry = offsets[tile * numChunks]; entry < offsets[(tile + 1) * numChunks]; ++entry)
+			DrawTriangle(*entries[entry], tileX0, tileY0, tileX1, tileY1, m_pixels.data(), m_width);
+	});
+}
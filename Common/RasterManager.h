@@ -0,0 +1,68 @@
+//
+// RasterManager.h
+//
+
+#pragma once
+
+#include <vector>
+#include <DirectXMath.h>
+#include "TypeDef.h"
+
+namespace DX
+{
+	namespace RasterManager
+	{
+		// Indexed triangle list, read like the input assembler reads the FScene box geometry.
+		// The colour of a triangle is Colors[ColorOffset + index / VerticesPerColor] of its first index, what BoxVS
+		// reads from gPerBoxData (the vertices of a box triangle share it). Colours past NumColors read as 0.
+		struct RasterMesh
+		{
+			const uint8* Vertices = nullptr;		// POSITION, float4 at the start of every vertex.
+			uint32 VertexStride = 0;
+			uint32 NumVertices = 0;
+			const void* Indices = nullptr;
+			bool bIndices16 = true;
+			uint32 NumIndices = 0;
+			const float* Colors = nullptr;			// RGBA.
+			uint32 NumColors = 0;
+			uint32 ColorOffset = 0;
+			uint32 VerticesPerColor = 8;
+		};
+
+		// CPU version of the BoxBlendAdd pass into a RGBA float32 target, the same content as offscreen RT 0:
+		// no depth, back faces culled (clockwise is the front), RGB added and alpha replaced in primitive order.
+		//
+		// The vertices are snapped to 1/256 pixel and the coverage uses exact edge functions with the top-left
+		// rule, like the D3D rasterization rules. The triangles are binned to TileSize^2 tiles, every tile is
+		// drawn by one worker in primitive order, so the result does not depend on the thread count.
+		class SoftwareRasterizer
+		{
+		public:
+
+			SoftwareRasterizer(uint32 width, uint32 height);
+
+			void Clear(const float color[4]);
+
+			// Matrices are row major for row vectors, like the PerObject / PerPass constants.
+			void DrawAdditive(const RasterMesh& mesh, const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4X4& viewProj);
+
+			uint32 GetWidth() const { return m_width; }
+			uint32 GetHeight() const { return m_height; }
+			// 4 floats per pixel, the first row is the top one.
+			const std::vector<float>& GetPixels() const { return m_pixels; }
+
+			static const uint32 TileSize = 64;
+			static const uint32 BlockSize = 8;
+			static const uint32 SubPixelBits = 8;
+			static const uint32 MaxSize = 16384;
+			// Triangles are clipped this far (pixels) around the target, it keeps the edge functions exact in doubles.
+			static const uint32 GuardBand = 8192;
+
+		private:
+
+			uint32 m_width;
+			uint32 m_height;
+			std::vector<float> m_pixels;
+		};
+	}
+}
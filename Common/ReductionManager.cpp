@@ -0,0 +1,297 @@
+//
+// ReductionManager.cpp
+//
+
+#include "ReductionManager.h"
+#include "ThreadManager.h"
+#include <algorithm>
+#include <emmintrin.h>
+
+using namespace DX;
+using namespace DX::ReductionManager;
+using namespace DX::ThreadManager;
+
+namespace
+{
+	// The last (count % 4) floats of a chunk, padded with NaN so every reduction skips the padding.
+	inline __m128 LoadTail(const float* data, size_t count)
+	{
+		float tail[4] = { std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::quiet_NaN(),
+			std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::quiet_NaN() };
+		std::copy(data, data + count, tail);
+		return _mm_loadu_ps(tail);
+	}
+
+	// lambda(x) for every 4 floats of [begin, end).
+	template<typename TLambda>
+	inline void ForEachQuad(const float* data, size_t begin, size_t end, const TLambda& lambda)
+	{
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4)
+			lambda(_mm_loadu_ps(data + i));
+		if (i < end)
+			lambda(LoadTail(data + i, end - i));
+	}
+
+	template<typename TLambda>
+	inline void ForEachChunk(size_t count, const TLambda& lambda)
+	{
+		const size_t chunkSize = ReduceUtil::ChunkSize;
+		ThreadUtil::ParallelFor((count + chunkSize - 1) / chunkSize, [&](size_t chunk, uint32 worker)
+		{
+			lambda(chunk, chunk * chunkSize, (std::min)((chunk + 1) * chunkSize, count), worker);
+		});
+	}
+
+	inline size_t GetNumChunks(size_t count)
+	{
+		return (count + ReduceUtil::ChunkSize - 1) / ReduceUtil::ChunkSize;
+	}
+
+	inline float HorizontalMax(__m128 x)
+	{
+		x = _mm_max_ps(x, _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 0, 3, 2)));
+		x = _mm_max_ps(x, _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtss_f32(x);
+	}
+
+	inline float HorizontalMin(__m128 x)
+	{
+		x = _mm_min_ps(x, _mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 0, 3, 2)));
+		x = _mm_min_ps(x, _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1)));
+		return _mm_cvtss_f32(x);
+	}
+
+	// Bin of the values of [min, max], the histogram and the percentile refinement use the same one.
+	struct BinMapping
+	{
+		__m128 Min, Max, Scale, Last;
+
+		BinMapping(float min, float max, uint32 numBins)
+		{
+			Min = _mm_set1_ps(min);
+			Max = _mm_set1_ps(max);
+			Scale = _mm_set1_ps((float)numBins / (max - min));
+			Last = _mm_set1_ps((float)(numBins - 1));
+		}
+
+		// inRange gets the lanes inside [min, max]. A NaN product (min == max) lands in bin 0.
+		__m128i GetBins(__m128 x, int& inRange) const
+		{
+			inRange = _mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(x, Min), _mm_cmple_ps(x, Max)));
+			__m128 bin = _mm_mul_ps(_mm_sub_ps(x, Min), Scale);
+			bin = _mm_min_ps(_mm_max_ps(bin, _mm_setzero_ps()), Last);
+			return _mm_cvttps_epi32(bin);
+		}
+	};
+}
+
+void ReduceUtil::Max4(const float* pixels, size_t count, float out[4])
+{
+	// A chunk is ChunkSize floats here too.
+	const size_t numFloats = count * 4;
+	std::vector<float> chunkMax(GetNumChunks(numFloats) * 4);
+	ForEachChunk(numFloats, [&](size_t chunk, size_t begin, size_t end, uint32)
+	{
+		__m128 max0 = _mm_loadu_ps(out), max1 = max0;
+		size_t i = begin;
+		for (; i + 8 <= end; i += 8)
+		{
+			max0 = _mm_max_ps(_mm_loadu_ps(pixels + i), max0);
+			max1 = _mm_max_ps(_mm_loadu_ps(pixels + i + 4), max1);
+		}
+		if (i < end)
+			max0 = _mm_max_ps(_mm_loadu_ps(pixels + i), max0);
+		_mm_storeu_ps(chunkMax.data() + chunk * 4, _mm_max_ps(max0, max1));
+	});
+
+	__m128 max = _mm_loadu_ps(out);
+	for (size_t chunk = 0; chunk < chunkMax.size(); chunk += 4)
+		max = _mm_max_ps(_mm_loadu_ps(chunkMax.data() + chunk), max);
+	_mm_storeu_ps(out, max);
+}
+
+float ReduceUtil::Max(const float* data, size_t count)
+{
+	std::vector<float> chunkMax(GetNumChunks(count));
+	ForEachChunk(count, [&](size_t chunk, size_t begin, size_t end, uint32)
+	{
+		// _mm_max_ps returns its second operand when one is NaN.
+		__m128 max = _mm_set1_ps(std::numeric_limits<float>::lowest());
+		ForEachQuad(data, begin, end, [&](__m128 x) { max = _mm_max_ps(x, max); });
+		chunkMax[chunk] = HorizontalMax(max);
+	});
+
+	float max = std::numeric_limits<float>::lowest();
+	for (float value : chunkMax)
+		max = (std::max)(max, value);
+	return max;
+}
+
+double ReduceUtil::Sum(const float* data, size_t count)
+{
+	std::vector<double> chunkSums(GetNumChunks(count));
+	ForEachChunk(count, [&](size_t chunk, size_t begin, size_t end, uint32)
+	{
+		__m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+		ForEachQuad(data, begin, end, [&](__m128 x)
+		{
+			x = _mm_and_ps(x, _mm_cmpord_ps(x, x));
+			sum0 = _mm_add_pd(sum0, _mm_cvtps_pd(x));
+			sum1 = _mm_add_pd(sum1, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+		});
+		double sums[2];
+		_mm_storeu_pd(sums, _mm_add_pd(sum0, sum1));
+		chunkSums[chunk] = sums[0] + sums[1];
+	});
+
+	double sum = 0.0;
+	for (double value : chunkSums)
+		sum += value;
+	return sum;
+}
+
+size_t ReduceUtil::CountNonZero(const float* data, size_t count)
+{
+	std::vector<size_t> chunkCounts(GetNumChunks(count));
+	ForEachChunk(count, [&](size_t chunk, size_t begin, size_t end, uint32)
+	{
+		// The lanes count down by 1 per hit, a chunk cannot overflow them.
+		__m128i counts = _mm_setzero_si128();
+		ForEachQuad(data, begin, end, [&](__m128 x)
+		{
+			__m128 bNonZero = _mm_and_ps(_mm_cmpneq_ps(x, _mm_setzero_ps()), _mm_cmpord_ps(x, x));
+			counts = _mm_sub_epi32(counts, _mm_castps_si128(bNonZero));
+		});
+		int32 lanes[4];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), counts);
+		chunkCounts[chunk] = (size_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	});
+
+	size_t nonZero = 0;
+	for (size_t value : chunkCounts)
+		nonZero += value;
+	return nonZero;
+}
+
+uint64 ReduceUtil::Histogram(const float* data, size_t count, float min, float max, uint32 numBins, uint64* bins)
+{
+	std::fill(bins, bins + numBins, 0);
+	if (numBins == 0 || !(min <= max))
+		return 0;
+
+	// Counts commute, one histogram per worker.
+	const BinMapping mapping(min, max, numBins);
+	std::vector<std::vector<uint64>> workerBins(ThreadUtil::GetWorkerCount());
+	ForEachChunk(count, [&](size_t, size_t begin, size_t end, uint32 worker)
+	{
+		std::vector<uint64>& local = workerBins[worker];
+		local.resize(numBins, 0);
+		ForEachQuad(data, begin, end, [&](__m128 x)
+		{
+			int inRange;
+			int32 lanes[4];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), mapping.GetBins(x, inRange));
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				if (inRange & (1 << lane))
+					local[lanes[lane]]++;
+			}
+		});
+	});
+
+	uint64 total = 0;
+	for (const std::vector<uint64>& local : workerBins)
+	{
+		for (size_t bin = 0; bin < local.size(); ++bin)
+		{
+			bins[bin] += local[bin];
+			total += local[bin];
+		}
+	}
+	return total;
+}
+
+float ReduceUtil::Percentile(const float* data, size_t count, float percentile, float threshold)
+{
+	// Number and range of the values >= threshold.
+	struct ChunkRange
+	{
+		size_t Count;
+		float Min, Max;
+	};
+	std::vector<ChunkRange> chunkRanges(GetNumChunks(count));
+	ForEachChunk(count, [&](size_t chunk, size_t begin, size_t end, uint32)
+	{
+		const __m128 thresholds = _mm_set1_ps(threshold);
+		const __m128 highest = _mm_set1_ps(std::numeric_limits<float>::infinity());
+		const __m128 lowest = _mm_sub_ps(_mm_setzero_ps(), highest);
+		__m128 min = highest, max = lowest;
+		__m128i counts = _mm_setzero_si128();
+		ForEachQuad(data, begin, end, [&](__m128 x)
+		{
+			__m128 bKept = _mm_cmpge_ps(x, thresholds);
+			min = _mm_min_ps(_mm_or_ps(_mm_and_ps(bKept, x), _mm_andnot_ps(bKept, highest)), min);
+			max = _mm_max_ps(_mm_or_ps(_mm_and_ps(bKept, x), _mm_andnot_ps(bKept, lowest)), max);
+			counts = _mm_sub_epi32(counts, _mm_castps_si128(bKept));
+		});
+		int32 lanes[4];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), counts);
+		chunkRanges[chunk] = { (size_t)lanes[0] + lanes[1] + lanes[2] + lanes[3], HorizontalMin(min), HorizontalMax(max) };
+	});
+
+	size_t numKept = 0;
+	float min = std::numeric_limits<float>::infinity(), max = -min;
+	for (const ChunkRange& range : chunkRanges)
+	{
+		if (range.Count == 0)
+			continue;
+		numKept += range.Count;
+		min = (std::min)(min, range.Min);
+		max = (std::max)(max, range.Max);
+	}
+	if (numKept == 0)
+		return 0.0f;
+
+	const size_t rank = (size_t)((numKept - 1) * (double)(std::min)((std::max)(percentile, 0.0f), 1.0f));
+	if (min == max)
+		return min;
+
+	// Every value in [min, max] is >= threshold, the histogram counts exactly the kept ones.
+	const uint32 numBins = PercentileBins;
+	std::vector<uint64> bins(numBins);
+	Histogram(data, count, min, max, numBins, bins.data());
+	uint32 rankBin = 0;
+	size_t below = 0;
+	while (below + bins[rankBin] <= rank)
+		below += (size_t)bins[rankBin++];
+
+	// Only the values of that bin are selected from.
+	const BinMapping mapping(min, max, numBins);
+	std::vector<std::vector<float>> chunkValues(chunkRanges.size());
+	ForEachChunk(count, [&](size_t chunk, size_t begin, size_t end, uint32)
+	{
+		std::vector<float>& values = chunkValues[chunk];
+		ForEachQuad(data, begin, end, [&](__m128 x)
+		{
+			int inRange;
+			int32 lanes[4];
+			float floats[4];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), mapping.GetBins(x, inRange));
+			_mm_storeu_ps(floats, x);
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				if ((inRange & (1 << lane)) && (uint32)lanes[lane] == rankBin)
+					values.push_back(floats[lane]);
+			}
+		});
+	});
+
+	std::vector<float> values;
+	values.reserve((size_t)bins[rankBin]);
+	for (const std::vector<float>& chunk : chunkValues)
+		values.insert(values.end(), chunk.begin(), chunk.end());
+	auto nth = values.begin() + (rank - below);
+	std::nth_element(values.begin(), nth, values.end());
+	return *nth;
+}
@@ -0,0 +1,41 @@
+//
+// ReductionManager.h
+//
+
+#pragma once
+
+#include <limits>
+#include "TypeDef.h"
+
+namespace DX
+{
+	namespace ReductionManager
+	{
+		// Reductions over float buffers (readbacks, CPU images, heatmap cells). Every chunk of ChunkSize floats
+		// is reduced with SSE 4 lanes at a time, the chunks are spread over the workers and merged in chunk
+		// order, so the results do not depend on the thread count. NaN are skipped everywhere.
+		class ReduceUtil
+		{
+		public:
+
+			// Per channel max of count float4 pixels, merged into out (the start value, 0 like computemax.hlsl).
+			static void Max4(const float* pixels, size_t count, float out[4]);
+
+			// lowest() when there is no value.
+			static float Max(const float* data, size_t count);
+			static double Sum(const float* data, size_t count);
+			static size_t CountNonZero(const float* data, size_t count);
+
+			// The values in [min, max] counted into numBins equal bins (max goes to the last one), bins is
+			// overwritten. Returns the number of values counted.
+			static uint64 Histogram(const float* data, size_t count, float min, float max, uint32 numBins, uint64* bins);
+
+			// Exact value of rank (n - 1) * percentile (truncated) among the n values >= threshold, 0 when n is 0.
+			// A histogram of those values finds the bin of the rank, only the values of that bin are then sorted.
+			static float Percentile(const float* data, size_t count, float percentile, float threshold = std::numeric_limits<float>::lowest());
+
+			static const size_t ChunkSize = 64 * 1024;
+			static const uint32 PercentileBins = 4096;
+		};
+	}
+}
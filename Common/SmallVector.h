@@ -0,0 +1,159 @@
+//
+// SmallVector.h
+// NOTE: Only for trivially copyable types (indices, handles...), elements are moved with memcpy.
+
+#pragma once
+
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include "TypeDef.h"
+
+namespace DX
+{
+	// Vector with the first N elements stored inside the object,
+	// it only allocates once the list grows past N.
+	template<typename T, uint32 N>
+	class SmallVector
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "SmallVector only supports trivially copyable types.");
+		static_assert(N > 0, "SmallVector needs an inline capacity.");
+
+	public:
+
+		using value_type = T;
+		using size_type = size_t;
+		using iterator = T*;
+		using const_iterator = const T*;
+
+		SmallVector() : m_data(m_inline) {}
+
+		SmallVector(std::initializer_list<T> list) : m_data(m_inline)
+		{
+			assign(list.begin(), list.end());
+		}
+
+		SmallVector(const SmallVector& other) : m_data(m_inline)
+		{
+			assign(other.begin(), other.end());
+		}
+
+		SmallVector(SmallVector&& other) noexcept : m_data(m_inline)
+		{
+			*this = std::move(other);
+		}
+
+		~SmallVector()
+		{
+			if (!IsInline())
+				delete[] m_data;
+		}
+
+		SmallVector& operator=(const SmallVector& other)
+		{
+			if (this != &other)
+				assign(other.begin(), other.end());
+			return *this;
+		}
+
+		// An inline source fits in any capacity, so this never allocates.
+		SmallVector& operator=(SmallVector&& other) noexcept
+		{
+			if (this == &other)
+				return *this;
+
+			if (other.IsInline())
+			{
+				assign(other.begin(), other.end());
+			}
+			else
+			{
+				// Steal the heap block.
+				if (!IsInline())
+					delete[] m_data;
+				m_data = other.m_data;
+				m_capacity = other.m_capacity;
+				m_size = other.m_size;
+				other.m_data = other.m_inline;
+				other.m_capacity = N;
+			}
+			other.m_size = 0;
+			return *this;
+		}
+
+		template<typename TIterator>
+		void assign(TIterator first, TIterator last)
+		{
+			clear();
+			reserve((uint32)std::distance(first, last));
+			for (; first != last; ++first)
+				m_data[m_size++] = *first;
+		}
+
+		void reserve(size_t capacity)
+		{
+			if (capacity <= m_capacity)
+				return;
+
+			T* data = new T[capacity];
+			std::memcpy(data, m_data, m_size * sizeof(T));
+			if (!IsInline())
+				delete[] m_data;
+			m_data = data;
+			m_capacity = (uint32)capacity;
+		}
+
+		void resize(size_t size, const T& value = T())
+		{
+			const T copy = value;
+			reserve(size);
+			for (size_t i = m_size; i < size; ++i)
+				m_data[i] = copy;
+			m_size = (uint32)size;
+		}
+
+		void push_back(const T& value)
+		{
+			// value may live in the block reserve frees.
+			const T copy = value;
+			if (m_size == m_capacity)
+				reserve(m_capacity * 2);
+			m_data[m_size++] = copy;
+		}
+
+		void pop_back() { --m_size; }
+		void clear() { m_size = 0; }
+
+		size_t size() const { return m_size; }
+		size_t capacity() const { return m_capacity; }
+		bool empty() const { return m_size == 0; }
+
+		// True while the elements live in the inline buffer (no heap block).
+		bool IsInline() const { return m_data == m_inline; }
+
+		T* data() { return m_data; }
+		const T* data() const { return m_data; }
+
+		T& operator[](size_t index) { return m_data[index]; }
+		const T& operator[](size_t index) const { return m_data[index]; }
+
+		T& front() { return m_data[0]; }
+		const T& front() const { return m_data[0]; }
+		T& back() { return m_data[m_size - 1]; }
+		const T& back() const { return m_data[m_size - 1]; }
+
+		iterator begin() { return m_data; }
+		iterator end() { return m_data + m_size; }
+		const_iterator begin() const { return m_data; }
+		const_iterator end() const { return m_data + m_size; }
+
+	private:
+
+		T* m_data;
+		uint32 m_size = 0;
+		uint32 m_capacity = N;
+		T m_inline[N];
+	};
+}
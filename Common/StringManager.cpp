@@ -26,7 +26,7 @@ std::string StringUtil::WStringToString(const std::wstring& wstr)
 	typedef std::codecvt<wchar_t, char, std::mbstate_t> converter_type;
 	const converter_type& converter = std::use_facet<converter_type>(locale);
 	std::vector<char> to(wstr.length() * converter.max_length());
-	std::mbstate_t state;
+	std::mbstate_t state = std::mbstate_t();
 	const wchar_t* from_next;
 	char* to_next;
 	const converter_type::result result = converter.out(state, wstr.data(), wstr.data() + wstr.length(), from_next, &to[0], &to[0] + to.size(), to_next);
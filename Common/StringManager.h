@@ -5,6 +5,8 @@
 #pragma once
 
 #include <sstream>
+#include <algorithm>
+#include <cwctype>
 #include <codecvt>
 #include "TypeDef.h"
 
@@ -54,6 +56,11 @@ namespace DX
 			template<typename T>
 			static std::vector<T> WStringToArray(const std::wstring& wstr, const wchar_t& separator);
 
+			// Same result as above for integer arrays, parsed in place without streams (any allocator).
+			// Any container with clear/push_back (e.g. SmallVector) can be filled.
+			template<typename T, typename TContainer, typename TAlloc>
+			static void WStringToArray(const std::basic_string<wchar_t, std::char_traits<wchar_t>, TAlloc>& wstr, const wchar_t& separator, TContainer& out);
+
 		};
 
 		template<typename T>
@@ -90,6 +97,50 @@ namespace DX
 			return temp_array;
 		}
 
+		template<typename T, typename TContainer, typename TAlloc>
+		void StringUtil::WStringToArray(const std::basic_string<wchar_t, std::char_traits<wchar_t>, TAlloc>& wstr, const wchar_t& separator, TContainer& out)
+		{
+			static_assert(std::is_integral<T>::value && sizeof(T) < sizeof(int64), "Only 8/16/32 bit integer arrays are parsed in place.");
+
+			out.clear();
+			const wchar_t* cur = wstr.c_str();
+			const wchar_t* end = cur + wstr.size();
+			while (cur < end)
+			{
+				const wchar_t* tokenEnd = cur;
+				while (tokenEnd < end && *tokenEnd != separator)
+					++tokenEnd;
+
+				// Leading blanks and sign, like operator>>.
+				const wchar_t* ch = cur;
+				while (ch < tokenEnd && iswspace(*ch))
+					++ch;
+				bool bNegative = false;
+				if (ch < tokenEnd && (*ch == L'-' || *ch == L'+'))
+					bNegative = (*ch++ == L'-');
+
+				// Clamped past the range, enough to tell overflow apart.
+				const int64 limit = (int64)std::numeric_limits<T>::max() + 2;
+				int64 value = 0;
+				bool bDigits = false;
+				for (; ch < tokenEnd && *ch >= L'0' && *ch <= L'9'; ++ch)
+				{
+					bDigits = true;
+					value = (std::min)(value * 10 + (*ch - L'0'), limit);
+				}
+				cur = tokenEnd + 1;
+
+				if (bNegative)
+					value = -value;
+
+				// Tokens WStringToNumeric rejects (fail, overflow or max()) are skipped.
+				if (!bDigits || value >= (int64)std::numeric_limits<T>::max() || value < (int64)std::numeric_limits<T>::min())
+					continue;
+
+				out.push_back((T)value);
+			}
+		}
+
 		wchar_t const* const WCharDigitTables[] =
 		{
 			L"0123456789",
@@ -8,6 +8,8 @@
 #include <atomic>
 #include <mutex>
 #include <vector>
+#include <algorithm>
+#include <cstdint>
 
 namespace DX
 {
@@ -29,5 +31,43 @@ namespace DX
 			std::vector<std::thread> m_threads;
 			
 		};
+
+		class ThreadUtil
+		{
+		public:
+
+			static uint32_t GetWorkerCount()
+			{
+				return (std::max)(1u, std::thread::hardware_concurrency());
+			}
+
+			// Run lambda(index, worker) for every index in [0, count), blocks until all are done.
+			// Indices are handed out one at a time, worker is in [0, GetWorkerCount()).
+			template<typename TLambda>
+			static void ParallelFor(size_t count, const TLambda& lambda)
+			{
+				uint32_t numWorkers = (uint32_t)(std::min)((size_t)GetWorkerCount(), count);
+				if (numWorkers <= 1)
+				{
+					for (size_t i = 0; i < count; ++i)
+						lambda(i, 0u);
+					return;
+				}
+
+				std::atomic<size_t> next(0);
+				auto worker = [&](uint32_t workerIndex)
+				{
+					for (size_t i = next++; i < count; i = next++)
+						lambda(i, workerIndex);
+				};
+
+				std::vector<std::thread> threads;
+				for (uint32_t w = 1; w < numWorkers; ++w)
+					threads.push_back(std::thread(worker, w));
+				worker(0u);
+				for (auto& thread : threads)
+					thread.join();
+			}
+		};
 	}
 }
\ No newline at end of file
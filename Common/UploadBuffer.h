@@ -68,6 +68,12 @@ namespace DX
 			memcpy(&mMappedData[elementIndex*mElementByteSize], &data, sizeof(TDataType));
 		}
 
+		// Contiguous elements in one copy, not for constant buffers (elements are padded there).
+		void CopyData(int firstElementIndex, const T* data, UINT elementCount)
+		{
+			memcpy(&mMappedData[firstElementIndex*mElementByteSize], data, sizeof(T) * elementCount);
+		}
+
 	private:
 
 		Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
@@ -9,6 +9,7 @@
 #endif
 
 #include "AppEntry.h"
+#include "AppHeadless.h"
 
 namespace
 {
@@ -67,6 +68,11 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 			app_path.erase(found, dir.size());			
 	}
 	
+	// Headless jobs never create the window.
+	int exitCode = 0;
+	if (AppHeadless::Run(std::wstring(lpCmdLine), exitCode))
+		return exitCode;
+
     g_app = std::make_unique<AppEntry>(app_path);
 
     // Register class and create window
@@ -113,3 +113,36 @@ Frustum::Frustum( const Matrix4& ProjMat )
         ConstructPerspectiveFrustum( RcpXX, RcpYY, NearClip, FarClip );
     }
 }
+
+Frustum Frustum::FromViewProjection( const Matrix4& ViewProjMatrix )
+{
+    Frustum result;
+
+    // The rows of the transpose are the clip space x, y, z and w as functions of the world position.
+    const Matrix4 Clip = Transpose(ViewProjMatrix);
+    const Vector4 X = Clip.GetX(), Y = Clip.GetY(), Z = Clip.GetZ(), W = Clip.GetW();
+
+    const Vector4 Planes[6] =
+    {
+        Z,        // kNearPlane
+        W - Z,    // kFarPlane
+        W + X,    // kLeftPlane
+        W - X,    // kRightPlane
+        W - Y,    // kTopPlane
+        W + Y     // kBottomPlane
+    };
+    for (int i = 0; i < 6; ++i)
+        result.m_FrustumPlanes[i] = BoundingPlane(Planes[i] * RecipSqrt(LengthSquare(Vector3(Planes[i]))));
+
+    const Matrix4 InvViewProj = Invert(ViewProjMatrix);
+    for (int i = 0; i < 8; ++i)
+    {
+        // kNearLowerLeft ... kFarUpperRight, see CornerID.
+        const float x = (i & 2) ? 1.0f : -1.0f;
+        const float y = (i & 1) ? 1.0f : -1.0f;
+        const float z = (i & 4) ? 1.0f : 0.0f;
+        result.m_FrustumCorners[i] = Vector3(XMVector3TransformCoord(XMVectorSet(x, y, z, 1.0f), InvViewProj));
+    }
+
+    return result;
+}
@@ -25,6 +25,10 @@ namespace Math
 
         Frustum( const Matrix4& ProjectionMatrix );
 
+        // World space frustum of a view projection with D3D clip space (0 <= z <= w) in the DirectXMath
+        // row vector convention.  Handles left and right handed, perspective and orthographic projections.
+        static Frustum FromViewProjection( const Matrix4& ViewProjMatrix );
+
         enum CornerID
         {
             kNearLowerLeft, kNearUpperLeft, kNearLowerRight, kNearUpperRight,
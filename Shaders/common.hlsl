@@ -27,6 +27,15 @@ struct VertexIn
     float4 Color : COLOR;
 };
 
+// Unit box corner + one FSceneBoxInstance per instance, see FSceneBoxGeometry.
+struct BoxInstanceIn
+{
+	float4 PosL      : POSITION;
+    float3 BoxCenter : BOXCENTER;
+    float3 BoxExtent : BOXEXTENT;
+    uint   BoxSlot   : BOXSLOT;
+};
+
 struct VertexOut
 {
 	float4 PosH  : SV_POSITION;
@@ -63,6 +72,20 @@ VertexOut BoxVS(VertexIn vin, uint vertexID : SV_VertexID)
     return vout;
 }
 
+VertexOut BoxInstancedVS(BoxInstanceIn vin)
+{
+    VertexOut vout;
+    
+    vout.PosW = mul(gWorld, float4(vin.BoxCenter + vin.BoxExtent * vin.PosL.xyz, 1.0f));
+	
+	// Transform to homogeneous clip space.
+    vout.PosH = mul(gViewProj, vout.PosW);
+	
+    vout.Color = gPerBoxData[gPerFSceneSBufferOffset + vin.BoxSlot].Color;
+    
+    return vout;
+}
+
 float4 PS(VertexOut pin) : SV_Target
 {
     return pin.Color;
@@ -0,0 +1,117 @@
+//
+// FSceneAssetRegistry.cpp
+//
+
+#include "FSceneAssetRegistry.h"
+
+using namespace UnrealEngine;
+
+namespace
+{
+	template<typename T>
+	void AddArray(const std::vector<T>& array, FSceneTableFootprint& footprint)
+	{
+		if (array.capacity() == 0)
+			return;
+
+		footprint.StructBytes += array.capacity() * sizeof(T);
+		footprint.NumAllocations++;
+	}
+
+	void AddLookup(const std::unordered_set<uint32>& lookup, FSceneTableFootprint& footprint)
+	{
+		// Estimated, one node per entry (value plus two links) and the bucket array.
+		footprint.NumRecords += lookup.size();
+		footprint.StructBytes += lookup.bucket_count() * sizeof(void*) +
+			lookup.size() * (sizeof(uint32) + 2 * sizeof(void*));
+		footprint.NumAllocations += lookup.size() + 1;
+	}
+}
+
+template<typename TRecord>
+void FSceneAssetRegistry::Register(const TArray<TRecord>& table, std::vector<const TRecord*>& records,
+	std::unordered_set<uint32>& lookup)
+{
+	for (auto& record : table)
+	{
+		// First scene that brings the asset owns the entry.
+		if (lookup.insert(record.UniqueId).second)
+			records.push_back(&record);
+	}
+}
+
+void FSceneAssetRegistry::AddScene(const FSceneDataSetPtr& scene)
+{
+	m_scenes.push_back(scene);
+
+	Register(scene->MaterialsTable, m_materials, m_materialLookup);
+	Register(scene->MaterialInstancesTable, m_materialInstances, m_materialInstanceLookup);
+	Register(scene->TexturesTable, m_textures, m_textureLookup);
+
+	m_numRawMaterials += scene->MaterialsTable.size();
+	m_numRawMaterialInstances += scene->MaterialInstancesTable.size();
+	m_numRawTextures += scene->TexturesTable.size();
+	for (auto& texture : scene->TexturesTable)
+		m_rawTextureKB += texture.CurrentKB;
+}
+
+void FSceneAssetRegistry::Clear()
+{
+	m_materials.clear();
+	m_materialInstances.clear();
+	m_textures.clear();
+	m_materialLookup.clear();
+	m_materialInstanceLookup.clear();
+	m_textureLookup.clear();
+	m_numRawMaterials = 0;
+	m_numRawMaterialInstances = 0;
+	m_numRawTextures = 0;
+	m_rawTextureKB = 0.0;
+
+	// Release the snapshots last, the entries above point into them.
+	m_scenes.clear();
+}
+
+FSceneAssetSummary FSceneAssetRegistry::GetSummary() const
+{
+	FSceneAssetSummary summary;
+	summary.NumScenes = m_scenes.size();
+	summary.NumMaterials = m_numRawMaterials;
+	summary.NumUniqueMaterials = m_materials.size();
+	summary.NumMaterialInstances = m_numRawMaterialInstances;
+	summary.NumUniqueMaterialInstances = m_materialInstances.size();
+	summary.NumTextures = m_numRawTextures;
+	summary.NumUniqueTextures = m_textures.size();
+	summary.TextureKB = m_rawTextureKB;
+	for (auto texture : m_textures)
+		summary.UniqueTextureKB += texture->CurrentKB;
+
+	return summary;
+}
+
+FSceneDataFootprint FSceneAssetRegistry::GetFootprint() const
+{
+	FSceneDataFootprint result;
+	result.Name = "AssetRegistry";
+
+	FSceneTableFootprint entries;
+	entries.TableName = "Entries";
+	entries.NumRecords = m_materials.size() + m_materialInstances.size() + m_textures.size();
+	AddArray(m_materials, entries);
+	AddArray(m_materialInstances, entries);
+	AddArray(m_textures, entries);
+	result.Tables.push_back(entries);
+
+	FSceneTableFootprint lookups;
+	lookups.TableName = "Lookups";
+	AddLookup(m_materialLookup, lookups);
+	AddLookup(m_materialInstanceLookup, lookups);
+	AddLookup(m_textureLookup, lookups);
+	result.Tables.push_back(lookups);
+
+	result.Total.TableName = "Total";
+	for (auto& table : result.Tables)
+		result.Total.Accumulate(table);
+
+	return result;
+}
@@ -0,0 +1,57 @@
+//
+// FSceneAssetRegistry.h
+//
+
+#pragma once
+
+#include "../AppData.h"
+#include "FSceneDataFootprint.h"
+#include <unordered_set>
+
+namespace UnrealEngine
+{
+	// Materials, material instances and textures shared by all the loaded scenes.
+	// Sub-levels of the same world carry the same assets (same UniqueId), the registry
+	// keeps a single entry for each of them so the cross-level totals count them once.
+	// Entries point into the scene snapshots, which stay alive as long as the registry holds them.
+	// Accounting only: the records stay in their scenes and the attribute kernels evaluate the scene tables.
+	class FSceneAssetRegistry
+	{
+	public:
+
+		FSceneAssetRegistry() {}
+
+		void AddScene(const FSceneDataSetPtr& scene);
+
+		void Clear();
+
+		int32 GetSceneCount() const { return (int32)m_scenes.size(); }
+
+		FSceneAssetSummary GetSummary() const;
+
+		// Bookkeeping of the registry itself, the entries are counted with their scenes.
+		FSceneDataFootprint GetFootprint() const;
+
+	private:
+
+		template<typename TRecord>
+		void Register(const TArray<TRecord>& table, std::vector<const TRecord*>& records,
+			std::unordered_set<uint32>& lookup);
+
+		std::vector<FSceneDataSetPtr> m_scenes;
+
+		std::vector<const FSceneMaterialDataSet*> m_materials;
+		std::vector<const FSceneMaterialInstanceDataSet*> m_materialInstances;
+		std::vector<const FSceneTextureDataSet*> m_textures;
+
+		std::unordered_set<uint32> m_materialLookup;
+		std::unordered_set<uint32> m_materialInstanceLookup;
+		std::unordered_set<uint32> m_textureLookup;
+
+		// Totals as they would be without deduplication.
+		uint64 m_numRawMaterials = 0;
+		uint64 m_numRawMaterialInstances = 0;
+		uint64 m_numRawTextures = 0;
+		double m_rawTextureKB = 0.0;
+	};
+}
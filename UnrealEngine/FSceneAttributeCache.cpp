@@ -0,0 +1,116 @@
+//
+// FSceneAttributeCache.cpp
+//
+
+#include "FSceneAttributeCache.h"
+
+using namespace UnrealEngine;
+
+FSceneAttributeColumnPtr FSceneAttributeCache::GetColumn(const FSceneAttributeEngine& engine, EVisualizationAttribute attribute, const FSceneAttributeContext& context)
+{
+	uint64 key = MakeKey(context.SceneId, attribute);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto found = m_lookup.find(key);
+		if (found != m_lookup.end())
+		{
+			m_hits++;
+			m_lru.splice(m_lru.begin(), m_lru, found->second);
+			return found->second->Column;
+		}
+	}
+
+	m_misses++;
+	auto column = std::make_shared<FSceneAttributeColumn>();
+	column->Values.resize(context.NumInstances);
+	engine.Evaluate(attribute, context, column->Values.data(), &column->Stats);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Someone else evaluated it meanwhile, keep theirs.
+	auto found = m_lookup.find(key);
+	if (found != m_lookup.end())
+		return found->second->Column;
+
+	m_lru.push_front(Entry{ key, column });
+	m_lookup[key] = m_lru.begin();
+	m_bytes += ColumnBytes(*column);
+	Trim();
+
+	return column;
+}
+
+FSceneAttributeColumnPtr FSceneAttributeCache::FindColumn(uint32 sceneId, EVisualizationAttribute attribute)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto found = m_lookup.find(MakeKey(sceneId, attribute));
+	if (found == m_lookup.end())
+		return nullptr;
+
+	m_hits++;
+	m_lru.splice(m_lru.begin(), m_lru, found->second);
+	return found->second->Column;
+}
+
+void FSceneAttributeCache::InvalidateScene(uint32 sceneId)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (auto it = m_lru.begin(); it != m_lru.end();)
+	{
+		if ((uint32)(it->Key >> 32) == sceneId)
+		{
+			m_bytes -= ColumnBytes(*it->Column);
+			m_lookup.erase(it->Key);
+			it = m_lru.erase(it);
+		}
+		else ++it;
+	}
+}
+
+void FSceneAttributeCache::InvalidateAttribute(EVisualizationAttribute attribute)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (auto it = m_lru.begin(); it != m_lru.end();)
+	{
+		if ((uint32)it->Key == (uint32)attribute)
+		{
+			m_bytes -= ColumnBytes(*it->Column);
+			m_lookup.erase(it->Key);
+			it = m_lru.erase(it);
+		}
+		else ++it;
+	}
+}
+
+void FSceneAttributeCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_lru.clear();
+	m_lookup.clear();
+	m_bytes = 0;
+}
+
+void FSceneAttributeCache::SetMaxBytes(size_t maxBytes)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_maxBytes = maxBytes;
+	Trim();
+}
+
+size_t FSceneAttributeCache::GetBytes() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_bytes;
+}
+
+void FSceneAttributeCache::Trim()
+{
+	while (m_bytes > m_maxBytes && m_lru.size() > 1)
+	{
+		Entry& last = m_lru.back();
+		m_bytes -= ColumnBytes(*last.Column);
+		m_lookup.erase(last.Key);
+		m_lru.pop_back();
+	}
+}
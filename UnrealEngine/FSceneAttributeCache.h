@@ -0,0 +1,69 @@
+//
+// FSceneAttributeCache.h
+//
+
+#pragma once
+
+#include "FSceneAttributeEngine.h"
+#include <list>
+#include <mutex>
+#include <atomic>
+
+namespace UnrealEngine
+{
+	// Per instance values and their statistics, computed in the same pass.
+	struct FSceneAttributeColumn
+	{
+		TArray<float> Values;
+		FSceneAttributeStats Stats;
+	};
+	using FSceneAttributeColumnPtr = std::shared_ptr<const FSceneAttributeColumn>;
+
+	// Evaluated attribute columns, per scene and attribute, least recently used ones are
+	// dropped once the cache grows past its byte budget. Scenes are immutable, so a column
+	// only goes stale when its scene is removed. Thread safe, columns are evaluated outside the lock.
+	class FSceneAttributeCache
+	{
+	public:
+
+		explicit FSceneAttributeCache(size_t maxBytes = 256 * 1024 * 1024) : m_maxBytes(maxBytes) {}
+
+		// Cached column, evaluated with the engine on a miss.
+		FSceneAttributeColumnPtr GetColumn(const FSceneAttributeEngine& engine, EVisualizationAttribute attribute, const FSceneAttributeContext& context);
+		// Cached column or nullptr, never evaluates.
+		FSceneAttributeColumnPtr FindColumn(uint32 sceneId, EVisualizationAttribute attribute);
+
+		void InvalidateScene(uint32 sceneId);
+		// Columns of an attribute whose kernel was replaced.
+		void InvalidateAttribute(EVisualizationAttribute attribute);
+		void Clear();
+
+		void SetMaxBytes(size_t maxBytes);
+		size_t GetBytes() const;
+		uint64 GetHits() const { return m_hits; }
+		uint64 GetMisses() const { return m_misses; }
+
+	private:
+
+		struct Entry
+		{
+			uint64 Key;
+			FSceneAttributeColumnPtr Column;
+		};
+
+		static uint64 MakeKey(uint32 sceneId, EVisualizationAttribute attribute) { return ((uint64)sceneId << 32) | (uint32)attribute; }
+		static size_t ColumnBytes(const FSceneAttributeColumn& column) { return (column.Values.size() + FSceneAttributeStats::NumBins) * sizeof(float); }
+
+		// Evict from the back, the front entry (just used) is always kept.
+		void Trim();
+
+		mutable std::mutex m_mutex;
+		std::list<Entry> m_lru;
+		std::unordered_map<uint64, std::list<Entry>::iterator> m_lookup;
+
+		size_t m_maxBytes;
+		size_t m_bytes = 0;
+		std::atomic<uint64> m_hits{ 0 };
+		std::atomic<uint64> m_misses{ 0 };
+	};
+}
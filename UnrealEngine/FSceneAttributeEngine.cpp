@@ -0,0 +1,494 @@
+//
+// FSceneAttributeEngine.cpp
+//
+
+#include "FSceneAttributeEngine.h"
+#include "FSceneExpression.h"
+#include "../Common/StringManager.h"
+#include "../Common/ThreadManager.h"
+#include <algorithm>
+#include <atomic>
+
+using namespace UnrealEngine;
+using namespace DX::StringManager;
+using namespace DX::ThreadManager;
+
+namespace
+{
+	FSceneAttributeKernel MeshColumnKernel(TArray<float> FSceneAttributeContext::* column)
+	{
+		return [column](const FSceneAttributeContext& context, uint32 begin, uint32 end, float* out)
+		{
+			std::copy((context.*column).begin() + begin, (context.*column).begin() + end, out + begin);
+		};
+	}
+
+	// Same as StringUtil::WStringToNumeric<float>(StringUtil::WGetBetween(...).front()), failures give max().
+	float ParseBetween(const FString& str, const std::wstring& bound1, const std::wstring& bound2)
+	{
+		std::vector<std::wstring> between = StringUtil::WGetBetween(str, bound1, bound2);
+		if (between.empty())
+			return std::numeric_limits<float>::max();
+		return StringUtil::WStringToNumeric<float>(between.front());
+	}
+
+	template<typename TMesh>
+	void AddMesh(FSceneAttributeContext& context, const FSceneDataSet& dataSet, const TMesh& mesh, float numInstances)
+	{
+		context.NumVertices.push_back((float)mesh.NumVertices);
+		context.NumTriangles.push_back((float)mesh.NumTriangles);
+		context.MeshNumInstances.push_back(numInstances);
+		context.NumLODs.push_back((float)mesh.NumLODs);
+		context.NumMaterials.push_back((float)(mesh.UsedMaterialsIndices.size() + mesh.UsedMaterialIntancesIndices.size()));
+
+		// Materials first, then the parents of the material instances.
+		for (auto& matID : mesh.UsedMaterialsIndices)
+			context.Materials.push_back(matID);
+		for (auto& matInsID : mesh.UsedMaterialIntancesIndices)
+		{
+			int32 parentIndex = dataSet.MaterialInstancesTable[matInsID].ParentIndex;
+			if (parentIndex >= 0 && parentIndex < (int32)dataSet.MaterialsTable.size())
+				context.Materials.push_back(parentIndex);
+		}
+		context.MaterialOffsets.push_back((int32)context.Materials.size());
+
+		// Calculate the unique texture data.
+		std::map<int32, int32> uniqueTexIDs;
+		for (auto& matID : mesh.UsedMaterialsIndices)
+		{
+			for (auto& texID : dataSet.MaterialsTable[matID].UsedTexturesIndices)
+				uniqueTexIDs.emplace(dataSet.TexturesTable[texID].UniqueId, texID);
+		}
+		for (auto& matInsID : mesh.UsedMaterialIntancesIndices)
+		{
+			for (auto& texID : dataSet.MaterialInstancesTable[matInsID].UsedTexturesIndices)
+				uniqueTexIDs.emplace(dataSet.TexturesTable[texID].UniqueId, texID);
+		}
+		for (auto& texID : uniqueTexIDs)
+			context.Textures.push_back(texID.second);
+		context.TextureOffsets.push_back((int32)context.Textures.size());
+	}
+
+	// Hash join on UniqueId, built on the LOD0 meshes then probed once by every mesh of the LOD.
+	template<typename TMesh>
+	void JoinLODMeshes(const TArray<TMesh>& lod0Meshes, int32 lod0Offset, const TArray<TMesh>& lodMeshes, FSceneAttributeContext::LODColumns& columns)
+	{
+		std::unordered_map<uint32, int32> lod0Indices;
+		lod0Indices.reserve(lod0Meshes.size());
+		for (size_t i = 0; i < lod0Meshes.size(); ++i)
+			lod0Indices.emplace(lod0Meshes[i].UniqueId, lod0Offset + (int32)i);
+
+		for (auto& mesh : lodMeshes)
+		{
+			auto match = lod0Indices.find(mesh.UniqueId);
+			if (match != lod0Indices.end())
+				columns.Meshes[match->second] = (int32)columns.NumVertices.size();
+			columns.NumVertices.push_back((float)mesh.NumVertices);
+			columns.NumTriangles.push_back((float)mesh.NumTriangles);
+			columns.NumMaterials.push_back((float)(mesh.UsedMaterialsIndices.size() + mesh.UsedMaterialIntancesIndices.size()));
+		}
+	}
+
+	// LOD0 mesh value against its match in the compared LOD, compare(context, lod, lod0Mesh, lodMesh).
+	template<typename TCompare>
+	FSceneAttributeKernel LODKernel(int32 compareLOD, const TCompare& compare)
+	{
+		return [compareLOD, compare](const FSceneAttributeContext& context, uint32 begin, uint32 end, float* out)
+		{
+			if (context.LODs.empty())
+			{
+				std::fill(out + begin, out + end, 0.0f);
+				return;
+			}
+
+			const FSceneAttributeContext::LODColumns& lod = context.LODs[(std::min)((size_t)compareLOD, context.LODs.size()) - 1];
+			for (uint32 i = begin; i < end; ++i)
+			{
+				int32 mesh = lod.Meshes[i];
+				out[i] = mesh >= 0 ? compare(context, lod, i, mesh) : 0.0f;
+			}
+		};
+	}
+}
+
+FSceneAttributeEngine::FSceneAttributeEngine()
+{
+	m_kernels.resize(VA_Count);
+
+	RegisterKernel(VA_NumActors, [](const FSceneAttributeContext& context, uint32 begin, uint32 end, float* out)
+	{
+		std::fill(out + begin, out + end, 1.0f);
+	});
+
+	// Mesh.
+	RegisterKernel(VA_NumVertices, MeshColumnKernel(&FSceneAttributeContext::NumVertices));
+	RegisterKernel(VA_NumTriangles, MeshColumnKernel(&FSceneAttributeContext::NumTriangles));
+	RegisterKernel(VA_NumInstances, MeshColumnKernel(&FSceneAttributeContext::MeshNumInstances));
+	RegisterKernel(VA_NumLODs, MeshColumnKernel(&FSceneAttributeContext::NumLODs));
+	RegisterKernel(VA_NumMaterials, MeshColumnKernel(&FSceneAttributeContext::NumMaterials));
+
+	RegisterKernel(VA_NumTextures, [](const FSceneAttributeContext& context, uint32 begin, uint32 end, float* out)
+	{
+		const int32* offsets = context.TextureOffsets.data();
+		for (uint32 i = begin; i < end; ++i)
+			out[i] = (float)(offsets[i + 1] - offsets[i]);
+	});
+
+	// Texture.
+#define RegisterTextureProp(y) \
+	RegisterTextureField(#y, [](const FSceneTextureDataSet& texture) { return (float)texture.y; })
+
+	m_currentKBField = RegisterTextureProp(CurrentKB);
+	RegisterTextureProp(FullyLoadedKB);
+	RegisterTextureProp(NumRefs);
+	RegisterTextureProp(LODBias);
+	RegisterTextureProp(CurrentSizeX);
+	RegisterTextureProp(CurrentSizeY);
+	RegisterTextureProp(SourceSizeX);
+	RegisterTextureProp(SourceSizeY);
+	RegisterTextureProp(NumResidentMips);
+	RegisterTextureProp(CurrentMips);
+
+#undef RegisterTextureProp
+
+	SetTextureAttribution(TA_Full);
+
+	// LOD.
+	SetCompareLOD(1);
+
+	// Material, fields are named after the attribute (without VA_), plain members also after the member.
+#define RegisterMaterialProp(x, y) \
+	AddMaterialFieldAlias(#y, RegisterMaterialAttribute(x, NameOf(x) + 3, [](const FSceneMaterialDataSet& material) { return (float)material.y; }))
+#define RegisterMaterialPropString(x, y) \
+	RegisterMaterialAttribute(x, NameOf(x) + 3, [](const FSceneMaterialDataSet& material) { return StringUtil::WStringToNumeric<float>(material.y); })
+#define RegisterMaterialPropStringGetBetween(x, y, b1, b2) \
+	RegisterMaterialAttribute(x, NameOf(x) + 3, [](const FSceneMaterialDataSet& material) { return ParseBetween(material.y, b1, b2); })
+
+	RegisterMaterialField("NumInstances", [](const FSceneMaterialDataSet& material) { return (float)material.NumInstances; });
+	RegisterMaterialField("NumRefs", [](const FSceneMaterialDataSet& material) { return (float)material.NumRefs; });
+	RegisterMaterialField("NumTextures", [](const FSceneMaterialDataSet& material) { return (float)material.UsedTexturesIndices.size(); });
+
+	RegisterMaterialProp(VA_UniformBufferSize, UniformBufferSize);
+	RegisterMaterialProp(VA_NumUniformBufferMembers, NumUniformBufferMembers);
+	RegisterMaterialProp(VA_Stats_Base_Pass_Shader_Instructions, BPSCount);
+	RegisterMaterialProp(VA_Stats_Base_Pass_Shader_With_Surface_Lightmap, BPSSurfaceLightmap);
+	RegisterMaterialProp(VA_Stats_Base_Pass_Shader_With_Volumetric_Lightmap, BPSVolumetricLightmap);
+	RegisterMaterialProp(VA_Stats_Base_Pass_Vertex_Shader, BPSVertex);
+
+	RegisterMaterialPropStringGetBetween(VA_Stats_Texture_Samplers, TexSamplers, L"_", L"/16");
+	RegisterMaterialPropStringGetBetween(VA_Stats_User_Interpolators_Scalars, UserInterpolators, L"", L"/");
+	RegisterMaterialPropStringGetBetween(VA_Stats_User_Interpolators_Vectors, UserInterpolators, L"(", L"/4 Vectors");
+	RegisterMaterialPropStringGetBetween(VA_Stats_User_Interpolators_TexCoords, UserInterpolators, L"TexCoords: ", L",");
+	RegisterMaterialPropStringGetBetween(VA_Stats_User_Interpolators_Custom, UserInterpolators, L"Custom: ", L")");
+	RegisterMaterialPropStringGetBetween(VA_Stats_Texture_Lookups_VS, TexLookups, L"VS(", L")");
+	RegisterMaterialPropStringGetBetween(VA_Stats_Texture_Lookups_PS, TexLookups, L"PS(", L")");
+
+	RegisterMaterialPropString(VA_Stats_Virtual_Texture_Lookups, VTLookups);
+
+	RegisterMaterialProp(VA_Material_Two_Sided, TwoSided);
+	RegisterMaterialProp(VA_Material_Cast_Ray_Traced_Shadows, bCastRayTracedShadows);
+	RegisterMaterialProp(VA_Translucency_Screen_Space_Reflections, bScreenSpaceReflections);
+	RegisterMaterialProp(VA_Translucency_Contact_Shadows, bContactShadows);
+	RegisterMaterialProp(VA_Translucency_Directional_Lighting_Intensity, TranslucencyDirectionalLightingIntensity);
+	RegisterMaterialProp(VA_Translucency_Apply_Fogging, bUseTranslucencyVertexFog);
+	RegisterMaterialProp(VA_Translucency_Compute_Fog_Per_Pixel, bComputeFogPerPixel);
+	RegisterMaterialProp(VA_Translucency_Output_Velocity, bOutputTranslucentVelocity);
+	RegisterMaterialProp(VA_Translucency_Render_After_DOF, bEnableSeparateTranslucency);
+	RegisterMaterialProp(VA_Translucency_Responsive_AA, bEnableResponsiveAA);
+	RegisterMaterialProp(VA_Translucency_Mobile_Separate_Translucency, bEnableMobileSeparateTranslucency);
+	RegisterMaterialProp(VA_Translucency_Disable_Depth_Test, bDisableDepthTest);
+	RegisterMaterialProp(VA_Translucency_Write_Only_Alpha, bWriteOnlyAlpha);
+	RegisterMaterialProp(VA_Translucency_Allow_Custom_Depth_Writes, AllowTranslucentCustomDepthWrites);
+	RegisterMaterialProp(VA_Mobile_Use_Full_Precision, bUseFullPrecision);
+	RegisterMaterialProp(VA_Mobile_Use_Lightmap_Directionality, bUseLightmapDirectionality);
+	RegisterMaterialProp(VA_Forward_Shading_High_Quality_Reflections, bUseHQForwardReflections);
+	RegisterMaterialProp(VA_Forward_Shading_Planar_Reflections, bUsePlanarForwardReflections);
+
+#undef RegisterMaterialProp
+#undef RegisterMaterialPropString
+#undef RegisterMaterialPropStringGetBetween
+}
+
+void FSceneAttributeEngine::RegisterKernel(EVisualizationAttribute attribute, const FSceneAttributeKernel& kernel)
+{
+	m_kernels[attribute] = kernel;
+}
+
+int32 FSceneAttributeEngine::RegisterMaterialField(const std::string& name, const FSceneMaterialGetter& getter)
+{
+	auto found = m_materialFields.find(name);
+	if (found != m_materialFields.end())
+	{
+		m_materialGetters[found->second] = getter;
+		return found->second;
+	}
+
+	m_materialGetters.push_back(getter);
+	return m_materialFields[name] = (int32)m_materialGetters.size() - 1;
+}
+
+int32 FSceneAttributeEngine::RegisterTextureField(const std::string& name, const FSceneTextureGetter& getter)
+{
+	auto found = m_textureFields.find(name);
+	if (found != m_textureFields.end())
+	{
+		m_textureGetters[found->second] = getter;
+		return found->second;
+	}
+
+	m_textureGetters.push_back(getter);
+	return m_textureFields[name] = (int32)m_textureGetters.size() - 1;
+}
+
+void FSceneAttributeEngine::AddMaterialFieldAlias(const std::string& alias, int32 field)
+{
+	m_materialFields.emplace(alias, field);
+}
+
+int32 FSceneAttributeEngine::FindMaterialField(const std::string& name) const
+{
+	auto found = m_materialFields.find(name);
+	return found != m_materialFields.end() ? found->second : -1;
+}
+
+int32 FSceneAttributeEngine::FindTextureField(const std::string& name) const
+{
+	auto found = m_textureFields.find(name);
+	return found != m_textureFields.end() ? found->second : -1;
+}
+
+int32 FSceneAttributeEngine::RegisterMaterialAttribute(EVisualizationAttribute attribute, const std::string& name, const FSceneMaterialGetter& getter)
+{
+	int32 field = RegisterMaterialField(name, getter);
+
+	RegisterKernel(attribute, [field](const FSceneAttributeContext& context, uint32 begin, uint32 end, float* out)
+	{
+		const int32* offsets = context.MaterialOffsets.data();
+		const int32* materials = context.Materials.data();
+		const float* values = context.MaterialColumns[field].data();
+		for (uint32 i = begin; i < end; ++i)
+		{
+			float sum = 0.0f;
+			for (int32 k = offsets[i]; k < offsets[i + 1]; ++k)
+				sum += values[materials[k]];
+			out[i] = sum;
+		}
+	});
+
+	return field;
+}
+
+bool FSceneAttributeEngine::RegisterExpression(EVisualizationAttribute attribute, const std::string& source, std::string& error)
+{
+	auto expression = std::make_shared<FSceneExpression>();
+	if (!expression->Compile(source, *this, error))
+		return false;
+
+	RegisterKernel(attribute, [expression](const FSceneAttributeContext& context, uint32 begin, uint32 end, float* out)
+	{
+		expression->Evaluate(context, begin, end, out);
+	});
+	return true;
+}
+
+void FSceneAttributeEngine::SetTextureAttribution(ETextureAttribution attribution)
+{
+	m_textureAttribution = attribution;
+
+	// Split modes divide by a reference count, clamped for the meshes without any instance.
+	int32 field = m_currentKBField;
+	RegisterKernel(VA_CurrentKB, [field, attribution](const FSceneAttributeContext& context, uint32 begin, uint32 end, float* out)
+	{
+		const int32* offsets = context.TextureOffsets.data();
+		const int32* textures = context.Textures.data();
+		const float* currentKB = context.TextureColumns[field].data();
+		const float* refs = attribution == TA_SplitByMesh ? context.TextureMeshRefs.data() :
+			attribution == TA_SplitByInstance ? context.TextureInstanceRefs.data() : nullptr;
+		for (uint32 i = begin; i < end; ++i)
+		{
+			float sum = 0.0f;
+			if (refs == nullptr)
+			{
+				for (int32 k = offsets[i]; k < offsets[i + 1]; ++k)
+					sum += currentKB[textures[k]];
+			}
+			else
+			{
+				for (int32 k = offsets[i]; k < offsets[i + 1]; ++k)
+					sum += currentKB[textures[k]] / (std::max)(refs[textures[k]], 1.0f);
+			}
+			out[i] = sum;
+		}
+	});
+}
+
+void FSceneAttributeEngine::SetCompareLOD(int32 lod)
+{
+	m_compareLOD = (std::max)(lod, 1);
+
+	using LODColumns = FSceneAttributeContext::LODColumns;
+	RegisterKernel(VA_LOD_Triangle_Ratio, LODKernel(m_compareLOD, [](const FSceneAttributeContext& context, const LODColumns& lod, uint32 lod0Mesh, int32 lodMesh)
+	{
+		return context.NumTriangles[lod0Mesh] > 0.0f ? lod.NumTriangles[lodMesh] / context.NumTriangles[lod0Mesh] : 0.0f;
+	}));
+	RegisterKernel(VA_LOD_Vertex_Delta, LODKernel(m_compareLOD, [](const FSceneAttributeContext& context, const LODColumns& lod, uint32 lod0Mesh, int32 lodMesh)
+	{
+		return context.NumVertices[lod0Mesh] - lod.NumVertices[lodMesh];
+	}));
+	RegisterKernel(VA_LOD_Material_Delta, LODKernel(m_compareLOD, [](const FSceneAttributeContext& context, const LODColumns& lod, uint32 lod0Mesh, int32 lodMesh)
+	{
+		return context.NumMaterials[lod0Mesh] - lod.NumMaterials[lodMesh];
+	}));
+}
+
+bool FSceneAttributeEngine::HasKernel(EVisualizationAttribute attribute) const
+{
+	return attribute >= 0 && attribute < VA_Count && m_kernels[attribute];
+}
+
+std::unique_ptr<FSceneAttributeContext> FSceneAttributeEngine::BuildContext(const FSceneDataSet& dataSet, const std::vector<const FSceneDataSet*>& lods) const
+{
+	static std::atomic<uint32> g_nextSceneId(0);
+
+	auto context = std::make_unique<FSceneAttributeContext>();
+	context->SceneId = ++g_nextSceneId;
+
+	context->NumStaticMeshes = (uint32)dataSet.StaticMeshesTable.size();
+	context->NumMeshes = context->NumStaticMeshes + (uint32)dataSet.SkeletalMeshesTable.size();
+	context->InstanceOffsets.push_back(0);
+	context->MaterialOffsets.push_back(0);
+	context->TextureOffsets.push_back(0);
+
+	for (auto& staticMesh : dataSet.StaticMeshesTable)
+	{
+		AddMesh(*context, dataSet, staticMesh, (float)staticMesh.NumInstances);
+		context->InstanceOffsets.push_back(context->InstanceOffsets.back() + (int32)staticMesh.BoundsIndices.size());
+	}
+	for (auto& skeletalMesh : dataSet.SkeletalMeshesTable)
+	{
+		AddMesh(*context, dataSet, skeletalMesh, 0.0f);
+		context->InstanceOffsets.push_back(context->InstanceOffsets.back() + 1);
+	}
+	context->NumInstances = (uint32)context->InstanceOffsets.back();
+	context->NumSceneMaterials = (uint32)dataSet.MaterialsTable.size();
+	context->NumSceneTextures = (uint32)dataSet.TexturesTable.size();
+
+	// Mesh -> texture graph reference counts, an instance is one structure buffer slot.
+	context->TextureMeshRefs.assign(context->NumSceneTextures, 0.0f);
+	context->TextureInstanceRefs.assign(context->NumSceneTextures, 0.0f);
+	for (uint32 mesh = 0; mesh < context->NumMeshes; ++mesh)
+	{
+		float numInstances = (float)(context->InstanceOffsets[mesh + 1] - context->InstanceOffsets[mesh]);
+		for (int32 k = context->TextureOffsets[mesh]; k < context->TextureOffsets[mesh + 1]; ++k)
+		{
+			context->TextureMeshRefs[context->Textures[k]] += 1.0f;
+			context->TextureInstanceRefs[context->Textures[k]] += numInstances;
+		}
+	}
+
+	context->LODs.resize(lods.size());
+	for (size_t lod = 0; lod < lods.size(); ++lod)
+	{
+		FSceneAttributeContext::LODColumns& columns = context->LODs[lod];
+		columns.Meshes.assign(context->NumMeshes, -1);
+		JoinLODMeshes(dataSet.StaticMeshesTable, 0, lods[lod]->StaticMeshesTable, columns);
+		JoinLODMeshes(dataSet.SkeletalMeshesTable, (int32)context->NumStaticMeshes, lods[lod]->SkeletalMeshesTable, columns);
+	}
+
+	context->MaterialColumns.resize(m_materialGetters.size());
+	for (size_t field = 0; field < m_materialGetters.size(); ++field)
+	{
+		TArray<float>& column = context->MaterialColumns[field];
+		column.reserve(dataSet.MaterialsTable.size());
+		for (auto& material : dataSet.MaterialsTable)
+			column.push_back(m_materialGetters[field](material));
+	}
+
+	context->TextureColumns.resize(m_textureGetters.size());
+	for (size_t field = 0; field < m_textureGetters.size(); ++field)
+	{
+		TArray<float>& column = context->TextureColumns[field];
+		column.reserve(dataSet.TexturesTable.size());
+		for (auto& texture : dataSet.TexturesTable)
+			column.push_back(m_textureGetters[field](texture));
+	}
+
+	return context;
+}
+
+void FSceneAttributeEngine::EvaluateMeshes(EVisualizationAttribute attribute, const FSceneAttributeContext& context, float* out) const
+{
+	if (!HasKernel(attribute))
+	{
+		std::fill(out, out + context.NumMeshes, 0.0f);
+		return;
+	}
+
+	// Each chunk writes its own slice of out.
+	const FSceneAttributeKernel& kernel = m_kernels[attribute];
+	const uint32 chunkSize = EvaluateChunkSize;
+	size_t numChunks = (context.NumMeshes + chunkSize - 1) / chunkSize;
+	ThreadUtil::ParallelFor(numChunks, [&](size_t chunk, uint32)
+	{
+		uint32 begin = (uint32)chunk * chunkSize;
+		kernel(context, begin, (std::min)(begin + chunkSize, context.NumMeshes), out);
+	});
+}
+
+void FSceneAttributeEngine::EvaluateMeshes(const std::vector<EVisualizationAttribute>& attributes, const FSceneAttributeContext& context, const std::vector<float*>& outs) const
+{
+	// Smaller chunks than the single attribute path, each one does the work of all the attributes.
+	const uint32 chunkSize = (std::max)(EvaluateChunkSize / (uint32)(std::max)(attributes.size(), (size_t)1), 256u);
+	size_t numChunks = (context.NumMeshes + chunkSize - 1) / chunkSize;
+	ThreadUtil::ParallelFor(numChunks, [&](size_t chunk, uint32)
+	{
+		uint32 begin = (uint32)chunk * chunkSize;
+		uint32 end = (std::min)(begin + chunkSize, context.NumMeshes);
+		for (size_t i = 0; i < attributes.size(); ++i)
+		{
+			if (HasKernel(attributes[i]))
+				m_kernels[attributes[i]](context, begin, end, outs[i]);
+			else std::fill(outs[i] + begin, outs[i] + end, 0.0f);
+		}
+	});
+}
+
+void FSceneAttributeEngine::Broadcast(const FSceneAttributeContext& context, const float* meshValues, float* out, FSceneAttributeStats* stats)
+{
+	const int32* offsets = context.InstanceOffsets.data();
+	const uint32 chunkSize = EvaluateChunkSize;
+	size_t numChunks = (context.NumInstances + chunkSize - 1) / chunkSize;
+
+	// One set of stats per worker, merged once all the chunks are done.
+	std::vector<FSceneAttributeStats> workerStats(stats != nullptr ? ThreadUtil::GetWorkerCount() : 0);
+	ThreadUtil::ParallelFor(numChunks, [&](size_t chunk, uint32 worker)
+	{
+		int32 begin = (int32)(chunk * chunkSize);
+		int32 end = (std::min)(begin + (int32)chunkSize, (int32)context.NumInstances);
+
+		// Last mesh starting at or before the chunk, the instances of a mesh are contiguous.
+		int32 mesh = (int32)(std::upper_bound(offsets, offsets + context.NumMeshes + 1, begin) - offsets) - 1;
+		for (int32 i = begin; i < end; ++mesh)
+		{
+			int32 meshEnd = (std::min)(offsets[mesh + 1], end);
+			if (i < meshEnd)
+			{
+				std::fill(out + i, out + meshEnd, meshValues[mesh]);
+				if (stats != nullptr)
+					workerStats[worker].Add(meshValues[mesh], (uint32)(meshEnd - i));
+				i = meshEnd;
+			}
+		}
+	});
+
+	for (auto& partial : workerStats)
+		stats->Merge(partial);
+}
+
+void FSceneAttributeEngine::Evaluate(EVisualizationAttribute attribute, const FSceneAttributeContext& context, float* out, FSceneAttributeStats* stats) const
+{
+	// Mesh level values are computed once, then scattered to the instances.
+	TArray<float> meshValues(context.NumMeshes);
+	EvaluateMeshes(attribute, context, meshValues.data());
+	Broadcast(context, meshValues.data(), out, stats);
+}
@@ -0,0 +1,142 @@
+//
+// FSceneAttributeEngine.h
+//
+
+#pragma once
+
+#include "FSceneAttributeStats.h"
+#include <functional>
+#include <string>
+
+namespace UnrealEngine
+{
+	// Columnar view of one FScene, built once per scene and shared by all the attributes.
+	// Meshes are the static meshes followed by the skeletal meshes, instances follow the
+	// structure buffer layout (every BoundsIndices entry of the static meshes, then one per skeletal mesh).
+	struct FSceneAttributeContext
+	{
+		// Unique per built context, keys the cached columns.
+		uint32 SceneId = 0;
+
+		uint32 NumStaticMeshes = 0;
+		uint32 NumMeshes = 0;
+		uint32 NumInstances = 0;
+		uint32 NumSceneMaterials = 0;
+		uint32 NumSceneTextures = 0;
+
+		// Per mesh instance range (CSR), the instances of a mesh are contiguous.
+		TArray<int32> InstanceOffsets;
+
+		// Per mesh.
+		TArray<float> NumVertices;
+		TArray<float> NumTriangles;
+		TArray<float> MeshNumInstances; // Skeletal meshes have none.
+		TArray<float> NumLODs;
+		TArray<float> NumMaterials;
+
+		// Per mesh material list (CSR), material instances resolved to their parent.
+		TArray<int32> MaterialOffsets;
+		TArray<int32> Materials;
+
+		// Per mesh unique texture set (CSR), ordered by UniqueId.
+		TArray<int32> TextureOffsets;
+		TArray<int32> Textures;
+
+		// Per scene texture, the meshes referencing it and the instances of those meshes.
+		TArray<float> TextureMeshRefs;
+		TArray<float> TextureInstanceRefs;
+
+		// Per LOD after LOD0 (LODs[0] is LOD1), joined on UniqueId when the context is built.
+		struct LODColumns
+		{
+			TArray<int32> Meshes;	// Per LOD0 mesh, its index in the LOD (static then skeletal), -1 if missing.
+			TArray<float> NumVertices;
+			TArray<float> NumTriangles;
+			TArray<float> NumMaterials;
+		};
+		std::vector<LODColumns> LODs;
+
+		// One column per registered material / texture field, parsed once from the records.
+		std::vector<TArray<float>> MaterialColumns;
+		std::vector<TArray<float>> TextureColumns;
+	};
+
+	// Computes the meshes [begin, end) of a per mesh column, out is the whole column.
+	// Every instance of a mesh shares its value.
+	using FSceneAttributeKernel = std::function<void(const FSceneAttributeContext& context, uint32 begin, uint32 end, float* out)>;
+
+	// Extracts one value of a material / texture record.
+	using FSceneMaterialGetter = std::function<float(const FSceneMaterialDataSet& material)>;
+	using FSceneTextureGetter = std::function<float(const FSceneTextureDataSet& texture)>;
+
+	class FSceneAttributeEngine
+	{
+	public:
+
+		// Registers all the built-in attributes.
+		FSceneAttributeEngine();
+
+		void RegisterKernel(EVisualizationAttribute attribute, const FSceneAttributeKernel& kernel);
+
+		// Named per record values, read by the material attributes and the expressions.
+		// Registering a name again adds an alias of the same field. Returns the column index.
+		int32 RegisterMaterialField(const std::string& name, const FSceneMaterialGetter& getter);
+		int32 RegisterTextureField(const std::string& name, const FSceneTextureGetter& getter);
+		void AddMaterialFieldAlias(const std::string& alias, int32 field);
+
+		// -1 if unknown.
+		int32 FindMaterialField(const std::string& name) const;
+		int32 FindTextureField(const std::string& name) const;
+
+		// Attribute summed over the materials used by the mesh, the field is named after the attribute.
+		int32 RegisterMaterialAttribute(EVisualizationAttribute attribute, const std::string& name, const FSceneMaterialGetter& getter);
+
+		// Compiles an FSceneExpression into the attribute kernel, the previous kernel is kept on errors.
+		// Not thread safe, no evaluation may run meanwhile.
+		bool RegisterExpression(EVisualizationAttribute attribute, const std::string& source, std::string& error);
+
+		// Swaps the VA_CurrentKB kernel, the reference counts are part of the context so nothing is rebuilt.
+		// Not thread safe, no evaluation may run meanwhile.
+		void SetTextureAttribution(ETextureAttribution attribution);
+		ETextureAttribution GetTextureAttribution() const { return m_textureAttribution; }
+
+		// LOD compared by the LOD attributes, clamped to the last LOD of every scene.
+		// Not thread safe, no evaluation may run meanwhile.
+		void SetCompareLOD(int32 lod);
+		int32 GetCompareLOD() const { return m_compareLOD; }
+
+		bool HasKernel(EVisualizationAttribute attribute) const;
+
+		// lods are the LOD1..N tables of the same scene, compared against dataSet by the LOD attributes.
+		std::unique_ptr<FSceneAttributeContext> BuildContext(const FSceneDataSet& dataSet,
+			const std::vector<const FSceneDataSet*>& lods = std::vector<const FSceneDataSet*>()) const;
+
+		// Per mesh values, out must hold context.NumMeshes values, unknown attributes give 0.
+		// The mesh range is split in chunks evaluated on all the cores.
+		void EvaluateMeshes(EVisualizationAttribute attribute, const FSceneAttributeContext& context, float* out) const;
+
+		// Fused version, outs[i] receives the per mesh values of attributes[i]. Every chunk of meshes runs
+		// all the kernels back to back while its material / texture lists are still in cache.
+		void EvaluateMeshes(const std::vector<EVisualizationAttribute>& attributes, const FSceneAttributeContext& context, const std::vector<float*>& outs) const;
+
+		// Scatter per mesh values to the instance slots, out must hold context.NumInstances values.
+		// Per instance statistics are gathered in the same pass when stats is set.
+		static void Broadcast(const FSceneAttributeContext& context, const float* meshValues, float* out, FSceneAttributeStats* stats = nullptr);
+
+		// Per instance values, EvaluateMeshes then Broadcast.
+		void Evaluate(EVisualizationAttribute attribute, const FSceneAttributeContext& context, float* out, FSceneAttributeStats* stats = nullptr) const;
+
+		static const uint32 EvaluateChunkSize = 16 * 1024;
+
+	private:
+
+		std::vector<FSceneAttributeKernel> m_kernels;
+		std::vector<FSceneMaterialGetter> m_materialGetters;
+		std::vector<FSceneTextureGetter> m_textureGetters;
+		std::unordered_map<std::string, int32> m_materialFields;
+		std::unordered_map<std::string, int32> m_textureFields;
+		int32 m_currentKBField = -1;
+		ETextureAttribution m_textureAttribution = TA_Full;
+		int32 m_compareLOD = 1;
+	};
+}
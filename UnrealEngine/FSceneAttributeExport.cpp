@@ -0,0 +1,268 @@
+//
+// FSceneAttributeExport.cpp
+//
+
+#include "FSceneAttributeExport.h"
+#include "../Common/StringManager.h"
+#include "../Common/ThreadManager.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using namespace UnrealEngine;
+using namespace DX::StringManager;
+using namespace DX::ThreadManager;
+
+namespace
+{
+#define AttributeName(x) NameOf(x) + 3
+
+	const char* const AttributeNames[] =
+	{
+		AttributeName(VA_NumActors),
+		AttributeName(VA_NumVertices),
+		AttributeName(VA_NumTriangles),
+		AttributeName(VA_NumInstances),
+		AttributeName(VA_NumLODs),
+		AttributeName(VA_NumMaterials),
+		AttributeName(VA_NumTextures),
+		AttributeName(VA_UniformBufferSize),
+		AttributeName(VA_NumUniformBufferMembers),
+		AttributeName(VA_Stats_Base_Pass_Shader_Instructions),
+		AttributeName(VA_Stats_Base_Pass_Shader_With_Surface_Lightmap),
+		AttributeName(VA_Stats_Base_Pass_Shader_With_Volumetric_Lightmap),
+		AttributeName(VA_Stats_Base_Pass_Vertex_Shader),
+		AttributeName(VA_Stats_Texture_Samplers),
+		AttributeName(VA_Stats_User_Interpolators_Scalars),
+		AttributeName(VA_Stats_User_Interpolators_Vectors),
+		AttributeName(VA_Stats_User_Interpolators_TexCoords),
+		AttributeName(VA_Stats_User_Interpolators_Custom),
+		AttributeName(VA_Stats_Texture_Lookups_VS),
+		AttributeName(VA_Stats_Texture_Lookups_PS),
+		AttributeName(VA_Stats_Virtual_Texture_Lookups),
+		AttributeName(VA_Material_Two_Sided),
+		AttributeName(VA_Material_Cast_Ray_Traced_Shadows),
+		AttributeName(VA_Translucency_Screen_Space_Reflections),
+		AttributeName(VA_Translucency_Contact_Shadows),
+		AttributeName(VA_Translucency_Directional_Lighting_Intensity),
+		AttributeName(VA_Translucency_Apply_Fogging),
+		AttributeName(VA_Translucency_Compute_Fog_Per_Pixel),
+		AttributeName(VA_Translucency_Output_Velocity),
+		AttributeName(VA_Translucency_Render_After_DOF),
+		AttributeName(VA_Translucency_Responsive_AA),
+		AttributeName(VA_Translucency_Mobile_Separate_Translucency),
+		AttributeName(VA_Translucency_Disable_Depth_Test),
+		AttributeName(VA_Translucency_Write_Only_Alpha),
+		AttributeName(VA_Translucency_Allow_Custom_Depth_Writes),
+		AttributeName(VA_Mobile_Use_Full_Precision),
+		AttributeName(VA_Mobile_Use_Lightmap_Directionality),
+		AttributeName(VA_Forward_Shading_High_Quality_Reflections),
+		AttributeName(VA_Forward_Shading_Planar_Reflections),
+		AttributeName(VA_CurrentKB),
+		AttributeName(VA_LOD_Triangle_Ratio),
+		AttributeName(VA_LOD_Vertex_Delta),
+		AttributeName(VA_LOD_Material_Delta),
+		AttributeName(VA_Custom)
+	};
+
+#undef AttributeName
+
+	static_assert(sizeof(AttributeNames) / sizeof(AttributeNames[0]) == VA_Count, "AttributeNames is out of sync with EVisualizationAttribute");
+
+	// Instances of a block are split in ranges, the unit of work of the block passes.
+	const uint32 RangeSize = 16 * 1024;
+
+	template<typename T>
+	void WriteValue(std::ofstream& fout, const T& value)
+	{
+		fout.write((const char*)&value, sizeof(T));
+	}
+
+	std::string QuoteCsv(const std::string& str)
+	{
+		std::string quoted = "\"";
+		for (char c : str)
+		{
+			if (c == '"')
+				quoted += '"';
+			quoted += c;
+		}
+		return quoted + "\"";
+	}
+}
+
+const char* FSceneAttributeExport::GetAttributeName(EVisualizationAttribute attribute)
+{
+	return attribute >= 0 && attribute < VA_Count ? AttributeNames[attribute] : "";
+}
+
+bool FSceneAttributeExport::Run(const FSceneAttributeEngine& engine, const FSceneDataSet& dataSet, const std::vector<const FSceneDataSet*>& lods,
+	const std::wstring& binPath, const std::wstring& csvPath, std::string& error)
+{
+	std::unique_ptr<FSceneAttributeContext> context = engine.BuildContext(dataSet, lods);
+	const uint32 numInstances = context->NumInstances;
+	const uint32 version = Version;
+	const uint32 blockSize = BlockSize;
+
+	std::vector<EVisualizationAttribute> attributes;
+	for (int32 attribute = 0; attribute < VA_Count; ++attribute)
+	{
+		if (engine.HasKernel((EVisualizationAttribute)attribute))
+			attributes.push_back((EVisualizationAttribute)attribute);
+	}
+	const size_t numAttributes = attributes.size();
+
+	// Every attribute per mesh, in one pass over the material / texture lists.
+	std::vector<TArray<float>> meshValues(numAttributes, TArray<float>(context->NumMeshes));
+	std::vector<float*> outs;
+	for (auto& column : meshValues)
+		outs.push_back(column.data());
+	engine.EvaluateMeshes(attributes, *context, outs);
+
+	std::ofstream bin(binPath, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+	if (!bin.good())
+	{
+		error = "Can't open the binary output";
+		return false;
+	}
+
+	std::ofstream csv;
+	if (!csvPath.empty())
+	{
+		csv.open(csvPath, std::ofstream::out | std::ofstream::trunc);
+		if (!csv.good())
+		{
+			error = "Can't open the CSV output";
+			return false;
+		}
+	}
+
+	// Header.
+	const uint32 numColumns = (uint32)numAttributes + 1;
+	bin.write("FSAX", 4);
+	WriteValue(bin, version);
+	WriteValue(bin, numInstances);
+	WriteValue(bin, numColumns);
+	auto writeColumnHeader = [&bin](uint8 type, const char* name)
+	{
+		uint32 length = (uint32)std::strlen(name);
+		WriteValue(bin, type);
+		WriteValue(bin, length);
+		bin.write(name, length);
+	};
+	writeColumnHeader(1, "Mesh");
+	for (auto attribute : attributes)
+		writeColumnHeader(0, GetAttributeName(attribute));
+
+	// The file is sized up front, the blocks then seek inside it.
+	const uint64 dataOffset = (uint64)bin.tellp();
+	const uint64 columnBytes = (uint64)numInstances * sizeof(float);
+	if (numInstances > 0)
+	{
+		bin.seekp(dataOffset + columnBytes * numColumns - 1);
+		bin.put(0);
+	}
+
+	std::vector<std::string> meshNames;
+	if (csv.is_open())
+	{
+		csv << "\"Instance\",\"Mesh\",\"Name\"";
+		for (auto attribute : attributes)
+			csv << "," << QuoteCsv(GetAttributeName(attribute));
+		csv << "\n";
+
+		meshNames.resize(context->NumMeshes);
+		ThreadUtil::ParallelFor(context->NumMeshes, [&](size_t mesh, uint32)
+		{
+			const FString& name = mesh < context->NumStaticMeshes ? dataSet.StaticMeshesTable[mesh].Name :
+				dataSet.SkeletalMeshesTable[mesh - context->NumStaticMeshes].Name;
+			meshNames[mesh] = QuoteCsv(StringUtil::WStringToString(name));
+		});
+	}
+
+	const int32* offsets = context->InstanceOffsets.data();
+	TArray<int32> meshBlock(blockSize);
+	TArray<float> valueBlock((size_t)numAttributes * blockSize);
+	std::vector<std::string> csvRanges(blockSize / RangeSize);
+
+	for (uint32 blockBegin = 0; blockBegin < numInstances; blockBegin += blockSize)
+	{
+		const uint32 blockCount = (std::min)(blockSize, numInstances - blockBegin);
+		const size_t numRanges = (blockCount + RangeSize - 1) / RangeSize;
+
+		// Owning mesh of every instance, the instances of a mesh are contiguous.
+		ThreadUtil::ParallelFor(numRanges, [&](size_t range, uint32)
+		{
+			int32 begin = (int32)(blockBegin + range * RangeSize);
+			int32 end = (std::min)(begin + (int32)RangeSize, (int32)(blockBegin + blockCount));
+			int32 mesh = (int32)(std::upper_bound(offsets, offsets + context->NumMeshes + 1, begin) - offsets) - 1;
+			for (int32 i = begin; i < end; ++i)
+			{
+				while (offsets[mesh + 1] <= i)
+					++mesh;
+				meshBlock[i - blockBegin] = mesh;
+			}
+		});
+
+		// Attributes x ranges.
+		ThreadUtil::ParallelFor(numRanges * numAttributes, [&](size_t job, uint32)
+		{
+			size_t attribute = job % numAttributes;
+			uint32 begin = (uint32)(job / numAttributes) * RangeSize;
+			uint32 end = (std::min)(begin + RangeSize, blockCount);
+			const float* values = meshValues[attribute].data();
+			float* out = valueBlock.data() + attribute * blockSize;
+			for (uint32 i = begin; i < end; ++i)
+				out[i] = values[meshBlock[i]];
+		});
+
+		if (csv.is_open())
+		{
+			ThreadUtil::ParallelFor(numRanges, [&](size_t range, uint32)
+			{
+				uint32 begin = (uint32)range * RangeSize;
+				uint32 end = (std::min)(begin + RangeSize, blockCount);
+				std::string& text = csvRanges[range];
+				text.clear();
+				char buffer[32];
+				for (uint32 i = begin; i < end; ++i)
+				{
+					std::snprintf(buffer, sizeof(buffer), "%u,%d,", blockBegin + i, meshBlock[i]);
+					text += buffer;
+					text += meshNames[meshBlock[i]];
+					for (size_t attribute = 0; attribute < numAttributes; ++attribute)
+					{
+						std::snprintf(buffer, sizeof(buffer), ",%.9g", valueBlock[attribute * blockSize + i]);
+						text += buffer;
+					}
+					text += '\n';
+				}
+			});
+			for (size_t range = 0; range < numRanges; ++range)
+				csv << csvRanges[range];
+		}
+
+		// Block slice of every column.
+		const uint64 blockOffset = (uint64)blockBegin * sizeof(float);
+		bin.seekp(dataOffset + blockOffset);
+		bin.write((const char*)meshBlock.data(), blockCount * sizeof(int32));
+		for (size_t attribute = 0; attribute < numAttributes; ++attribute)
+		{
+			bin.seekp(dataOffset + columnBytes * (attribute + 1) + blockOffset);
+			bin.write((const char*)(valueBlock.data() + attribute * blockSize), blockCount * sizeof(float));
+		}
+	}
+
+	bin.close();
+	if (csv.is_open())
+		csv.close();
+	if (bin.fail() || csv.fail())
+	{
+		error = "Failed to write the export";
+		return false;
+	}
+
+	error.clear();
+	return true;
+}
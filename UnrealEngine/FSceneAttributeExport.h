@@ -0,0 +1,40 @@
+//
+// FSceneAttributeExport.h
+//
+
+#pragma once
+
+#include "FSceneAttributeEngine.h"
+
+namespace UnrealEngine
+{
+	// Per instance values of every attribute with a kernel, for offline dashboards.
+	//
+	// Binary file (little endian), columnar:
+	//   char   Magic[4] = "FSAX"
+	//   uint32 Version = 1
+	//   uint32 NumInstances
+	//   uint32 NumColumns
+	//   NumColumns x { uint8 Type (0 = float32, 1 = int32), uint32 NameLength, char Name[NameLength] }
+	//   NumColumns x NumInstances values of 4 bytes, one column after the other.
+	// The first column is the int32 "Mesh" index (static meshes, then skeletal meshes), then one
+	// float32 column per attribute named after it without the VA_ prefix.
+	//
+	// The CSV (optional) holds one row per instance: Instance, Mesh, Name, then the attributes.
+	class FSceneAttributeExport
+	{
+	public:
+
+		// All the attributes are evaluated per mesh in one fused pass, then written by blocks of
+		// instances, each block being scattered on all the cores (attributes x instance ranges).
+		// lods are the other LODs of the scene, see FSceneAttributeEngine::BuildContext.
+		static bool Run(const FSceneAttributeEngine& engine, const FSceneDataSet& dataSet, const std::vector<const FSceneDataSet*>& lods,
+			const std::wstring& binPath, const std::wstring& csvPath, std::string& error);
+
+		// "NumTriangles" for VA_NumTriangles.
+		static const char* GetAttributeName(EVisualizationAttribute attribute);
+
+		static const uint32 BlockSize = 256 * 1024;
+		static const uint32 Version = 1;
+	};
+}
@@ -0,0 +1,135 @@
+//
+// FSceneAttributeQuery.cpp
+//
+
+#include "FSceneAttributeQuery.h"
+#include "../Common/ThreadManager.h"
+#include <algorithm>
+
+using namespace UnrealEngine;
+using namespace DX::ThreadManager;
+
+namespace
+{
+	struct Candidate
+	{
+		float Value;
+		uint64 Index;
+	};
+
+	// Heavier first, the lower index wins a tie.
+	bool IsHeavier(const Candidate& a, const Candidate& b)
+	{
+		return a.Value > b.Value || (a.Value == b.Value && a.Index < b.Index);
+	}
+
+	// Min-heap on IsHeavier, the lightest kept candidate is on top.
+	void Offer(std::vector<Candidate>& heap, uint32 n, const Candidate& candidate)
+	{
+		if (heap.size() < n)
+		{
+			heap.push_back(candidate);
+			std::push_heap(heap.begin(), heap.end(), IsHeavier);
+		}
+		else if (IsHeavier(candidate, heap.front()))
+		{
+			std::pop_heap(heap.begin(), heap.end(), IsHeavier);
+			heap.back() = candidate;
+			std::push_heap(heap.begin(), heap.end(), IsHeavier);
+		}
+	}
+
+	// Candidates of [0, count) by chunk on all the cores, merged and sorted heaviest first.
+	template<typename TValueAt>
+	std::vector<Candidate> SelectTopN(uint64 count, uint32 n, const TValueAt& valueAt)
+	{
+		std::vector<Candidate> top;
+		if (n == 0 || count == 0)
+			return top;
+
+		const uint64 chunkSize = FSceneAttributeEngine::EvaluateChunkSize;
+		size_t numChunks = (size_t)((count + chunkSize - 1) / chunkSize);
+		std::vector<std::vector<Candidate>> heaps(numChunks);
+		ThreadUtil::ParallelFor(numChunks, [&](size_t chunk, uint32)
+		{
+			std::vector<Candidate>& heap = heaps[chunk];
+			heap.reserve(n);
+			uint64 end = (std::min)((chunk + 1) * chunkSize, count);
+			for (uint64 i = chunk * chunkSize; i < end; ++i)
+			{
+				float value = valueAt(i);
+				// Cheap reject before touching the heap, most values never make it in.
+				if (value != value || (heap.size() == n && value < heap.front().Value))
+					continue;
+				Candidate candidate = { value, i };
+				Offer(heap, n, candidate);
+			}
+		});
+
+		for (auto& heap : heaps)
+		{
+			for (auto& candidate : heap)
+				Offer(top, n, candidate);
+		}
+		std::sort(top.begin(), top.end(), IsHeavier);
+		return top;
+	}
+}
+
+std::vector<uint32> FSceneAttributeQuery::TopN(const float* values, uint32 count, uint32 n)
+{
+	std::vector<uint32> indices;
+	for (auto& candidate : SelectTopN(count, n, [values](uint64 i) { return values[i]; }))
+		indices.push_back((uint32)candidate.Index);
+	return indices;
+}
+
+std::vector<FSceneQueryHit> FSceneAttributeQuery::TopMeshes(const FSceneAttributeEngine& engine, EVisualizationAttribute attribute,
+	const std::vector<std::shared_ptr<const FSceneAttributeContext>>& contexts, uint32 n)
+{
+	std::vector<FSceneQueryHit> hits;
+	for (uint32 scene = 0; scene < (uint32)contexts.size(); ++scene)
+	{
+		const FSceneAttributeContext& context = *contexts[scene];
+		TArray<float> meshValues(context.NumMeshes);
+		engine.EvaluateMeshes(attribute, context, meshValues.data());
+
+		// The best n of every scene, then the best n of those.
+		for (uint32 mesh : TopN(meshValues.data(), context.NumMeshes, n))
+		{
+			FSceneQueryHit hit = { scene, mesh, -1, meshValues[mesh] };
+			hits.push_back(hit);
+		}
+	}
+
+	std::stable_sort(hits.begin(), hits.end(), [](const FSceneQueryHit& a, const FSceneQueryHit& b) { return a.Value > b.Value; });
+	if (hits.size() > n)
+		hits.resize(n);
+	return hits;
+}
+
+std::vector<FSceneQueryHit> FSceneAttributeQuery::TopInstances(const std::vector<std::shared_ptr<const FSceneAttributeContext>>& contexts,
+	const std::vector<const TArray<float>*>& columns, uint32 n)
+{
+	std::vector<FSceneQueryHit> hits;
+	for (uint32 scene = 0; scene < (uint32)contexts.size(); ++scene)
+	{
+		const TArray<float>& column = *columns[scene];
+		for (uint32 instance : TopN(column.data(), (uint32)column.size(), n))
+		{
+			FSceneQueryHit hit = { scene, GetInstanceMesh(*contexts[scene], instance), (int32)instance, column[instance] };
+			hits.push_back(hit);
+		}
+	}
+
+	std::stable_sort(hits.begin(), hits.end(), [](const FSceneQueryHit& a, const FSceneQueryHit& b) { return a.Value > b.Value; });
+	if (hits.size() > n)
+		hits.resize(n);
+	return hits;
+}
+
+uint32 FSceneAttributeQuery::GetInstanceMesh(const FSceneAttributeContext& context, uint32 instance)
+{
+	const int32* offsets = context.InstanceOffsets.data();
+	return (uint32)(std::upper_bound(offsets, offsets + context.NumMeshes + 1, (int32)instance) - offsets) - 1;
+}
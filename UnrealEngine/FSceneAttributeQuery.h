@@ -0,0 +1,42 @@
+//
+// FSceneAttributeQuery.h
+//
+
+#pragma once
+
+#include "FSceneAttributeEngine.h"
+
+namespace UnrealEngine
+{
+	// One hit of a query, Instance is -1 for mesh level queries.
+	struct FSceneQueryHit
+	{
+		uint32 Scene;
+		uint32 Mesh;
+		int32 Instance;
+		float Value;
+	};
+
+	class FSceneAttributeQuery
+	{
+	public:
+
+		// Indices of the n largest values, largest first (ties by lower index). A bounded
+		// min-heap per chunk keeps it O(count log n), the chunk heaps are merged at the end. NaNs are skipped.
+		static std::vector<uint32> TopN(const float* values, uint32 count, uint32 n);
+
+		// Heaviest meshes of all the scenes, by their per mesh value.
+		static std::vector<FSceneQueryHit> TopMeshes(const FSceneAttributeEngine& engine, EVisualizationAttribute attribute,
+			const std::vector<std::shared_ptr<const FSceneAttributeContext>>& contexts, uint32 n);
+
+		// Heaviest instances of all the scenes, columns[s] holds the per instance values of contexts[s].
+		static std::vector<FSceneQueryHit> TopInstances(const std::vector<std::shared_ptr<const FSceneAttributeContext>>& contexts,
+			const std::vector<const TArray<float>*>& columns, uint32 n);
+
+		// Mesh of an instance slot.
+		static uint32 GetInstanceMesh(const FSceneAttributeContext& context, uint32 instance);
+
+		// Largest n the GUI asks for, every chunk reserves a heap of n candidates.
+		static const uint32 MaxTopN = 1000;
+	};
+}
@@ -0,0 +1,142 @@
+//
+// FSceneAttributeStats.cpp
+//
+
+#include "FSceneAttributeStats.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace UnrealEngine;
+
+FSceneAttributeStats::FSceneAttributeStats()
+	: m_min(std::numeric_limits<float>::max())
+	, m_max(std::numeric_limits<float>::lowest())
+	, m_histogram(NumBins, 0)
+{
+}
+
+void FSceneAttributeStats::Add(float value, uint32 count)
+{
+	if (value != value || count == 0)
+		return;
+
+	m_count += count;
+	m_sum += (double)value * count;
+	m_sumSquares += (double)value * value * count;
+	m_min = (std::min)(m_min, value);
+	m_max = (std::max)(m_max, value);
+	m_histogram[GetBin(value)] += count;
+}
+
+void FSceneAttributeStats::Merge(const FSceneAttributeStats& other)
+{
+	if (other.m_count == 0)
+		return;
+
+	m_count += other.m_count;
+	m_sum += other.m_sum;
+	m_sumSquares += other.m_sumSquares;
+	m_min = (std::min)(m_min, other.m_min);
+	m_max = (std::max)(m_max, other.m_max);
+	for (uint32 bin = 0; bin < NumBins; ++bin)
+		m_histogram[bin] += other.m_histogram[bin];
+}
+
+float FSceneAttributeStats::GetMean() const
+{
+	return m_count > 0 ? (float)(m_sum / m_count) : 0.0f;
+}
+
+float FSceneAttributeStats::GetStdDev() const
+{
+	if (m_count == 0)
+		return 0.0f;
+	double mean = m_sum / m_count;
+	return (float)std::sqrt((std::max)(0.0, m_sumSquares / m_count - mean * mean));
+}
+
+float FSceneAttributeStats::GetPercentile(float percentile) const
+{
+	if (m_count == 0)
+		return 0.0f;
+
+	double rank = (std::min)((std::max)(percentile, 0.0f), 100.0f) / 100.0 * m_count;
+	uint64 cumulative = 0;
+	for (uint32 bin = 0; bin < NumBins; ++bin)
+	{
+		uint32 count = m_histogram[bin];
+		if (count == 0 || cumulative + count < rank)
+		{
+			cumulative += count;
+			continue;
+		}
+
+		// Linear inside the bin.
+		float lower, upper;
+		GetBinRange(bin, lower, upper);
+		float fraction = (float)((rank - cumulative) / count);
+		return lower + (upper - lower) * fraction;
+	}
+	return m_max;
+}
+
+FSceneAttributeSummary FSceneAttributeStats::GetSummary(uint32 numBins) const
+{
+	FSceneAttributeSummary summary;
+	summary.Count = m_count;
+	summary.Min = GetMin();
+	summary.Max = GetMax();
+	summary.Mean = GetMean();
+	summary.StdDev = GetStdDev();
+	summary.P50 = GetPercentile(50.0f);
+	summary.P90 = GetPercentile(90.0f);
+	summary.P99 = GetPercentile(99.0f);
+
+	summary.Histogram.assign(numBins, 0.0f);
+	if (m_count == 0 || numBins == 0)
+		return summary;
+
+	// Each fine bin lands in the display bin of its (clamped) centre.
+	double range = (double)m_max - m_min;
+	for (uint32 bin = 0; bin < NumBins; ++bin)
+	{
+		if (m_histogram[bin] == 0)
+			continue;
+
+		float lower, upper;
+		GetBinRange(bin, lower, upper);
+		double centre = 0.5 * ((double)lower + upper);
+		uint32 index = range > 0.0 ? (uint32)((centre - m_min) / range * numBins) : 0;
+		summary.Histogram[(std::min)(index, numBins - 1)] += (float)m_histogram[bin];
+	}
+	return summary;
+}
+
+void FSceneAttributeStats::GetBinRange(uint32 bin, float& lower, float& upper) const
+{
+	// Clamped to the values actually seen, the outer bins would give NaN / infinite bounds.
+	lower = GetBinLowerBound(bin);
+	upper = bin + 1 < NumBins ? GetBinLowerBound(bin + 1) : m_max;
+	if (!(lower >= m_min))
+		lower = m_min;
+	if (!(upper <= m_max))
+		upper = m_max;
+}
+
+uint32 FSceneAttributeStats::GetBin(float value)
+{
+	// Flip the bits so the unsigned keys sort like the floats.
+	uint32 bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	uint32 key = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+	return key >> 19;
+}
+
+float FSceneAttributeStats::GetBinLowerBound(uint32 bin)
+{
+	uint32 key = bin << 19;
+	uint32 bits = (key & 0x80000000u) ? (key & 0x7FFFFFFFu) : ~key;
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
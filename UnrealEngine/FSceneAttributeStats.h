@@ -0,0 +1,52 @@
+//
+// FSceneAttributeStats.h
+//
+
+#pragma once
+
+#include "../AppData.h"
+
+namespace UnrealEngine
+{
+	// Running statistics of an attribute column, filled by the pass that writes the column.
+	// Histogram bins follow the float bit pattern (sign, exponent and the top 4 mantissa bits),
+	// so they need no range up front and the stats of chunks / scenes merge exactly.
+	// Percentiles are interpolated inside their bin, within ~6% of the exact value.
+	class FSceneAttributeStats
+	{
+	public:
+
+		FSceneAttributeStats();
+
+		// NaNs are skipped.
+		void Add(float value, uint32 count = 1);
+		void Merge(const FSceneAttributeStats& other);
+
+		uint64 GetCount() const { return m_count; }
+		float GetMin() const { return m_count > 0 ? m_min : 0.0f; }
+		float GetMax() const { return m_count > 0 ? m_max : 0.0f; }
+		float GetMean() const;
+		float GetStdDev() const;
+
+		// percentile in [0, 100].
+		float GetPercentile(float percentile) const;
+
+		// Display summary, the histogram folded to numBins linear bins over [min, max].
+		FSceneAttributeSummary GetSummary(uint32 numBins = 64) const;
+
+		static const uint32 NumBins = 1 << 13;
+
+	private:
+
+		static uint32 GetBin(float value);
+		static float GetBinLowerBound(uint32 bin);
+		void GetBinRange(uint32 bin, float& lower, float& upper) const;
+
+		uint64 m_count = 0;
+		double m_sum = 0.0;
+		double m_sumSquares = 0.0;
+		float m_min;
+		float m_max;
+		std::vector<uint32> m_histogram;
+	};
+}
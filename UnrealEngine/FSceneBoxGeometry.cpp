@@ -0,0 +1,124 @@
+//
+// FSceneBoxGeometry.cpp
+//
+
+#include "FSceneBoxGeometry.h"
+#include "../Common/ThreadManager.h"
+#include <algorithm>
+
+using namespace UnrealEngine;
+using namespace DX::ThreadManager;
+
+// UE4 (x, y, z) -> (-x, z, y), like RightHandToLeft.
+const float FSceneBoxGeometry::UnitCorners[NumCorners][3] =
+{
+	{ +1.0f, +1.0f, -1.0f },
+	{ -1.0f, +1.0f, -1.0f },
+	{ -1.0f, +1.0f, +1.0f },
+	{ +1.0f, +1.0f, +1.0f },
+	{ +1.0f, -1.0f, -1.0f },
+	{ -1.0f, -1.0f, -1.0f },
+	{ -1.0f, -1.0f, +1.0f },
+	{ +1.0f, -1.0f, +1.0f }
+};
+
+const uint16 FSceneBoxGeometry::UnitIndices[NumIndices] =
+{
+	// front face
+	0, 1, 2,
+	0, 2, 3,
+
+	// back face
+	4, 6, 5,
+	4, 7, 6,
+
+	// left face
+	4, 5, 1,
+	4, 1, 0,
+
+	// right face
+	3, 2, 6,
+	3, 6, 7,
+
+	// top face
+	1, 5, 6,
+	1, 6, 2,
+
+	// bottom face
+	4, 0, 3,
+	4, 3, 7
+};
+
+namespace
+{
+	FSceneBoxInstance ToInstance(const FBoxSphereBounds& bounds, uint32 slot)
+	{
+		const XMFLOAT3& center = bounds.BoxBounds.Center;
+		const XMFLOAT3& extents = bounds.BoxBounds.Extents;
+		FSceneBoxInstance instance;
+		instance.Center[0] = -center.x;
+		instance.Center[1] = center.z;
+		instance.Center[2] = center.y;
+		instance.Extent[0] = extents.x;
+		instance.Extent[1] = extents.z;
+		instance.Extent[2] = extents.y;
+		instance.Slot = slot;
+		return instance;
+	}
+}
+
+void FSceneBoxGeometry::BuildInstances(const FSceneDataSet& dataSet, std::vector<FSceneBoxInstance>& instances)
+{
+	// First slot of every static mesh, the skeletal meshes follow.
+	const size_t numStaticMeshes = dataSet.StaticMeshesTable.size();
+	std::vector<size_t> firstSlots(numStaticMeshes + 1, 0);
+	for (size_t mesh = 0; mesh < numStaticMeshes; ++mesh)
+		firstSlots[mesh + 1] = firstSlots[mesh] + dataSet.StaticMeshesTable[mesh].BoundsIndices.size();
+	const size_t numSkeletalMeshes = dataSet.SkeletalMeshesTable.size();
+	const size_t numSkeletalChunks = (numSkeletalMeshes + ChunkSize - 1) / ChunkSize;
+
+	instances.resize(firstSlots.back() + numSkeletalMeshes);
+	ThreadUtil::ParallelFor(numStaticMeshes + numSkeletalChunks, [&](size_t task, uint32)
+	{
+		if (task < numStaticMeshes)
+		{
+			size_t slot = firstSlots[task];
+			for (auto& boundsIndex : dataSet.StaticMeshesTable[task].BoundsIndices)
+			{
+				instances[slot] = ToInstance(dataSet.BoundsTable[boundsIndex], (uint32)slot);
+				slot++;
+			}
+			return;
+		}
+
+		size_t chunk = task - numStaticMeshes;
+		size_t end = (std::min)((chunk + 1) * ChunkSize, numSkeletalMeshes);
+		for (size_t mesh = chunk * ChunkSize; mesh < end; ++mesh)
+		{
+			size_t slot = firstSlots.back() + mesh;
+			instances[slot] = ToInstance(dataSet.BoundsTable[dataSet.SkeletalMeshesTable[mesh].BoundsIndex], (uint32)slot);
+		}
+	});
+}
+
+void FSceneBoxGeometry::WriteBakedBoxes(const FSceneBoxInstance* instances, size_t count, uint8* vertices, uint32 vertexStride, uint32* indices,
+	const float* color)
+{
+	ThreadUtil::ParallelFor((count + ChunkSize - 1) / ChunkSize, [&](size_t chunk, uint32)
+	{
+		size_t end = (std::min)((chunk + 1) * ChunkSize, count);
+		for (size_t i = chunk * ChunkSize; i < end; ++i)
+		{
+			for (uint32 corner = 0; corner < NumCorners; ++corner)
+			{
+				float* position = reinterpret_cast<float*>(vertices + (i * NumCorners + corner) * vertexStride);
+				GetCorner(instances[i], corner, position);
+				position[3] = 1.0f;
+				if (color != nullptr)
+					std::copy(color, color + 4, position + 4);
+			}
+			for (uint32 index = 0; index < NumIndices; ++index)
+				indices[i * NumIndices + index] = (uint32)(i * NumCorners) + UnitIndices[index];
+		}
+	});
+}
@@ -0,0 +1,52 @@
+//
+// FSceneBoxGeometry.h
+//
+
+#pragma once
+
+#include "../AppData.h"
+
+namespace UnrealEngine
+{
+	// One FScene box of the instanced BoxInstancedVS, in render space before FSceneScale. 28 bytes against
+	// 8 ColorVertex corners and 36 indices for the baked geometry.
+	struct FSceneBoxInstance
+	{
+		float Center[3];
+		float Extent[3];	// Half size along each render space axis.
+		uint32 Slot;		// Instance slot in its scene, the colour is gPerBoxData[gPerFSceneSBufferOffset + Slot].
+	};
+
+	// CPU side of the instanced FScene boxes: one shared unit box, scaled and moved by every instance.
+	// Corner i of an instance is Center + Extent * UnitCorners[i], the corner the baked geometry gets from
+	// GetCorners + RightHandToLeft, bit for bit (the unit corners are +-1).
+	class FSceneBoxGeometry
+	{
+	public:
+
+		static const uint32 NumCorners = 8;
+		static const uint32 NumIndices = 36;
+		static const size_t ChunkSize = 16 * 1024;
+
+		// The corners and faces of GeometryCreator::CreateDefaultBox, the corners moved to render space.
+		static const float UnitCorners[NumCorners][3];
+		static const uint16 UnitIndices[NumIndices];
+
+		// One instance per box, in structure buffer order (static meshes then skeletal meshes). Sized once,
+		// the meshes fill their own slots on all the cores.
+		static void BuildInstances(const FSceneDataSet& dataSet, std::vector<FSceneBoxInstance>& instances);
+
+		// Baked geometry (FG_Baked) of count instances, written in place by chunks of ChunkSize boxes on all the cores.
+		// The 8 corners of box i as (x, y, z, 1) at vertices + (8 * i + corner) * vertexStride, followed by the 4 floats
+		// of color when it is not null (ColorVertex). Its 36 indices at indices + 36 * i, starting at 8 * i.
+		static void WriteBakedBoxes(const FSceneBoxInstance* instances, size_t count, uint8* vertices, uint32 vertexStride, uint32* indices,
+			const float* color = nullptr);
+
+		// What BoxInstancedVS computes for a corner.
+		static void GetCorner(const FSceneBoxInstance& instance, uint32 corner, float position[3])
+		{
+			for (int axis = 0; axis < 3; ++axis)
+				position[axis] = instance.Center[axis] + instance.Extent[axis] * UnitCorners[corner][axis];
+		}
+	};
+}
@@ -0,0 +1,214 @@
+//
+// FSceneDataFootprint.cpp
+//
+
+#include "FSceneDataFootprint.h"
+#include <fstream>
+#include <sstream>
+
+using namespace UnrealEngine;
+
+namespace
+{
+	void AddString(const FString& str, FSceneTableFootprint& footprint)
+	{
+		// Small strings live inside the object itself (SSO), only count spilled ones.
+		const char* data = reinterpret_cast<const char*>(str.data());
+		const char* self = reinterpret_cast<const char*>(&str);
+		if (data >= self && data < self + sizeof(FString))
+			return;
+
+		footprint.StringHeapBytes += (str.capacity() + 1) * sizeof(FString::value_type);
+		footprint.NumAllocations++;
+	}
+
+	template<typename T>
+	void AddIndexArray(const TArray<T>& indices, FSceneTableFootprint& footprint)
+	{
+		if (indices.capacity() == 0)
+			return;
+
+		footprint.IndexArrayBytes += indices.capacity() * sizeof(T);
+		footprint.NumAllocations++;
+	}
+
+	void AddIndexArray(const TIndexArray& indices, FSceneTableFootprint& footprint)
+	{
+		// Inline storage is already part of the record.
+		if (indices.IsInline())
+			return;
+
+		footprint.IndexArrayBytes += indices.capacity() * sizeof(int32);
+		footprint.NumAllocations++;
+	}
+
+	template<typename TRecord, typename TLambda>
+	FSceneTableFootprint CalcTable(const char* name, const TArray<TRecord>& table, const TLambda& perRecord)
+	{
+		FSceneTableFootprint footprint;
+		footprint.TableName = name;
+		footprint.NumRecords = table.size();
+		footprint.StructBytes = table.capacity() * sizeof(TRecord);
+		if (table.capacity() > 0)
+			footprint.NumAllocations++;
+
+		for (auto& record : table)
+			perRecord(record, footprint);
+
+		return footprint;
+	}
+
+	void AddTextureStrings(const FSceneTextureDataSet& texture, FSceneTableFootprint& footprint)
+	{
+		AddString(texture.Name, footprint);
+		AddString(texture.AssetPath, footprint);
+		AddString(texture.Type, footprint);
+		AddString(texture.CurrentSize, footprint);
+		AddString(texture.PixelFormat, footprint);
+		AddString(texture.SourceSize, footprint);
+		AddString(texture.SourceFormat, footprint);
+	}
+
+	void WriteTableJson(std::ostringstream& out, const FSceneTableFootprint& footprint, const char* indent)
+	{
+		out << indent << "{ \"Table\": \"" << footprint.TableName << "\""
+			<< ", \"NumRecords\": " << footprint.NumRecords
+			<< ", \"StructBytes\": " << footprint.StructBytes
+			<< ", \"StringHeapBytes\": " << footprint.StringHeapBytes
+			<< ", \"IndexArrayBytes\": " << footprint.IndexArrayBytes
+			<< ", \"NumAllocations\": " << footprint.NumAllocations
+			<< ", \"TotalBytes\": " << footprint.GetTotalBytes() << " }";
+	}
+}
+
+void FSceneTableFootprint::Accumulate(const FSceneTableFootprint& other)
+{
+	NumRecords += other.NumRecords;
+	StructBytes += other.StructBytes;
+	StringHeapBytes += other.StringHeapBytes;
+	IndexArrayBytes += other.IndexArrayBytes;
+	NumAllocations += other.NumAllocations;
+}
+
+FSceneDataFootprint FSceneFootprintUtil::Calculate(const FSceneDataSet& dataSet)
+{
+	FSceneDataFootprint result;
+
+	result.Tables.push_back(CalcTable("StaticMeshesTable", dataSet.StaticMeshesTable,
+		[](const FSceneStaticMeshDataSet& mesh, FSceneTableFootprint& footprint)
+	{
+		AddString(mesh.Name, footprint);
+		AddString(mesh.OwnerName, footprint);
+		AddString(mesh.AssetPath, footprint);
+		AddIndexArray(mesh.BoundsIndices, footprint);
+		AddIndexArray(mesh.TransformsIndices, footprint);
+		AddIndexArray(mesh.UsedMaterialsIndices, footprint);
+		AddIndexArray(mesh.UsedMaterialIntancesIndices, footprint);
+	}));
+
+	result.Tables.push_back(CalcTable("SkeletalMeshesTable", dataSet.SkeletalMeshesTable,
+		[](const FSceneSkeletalMeshDataSet& mesh, FSceneTableFootprint& footprint)
+	{
+		AddString(mesh.Name, footprint);
+		AddString(mesh.OwnerName, footprint);
+		AddString(mesh.AssetPath, footprint);
+		AddIndexArray(mesh.UsedMaterialsIndices, footprint);
+		AddIndexArray(mesh.UsedMaterialIntancesIndices, footprint);
+	}));
+
+	result.Tables.push_back(CalcTable("LandscapesTable", dataSet.LandscapesTable,
+		[](const FSceneLandscapeDataSet&, FSceneTableFootprint&) {}));
+
+	result.Tables.push_back(CalcTable("PrimitiveTransforms", dataSet.PrimitiveTransforms,
+		[](const FMatrix&, FSceneTableFootprint&) {}));
+
+	result.Tables.push_back(CalcTable("BoundsTable", dataSet.BoundsTable,
+		[](const FBoxSphereBounds&, FSceneTableFootprint&) {}));
+
+	result.Tables.push_back(CalcTable("MaterialsTable", dataSet.MaterialsTable,
+		[](const FSceneMaterialDataSet& material, FSceneTableFootprint& footprint)
+	{
+		AddString(material.Name, footprint);
+		AddString(material.AssetPath, footprint);
+		AddString(material.TexSamplers, footprint);
+		AddString(material.UserInterpolators, footprint);
+		AddString(material.TexLookups, footprint);
+		AddString(material.VTLookups, footprint);
+		AddString(material.ShaderErrors, footprint);
+		AddString(material.UniformBufferSummaryString, footprint);
+		AddString(material.MaterialDomain, footprint);
+		AddString(material.BlendMode, footprint);
+		AddString(material.DecalBlendMode, footprint);
+		AddString(material.ShadingModel, footprint);
+		AddString(material.TranslucencyLightingMode, footprint);
+		AddIndexArray(material.MatInsIndices, footprint);
+		AddIndexArray(material.UsedTexturesIndices, footprint);
+	}));
+
+	result.Tables.push_back(CalcTable("MaterialInstancesTable", dataSet.MaterialInstancesTable,
+		[](const FSceneMaterialInstanceDataSet& materialInstance, FSceneTableFootprint& footprint)
+	{
+		AddString(materialInstance.Name, footprint);
+		AddString(materialInstance.AssetPath, footprint);
+		AddString(materialInstance.ParentName, footprint);
+		AddIndexArray(materialInstance.UsedTexturesIndices, footprint);
+	}));
+
+	result.Tables.push_back(CalcTable("TexturesTable", dataSet.TexturesTable, AddTextureStrings));
+	result.Tables.push_back(CalcTable("LightMapsAndShadowMaps", dataSet.LightMapsAndShadowMaps, AddTextureStrings));
+
+	result.Total.TableName = "Total";
+	result.Total.StructBytes = sizeof(FSceneDataSet);
+	for (auto& table : result.Tables)
+		result.Total.Accumulate(table);
+
+	return result;
+}
+
+std::string FSceneFootprintUtil::ToJson(const std::vector<FSceneDataFootprint>& footprints, const RenderFootprint& renderFootprint)
+{
+	std::ostringstream out;
+
+	out << "{\n  \"Scenes\": [\n";
+	for (size_t i = 0; i < footprints.size(); ++i)
+	{
+		out << "    {\n      \"Name\": \"" << footprints[i].Name << "\",\n      \"Tables\": [\n";
+		auto& tables = footprints[i].Tables;
+		for (size_t i = 0; i < tables.size(); ++i)
+		{
+			WriteTableJson(out, tables[i], "        ");
+			out << (i + 1 < tables.size() ? ",\n" : "\n");
+		}
+		out << "      ],\n      \"Total\":\n";
+		WriteTableJson(out, footprints[i].Total, "        ");
+		out << "\n    }" << (i + 1 < footprints.size() ? ",\n" : "\n");
+	}
+	out << "  ],\n";
+
+	out << "  \"Render\": { \"Estimated\": " << (renderFootprint.bEstimated ? "true" : "false")
+		<< ", \"NumRenderItems\": " << renderFootprint.NumRenderItems
+		<< ", \"NumBoxes\": " << renderFootprint.NumBoxes
+		<< ", \"VertexBufferBytes\": " << renderFootprint.VertexBufferBytes
+		<< ", \"IndexBufferBytes\": " << renderFootprint.IndexBufferBytes
+		<< ", \"InstanceBufferBytes\": " << renderFootprint.InstanceBufferBytes
+		<< ", \"UploaderBytes\": " << renderFootprint.UploaderBytes
+		<< ", \"CPUGeometryBytes\": " << renderFootprint.CPUGeometryBytes
+		<< ", \"StructureBufferBytes\": " << renderFootprint.StructureBufferBytes
+		<< ", \"CPUStructureBufferBytes\": " << renderFootprint.CPUStructureBufferBytes
+		<< ", \"TotalBytes\": " << renderFootprint.GetTotalBytes() << " }\n";
+	out << "}\n";
+
+	return out.str();
+}
+
+bool FSceneFootprintUtil::WriteJson(const std::wstring& path, const std::vector<FSceneDataFootprint>& footprints, const RenderFootprint& renderFootprint)
+{
+	std::ofstream fout(path, std::ofstream::out | std::ofstream::trunc);
+	if (!fout.good())
+		return false;
+
+	fout << ToJson(footprints, renderFootprint);
+	fout.close();
+
+	return true;
+}
@@ -0,0 +1,47 @@
+//
+// FSceneDataFootprint.h
+//
+
+#pragma once
+
+#include "../AppData.h"
+#include <string>
+
+namespace UnrealEngine
+{
+	// Memory cost of one FScene table. Heap sizes are derived from the container
+	// capacities, so they reflect what is really resident, not just what is used.
+	struct FSceneTableFootprint
+	{
+		std::string TableName;
+
+		uint64 NumRecords = 0;
+		uint64 StructBytes = 0;		// Table storage (capacity * sizeof(Record)).
+		uint64 StringHeapBytes = 0;	// Strings that spilled out of the small string buffer.
+		uint64 IndexArrayBytes = 0;	// Heap storage of the per record index arrays (inline ones excluded).
+		uint64 NumAllocations = 0;
+
+		uint64 GetTotalBytes() const { return StructBytes + StringHeapBytes + IndexArrayBytes; }
+
+		void Accumulate(const FSceneTableFootprint& other);
+	};
+
+	struct FSceneDataFootprint
+	{
+		std::string Name;			// What was measured, e.g. "Scene0" or "LOD1".
+		std::vector<FSceneTableFootprint> Tables;
+		FSceneTableFootprint Total;
+	};
+
+	class FSceneFootprintUtil
+	{
+	public:
+
+		static FSceneDataFootprint Calculate(const FSceneDataSet& dataSet);
+
+		// Write the named data footprints plus the render side buffers as a JSON document.
+		static std::string ToJson(const std::vector<FSceneDataFootprint>& footprints, const RenderFootprint& renderFootprint);
+
+		static bool WriteJson(const std::wstring& path, const std::vector<FSceneDataFootprint>& footprints, const RenderFootprint& renderFootprint);
+	};
+}
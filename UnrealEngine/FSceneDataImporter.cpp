@@ -5,10 +5,74 @@
 #include "FSceneDataImporter.h"
 #include "../Common/FileManager.h"
 #include "../Common/StringManager.h"
+#include "../Common/ThreadManager.h"
 
 using namespace UnrealEngine;
 using namespace DX::FileManager;
 using namespace DX::StringManager;
+using namespace DX::MemoryManager;
+using namespace DX::ThreadManager;
+
+namespace
+{
+	// One per .csv file, the rows are released with the arena.
+	struct ImportJob
+	{
+		ImportJob() : Table(ArenaAllocator<ImportRow>(&Arena)) {}
+
+		MemoryArena Arena;
+		ImportTable Table;
+		std::wstring TableName;
+	};
+
+	// Split a .csv row, quoted items may contain ','.
+	void TokenizeRow(const std::wstring& _row, ImportTable& table)
+	{
+		ArenaAllocator<ImportString> allocator = table.get_allocator();
+		table.emplace_back(allocator);
+		ImportRow& items = table.back();
+
+		std::wstring::size_type last_found = 0;
+		std::wstring::size_type found = _row.find_first_of(L",\"");
+		while (found != std::wstring::npos)
+		{
+			if (_row[found] == L',')
+			{
+				items.emplace_back(_row.data() + last_found, found - last_found, allocator);
+				last_found = found + 1;
+			}
+			else if (_row[found] == L'"')
+			{
+				// Same as StringUtil::WFindFirstBetween.
+				std::wstring::size_type found1 = _row.find(L'"', last_found);
+				std::wstring::size_type found2 = found1 != std::wstring::npos ? _row.find(L'"', found1 + 1) : std::wstring::npos;
+				if (found2 != std::wstring::npos)
+				{
+					items.emplace_back(_row.data() + found1 + 1, found2 - found1 - 1, allocator);
+					last_found = found2 + 1;
+				}
+				else items.emplace_back(L"404 Not Found.", allocator);
+				last_found++; // skip the next ','.
+			}
+			found = _row.find_first_of(L",\"", last_found);
+		}
+
+		items.emplace_back(_row.data() + last_found, _row.size() - last_found, allocator); // the last item.
+	}
+
+	const ImportTable* FindTable(const std::unordered_map<std::wstring, const ImportTable*>& clear_tables, const std::wstring& name)
+	{
+		static MemoryArena g_empty_arena(64);
+		static const ImportTable g_empty_table{ ArenaAllocator<ImportRow>(&g_empty_arena) };
+		auto it = clear_tables.find(name);
+		return it != clear_tables.end() ? it->second : &g_empty_table;
+	}
+
+	inline FString ToFString(const ImportString& item)
+	{
+		return FString(item.data(), item.size());
+	}
+}
 
 void FSceneDataImporter::FillDataSets(const std::wstring& path)
 {
@@ -62,89 +126,72 @@ void FSceneDataImporter::FillDataSets(const std::wstring& path)
 			max_lod = DirectX::XMMax<int32>(max_lod, StringUtil::WCharToInt32(file[found + postfix.size()]));
 	}
 
-	m_perLODDataSets.resize(max_lod + 1);
+	// Filled here, then frozen into shared snapshots.
+	std::vector<FSceneDataSet> perLODDataSets(max_lod + 1);
 
-	// read in .csv files.
-	std::unordered_map <std::wstring, std::vector<std::wstring>> g_tables;
+	// read in .csv files, one job per file, each with its own arena.
+	std::vector<std::unique_ptr<ImportJob>> jobs;
+	for (size_t i = 0; i < all_possible_files.size(); ++i)
+		jobs.push_back(std::make_unique<ImportJob>());
 
-	for (auto& _file : all_possible_files)
+	ThreadUtil::ParallelFor(all_possible_files.size(), [&](size_t i, uint32)
 	{
+		const std::wstring& _file = all_possible_files[i];
+		ImportJob& job = *jobs[i];
+
 		std::wifstream fin;
 		std::wstring dir = path + L"\\";
-		std::wstring result;
-		std::vector<std::wstring> table;
+		std::wstring line;
+		bool bHeader = true;
 
 		fin.open(dir + _file);
 		if (fin.good())
 		{
 			while (!fin.eof())
 			{
-				std::getline(fin, result);
-				table.push_back(result);
+				std::getline(fin, line);
+				if (bHeader)
+				{
+					bHeader = false;
+					continue;
+				}
+				// extract data to clear structure for use.
+				if (!line.empty())
+					TokenizeRow(line, job.Table);
 			}
 		}
 		fin.close();
-		table.erase(table.begin());
 
 		std::wstring table_name = _file;
-		found = std::wstring::npos;
-		found = table_name.find(file_prefix);
+		std::wstring::size_type found = table_name.find(file_prefix);
 		if (found != std::wstring::npos)
 			table_name.erase(found, file_prefix.size());
-		found = std::wstring::npos;
 		found = table_name.rfind(L".csv");
 		if (found != std::wstring::npos)
 			table_name.erase(found, 4);
-		g_tables[table_name] = table;
-	}
+		job.TableName = table_name;
+	});
 
-	// extract data to clear structure for use.
-	std::unordered_map <std::wstring, std::vector<std::vector<std::wstring>>> g_clear_tables;
+	std::unordered_map<std::wstring, const ImportTable*> g_clear_tables;
+	for (auto& job : jobs)
+		g_clear_tables[job->TableName] = &job->Table;
 
-	for (auto& _table : g_tables)
-	{
-		std::vector<std::vector<std::wstring>> clear_table;
-		for (auto& _row : _table.second)
-		{
-			if (_row.empty())
-				continue;
-			std::vector<std::wstring> items;
-			std::wstring::size_type last_found = 0;
-			found = std::wstring::npos;
-			found = _row.find_first_of(L",\"");
-			while (found != std::wstring::npos)
-			{
-				if (_row.substr(found, 1) == L",")
-				{
-					items.push_back(_row.substr(last_found, found - last_found));
-					last_found = found + 1;
-				}
-				else if (_row.substr(found, 1) == L"\"")
-				{
-					items.push_back(StringUtil::WFindFirstBetween(_row, _row.substr(found, 1), last_found, last_found));
-					last_found++; // skip the next ','.
-				}
-				found = _row.find_first_of(L",\"", last_found);
-			}
-
-			items.push_back(_row.substr(last_found, _row.size() - last_found)); // the last item.
-
-			clear_table.push_back(items);
-		}
+	// fill data sets.
+	_FillDataSets(g_clear_tables, perLODDataSets);
 
-		g_clear_tables[_table.first] = clear_table;
-	}
+	for (auto& dataSet : perLODDataSets)
+		m_perLODDataSets.push_back(std::make_shared<const FSceneDataSet>(std::move(dataSet)));
 
-	// fill data sets.
-	_FillDataSets(g_clear_tables);
+	// All the transient tokens go away with the job arenas here, in one shot per file.
 }
 
-#define safe_index(row, index) row[index++];if (index >= row.size()) break;
-#define numeric_safe_index(row, index, type) StringUtil::WStringToNumeric<type>(row[index++]);if (index >= row.size()) break;
-#define array_safe_index(row, index, type, separator) StringUtil::WStringToArray<type>(row[index++],separator);if (index >= row.size()) break;
-#define array_first_safe_index(row, index, type, separator) StringUtil::WStringToArray<type>(row[index++],separator).front();if (index >= row.size()) break;
+#define safe_index(row, index) ToFString(row[index++]);if (index >= row.size()) break;
+#define numeric_safe_index(row, index, type) StringUtil::WStringToNumeric<type>(ToFString(row[index++]));if (index >= row.size()) break;
+#define array_safe_index(row, index, type, separator) StringUtil::WStringToArray<type>(ToFString(row[index++]),separator);if (index >= row.size()) break;
+#define index_array_safe_index(row, index, out, separator) StringUtil::WStringToArray<int32>(row[index++],separator,out);if (index >= row.size()) break;
+#define array_first_safe_index(row, index, type, separator) StringUtil::WStringToArray<type>(ToFString(row[index++]),separator).front();if (index >= row.size()) break;
 
-void FSceneDataImporter::_FillDataSets(std::unordered_map <std::wstring, std::vector<std::vector<std::wstring>>>& clear_tables)
+void FSceneDataImporter::_FillDataSets(const std::unordered_map<std::wstring, const ImportTable*>& clear_tables, std::vector<FSceneDataSet>& perLODDataSets)
 {
 	FSceneStaticMeshDataSet			StaticMeshDataSet;
 	FSceneSkeletalMeshDataSet		SkeletalMeshDataSet;
@@ -156,14 +203,14 @@ void FSceneDataImporter::_FillDataSets(std::unordered_map <std::wstring, std::ve
 	FSceneTextureDataSet			TexturesDataSet;
 	FSceneTextureDataSet			LightMapsAndShadowMaps;
 
-	std::vector<std::vector<std::wstring>> table;
+	const ImportTable* table = nullptr;
 
-	for (int i = 0; i < m_perLODDataSets.size(); ++i)
+	for (int i = 0; i < perLODDataSets.size(); ++i)
 	{
-		table = clear_tables[L"StaticMeshesTable_LOD" + std::to_wstring(i)];
-		if (!table.empty())
+		table = FindTable(clear_tables, L"StaticMeshesTable_LOD" + std::to_wstring(i));
+		if (!table->empty())
 		{
-			for (auto& row : table)
+			for (auto& row : *table)
 			{
 				while (true) // This 'while' will be 'break' automatically.
 				{
@@ -177,21 +224,20 @@ void FSceneDataImporter::_FillDataSets(std::unordered_map <std::wstring, std::ve
 					StaticMeshDataSet.CurrentLOD = numeric_safe_index(row, index, uint16);
 					StaticMeshDataSet.AssetPath = safe_index(row, index);
 					StaticMeshDataSet.UniqueId = numeric_safe_index(row, index, uint32);
-					StaticMeshDataSet.BoundsIndices = array_safe_index(row, index, int32, L'\\');
-					StaticMeshDataSet.TransformsIndices = array_safe_index(row, index, int32, L'\\');
-					StaticMeshDataSet.UsedMaterialsIndices = array_safe_index(row, index, int32, L'\\');
-					StaticMeshDataSet.UsedMaterialIntancesIndices = array_safe_index(row, index, int32, L'\\');
+					index_array_safe_index(row, index, StaticMeshDataSet.BoundsIndices, L'\\');
+					index_array_safe_index(row, index, StaticMeshDataSet.TransformsIndices, L'\\');
+					index_array_safe_index(row, index, StaticMeshDataSet.UsedMaterialsIndices, L'\\');
+					index_array_safe_index(row, index, StaticMeshDataSet.UsedMaterialIntancesIndices, L'\\');
 				}
 
-				m_perLODDataSets[i].StaticMeshesTable.push_back(StaticMeshDataSet);
+				perLODDataSets[i].StaticMeshesTable.push_back(StaticMeshDataSet);
 			}
 		}
 
-		table.clear();
-		table = clear_tables[L"SkeletalMeshesTable_LOD" + std::to_wstring(i)];
-		if (!table.empty())
+		table = FindTable(clear_tables, L"SkeletalMeshesTable_LOD" + std::to_wstring(i));
+		if (!table->empty())
 		{
-			for (auto& row : table)
+			for (auto& row : *table)
 			{
 				while (true) // This 'while' will be 'break' automatically.
 				{
@@ -207,19 +253,18 @@ void FSceneDataImporter::_FillDataSets(std::unordered_map <std::wstring, std::ve
 					SkeletalMeshDataSet.UniqueId = numeric_safe_index(row, index, uint32);
 					SkeletalMeshDataSet.BoundsIndex = array_first_safe_index(row, index, int32, L'\\');
 					SkeletalMeshDataSet.TransformsIndex = array_first_safe_index(row, index, int32, L'\\');
-					SkeletalMeshDataSet.UsedMaterialsIndices = array_safe_index(row, index, int32, L'\\');
-					SkeletalMeshDataSet.UsedMaterialIntancesIndices = array_safe_index(row, index, int32, L'\\');
+					index_array_safe_index(row, index, SkeletalMeshDataSet.UsedMaterialsIndices, L'\\');
+					index_array_safe_index(row, index, SkeletalMeshDataSet.UsedMaterialIntancesIndices, L'\\');
 				}
 
-				m_perLODDataSets[i].SkeletalMeshesTable.push_back(SkeletalMeshDataSet);
+				perLODDataSets[i].SkeletalMeshesTable.push_back(SkeletalMeshDataSet);
 			}
 		}
 
-		table.clear();
-		table = clear_tables[L"PrimitiveTransforms_LOD" + std::to_wstring(i)];
-		if (!table.empty())
+		table = FindTable(clear_tables, L"PrimitiveTransforms_LOD" + std::to_wstring(i));
+		if (!table->empty())
 		{
-			for (auto& row : table)
+			for (auto& row : *table)
 			{
 				while (true) // This 'while' will be 'break' automatically.
 				{
@@ -252,15 +297,14 @@ void FSceneDataImporter::_FillDataSets(std::unordered_map <std::wstring, std::ve
 						Vector4(m_30, m_31, m_32, m_33));
 				}
 
-				m_perLODDataSets[i].PrimitiveTransforms.push_back(PrimitiveTransform);
+				perLODDataSets[i].PrimitiveTransforms.push_back(PrimitiveTransform);
 			}
 		}
 
-		table.clear();
-		table = clear_tables[L"BoundsTable_LOD" + std::to_wstring(i)];
-		if (!table.empty())
+		table = FindTable(clear_tables, L"BoundsTable_LOD" + std::to_wstring(i));
+		if (!table->empty())
 		{
-			for (auto& row : table)
+			for (auto& row : *table)
 			{
 				while (true) // This 'while' will be 'break' automatically.
 				{
@@ -282,15 +326,14 @@ void FSceneDataImporter::_FillDataSets(std::unordered_map <std::wstring, std::ve
 				Bounds.SphereBounds.Center = Bounds.Origin;
 				Bounds.SphereBounds.Radius = Bounds.SphereRadius;
 
-				m_perLODDataSets[i].BoundsTable.push_back(Bounds);
+				perLODDataSets[i].BoundsTable.push_back(Bounds);
 			}
 		}
 
-		table.clear();
-		table = clear_tables[L"MaterialsTable_LOD" + std::to_wstring(i)];
-		if (!table.empty())
+		table = FindTable(clear_tables, L"MaterialsTable_LOD" + std::to_wstring(i));
+		if (!table->empty())
 		{
-			for (auto& row : table)
+			for (auto& row : *table)
 			{
 				while (true) // This 'while' will be 'break' automatically.
 				{
@@ -338,19 +381,18 @@ void FSceneDataImporter::_FillDataSets(std::unordered_map <std::wstring, std::ve
 					MaterialsDataSet.bUsePlanarForwardReflections = (uint8)numeric_safe_index(row, index, uint16);
 					MaterialsDataSet.AssetPath = safe_index(row, index);
 					MaterialsDataSet.UniqueId = numeric_safe_index(row, index, uint32);
-					MaterialsDataSet.UsedTexturesIndices = array_safe_index(row, index, int32, L'\\');
-					MaterialsDataSet.MatInsIndices = array_safe_index(row, index, int32, L'\\');
+					index_array_safe_index(row, index, MaterialsDataSet.UsedTexturesIndices, L'\\');
+					index_array_safe_index(row, index, MaterialsDataSet.MatInsIndices, L'\\');
 				}
 
-				m_perLODDataSets[i].MaterialsTable.push_back(MaterialsDataSet);
+				perLODDataSets[i].MaterialsTable.push_back(MaterialsDataSet);
 			}
 		}
 
-		table.clear();
-		table = clear_tables[L"MaterialInstancesTable_LOD" + std::to_wstring(i)];
-		if (!table.empty())
+		table = FindTable(clear_tables, L"MaterialInstancesTable_LOD" + std::to_wstring(i));
+		if (!table->empty())
 		{
-			for (auto& row : table)
+			for (auto& row : *table)
 			{
 				while (true) // This 'while' will be 'break' automatically.
 				{
@@ -361,18 +403,17 @@ void FSceneDataImporter::_FillDataSets(std::unordered_map <std::wstring, std::ve
 					MaterialInstancesDataSet.ParentIndex = numeric_safe_index(row, index, int32);
 					MaterialInstancesDataSet.AssetPath = safe_index(row, index);
 					MaterialInstancesDataSet.UniqueId = numeric_safe_index(row, index, uint32);
-					MaterialInstancesDataSet.UsedTexturesIndices = array_safe_index(row, index, int32, L'\\');
+					index_array_safe_index(row, index, MaterialInstancesDataSet.UsedTexturesIndices, L'\\');
 				}
 
-				m_perLODDataSets[i].MaterialInstancesTable.push_back(MaterialInstancesDataSet);
+				perLODDataSets[i].MaterialInstancesTable.push_back(MaterialInstancesDataSet);
 			}
 		}
 
-		table.clear();
-		table = clear_tables[L"TexturesTable_LOD" + std::to_wstring(i)];
-		if (!table.empty())
+		table = FindTable(clear_tables, L"TexturesTable_LOD" + std::to_wstring(i));
+		if (!table->empty())
 		{
-			for (auto& row : table)
+			for (auto& row : *table)
 			{
 				while (true) // This 'while' will be 'break' automatically.
 				{
@@ -406,16 +447,15 @@ void FSceneDataImporter::_FillDataSets(std::unordered_map <std::wstring, std::ve
 					TexturesDataSet.UniqueId = numeric_safe_index(row, index, uint32);
 				}
 
-				m_perLODDataSets[i].TexturesTable.push_back(TexturesDataSet);
+				perLODDataSets[i].TexturesTable.push_back(TexturesDataSet);
 			}
 		}
 
-		table.clear();
-		table = clear_tables[L"LightMapsAndShadowMaps"];
-		if (!table.empty())
+		table = FindTable(clear_tables, L"LightMapsAndShadowMaps");
+		if (!table->empty())
 		{
 			if (i > 0) continue;
-			for (auto& row : table)
+			for (auto& row : *table)
 			{
 				while (true) // This 'while' will be 'break' automatically.
 				{
@@ -449,7 +489,7 @@ void FSceneDataImporter::_FillDataSets(std::unordered_map <std::wstring, std::ve
 					LightMapsAndShadowMaps.UniqueId = numeric_safe_index(row, index, uint32);
 				}
 
-				m_perLODDataSets[i].LightMapsAndShadowMaps.push_back(LightMapsAndShadowMaps);
+				perLODDataSets[i].LightMapsAndShadowMaps.push_back(LightMapsAndShadowMaps);
 			}
 		}
 	}
@@ -458,6 +498,38 @@ void FSceneDataImporter::_FillDataSets(std::unordered_map <std::wstring, std::ve
 const FSceneDataSet* FSceneDataImporter::GetFSceneData(int lod) const
 {
 	if (lod < m_perLODDataSets.size())
-		return &m_perLODDataSets[lod];
+		return m_perLODDataSets[lod].get();
 	else return nullptr;
 }
+
+FSceneDataSetPtr FSceneDataImporter::GetFSceneDataPtr(int lod) const
+{
+	if (lod < m_perLODDataSets.size())
+		return m_perLODDataSets[lod];
+	else return nullptr;
+}
+
+std::vector<FSceneDataSetPtr> FSceneDataImporter::Reset()
+{
+	std::vector<FSceneDataSetPtr> dataSets;
+	dataSets.swap(m_perLODDataSets);
+	return dataSets;
+}
+
+FSceneDataFootprint FSceneDataImporter::GetFootprint(int lod) const
+{
+	if (lod >= m_perLODDataSets.size())
+		return FSceneDataFootprint();
+
+	FSceneDataFootprint footprint = FSceneFootprintUtil::Calculate(*m_perLODDataSets[lod]);
+	footprint.Name = "LOD" + std::to_string(lod);
+	return footprint;
+}
+
+std::vector<FSceneDataFootprint> FSceneDataImporter::GetAllFootprints() const
+{
+	std::vector<FSceneDataFootprint> footprints;
+	for (int lod = 0; lod < GetLODCount(); ++lod)
+		footprints.push_back(GetFootprint(lod));
+	return footprints;
+}
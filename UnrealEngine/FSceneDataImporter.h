@@ -5,9 +5,16 @@
 #pragma once
 
 #include "../AppData.h"
+#include "FSceneDataFootprint.h"
+#include "../Common/MemoryManager.h"
 
 namespace UnrealEngine
 {
+	// Transient .csv tokens, they live in the arena of the import job that parsed them.
+	using ImportString = std::basic_string<wchar_t, std::char_traits<wchar_t>, DX::MemoryManager::ArenaAllocator<wchar_t>>;
+	using ImportRow = std::vector<ImportString, DX::MemoryManager::ArenaAllocator<ImportString>>;
+	using ImportTable = std::vector<ImportRow, DX::MemoryManager::ArenaAllocator<ImportRow>>;
+
 	class FSceneDataImporter
 	{
 	public:
@@ -18,17 +25,27 @@ namespace UnrealEngine
 
 		const FSceneDataSet* GetFSceneData(int lod) const;
 
+		// Shared snapshot, hand this to consumers instead of copying the scene.
+		FSceneDataSetPtr GetFSceneDataPtr(int lod) const;
+
 		int GetLODCount() const { return (int)m_perLODDataSets.size(); }
 
+		// Drops the last import, the caller decides where the snapshots are freed.
+		std::vector<FSceneDataSetPtr> Reset();
+
+		// Memory cost of the last import only, per LOD. AppEntry reports all the loaded scenes.
+		FSceneDataFootprint GetFootprint(int lod) const;
+		std::vector<FSceneDataFootprint> GetAllFootprints() const;
+
 		bool GetDataDirtyFlag() const { return bFSceneDataDirtyFlag; }
 
 		void SetDataDirtyFlag(bool flag) { bFSceneDataDirtyFlag = flag; }
 
 	private:
 
-		void _FillDataSets(std::unordered_map <std::wstring, std::vector<std::vector<std::wstring>>>& clear_tables);
+		void _FillDataSets(const std::unordered_map<std::wstring, const ImportTable*>& clear_tables, std::vector<FSceneDataSet>& perLODDataSets);
 
-		std::vector<FSceneDataSet> m_perLODDataSets;
+		std::vector<FSceneDataSetPtr> m_perLODDataSets;
 
 		bool bFSceneDataDirtyFlag = false;
 	};
@@ -0,0 +1,585 @@
+//
+// FSceneExpression.cpp
+//
+
+#include "FSceneExpression.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+using namespace UnrealEngine;
+
+namespace
+{
+	struct MeshField
+	{
+		const char* Name;
+		TArray<float> FSceneAttributeContext::* Column; // nullptr for NumTextures.
+	};
+
+	const MeshField g_meshFields[] =
+	{
+		{ "NumVertices", &FSceneAttributeContext::NumVertices },
+		{ "NumTriangles", &FSceneAttributeContext::NumTriangles },
+		{ "NumInstances", &FSceneAttributeContext::MeshNumInstances },
+		{ "NumLODs", &FSceneAttributeContext::NumLODs },
+		{ "NumMaterials", &FSceneAttributeContext::NumMaterials },
+		{ "NumTextures", nullptr }
+	};
+
+	int32 FindMeshField(const std::string& name)
+	{
+		for (int32 i = 0; i < (int32)(sizeof(g_meshFields) / sizeof(g_meshFields[0])); ++i)
+		{
+			if (name == g_meshFields[i].Name)
+				return i;
+		}
+		return -1;
+	}
+
+	// Fields registered after the context was built have no column, they read as 0.
+	void LoadColumn(const std::vector<TArray<float>>& columns, int32 index, uint32 first, uint32 count, float* out)
+	{
+		if (index < (int32)columns.size() && first + count <= columns[index].size())
+			std::copy(columns[index].begin() + first, columns[index].begin() + first + count, out);
+		else std::fill(out, out + count, 0.0f);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Compiler, recursive descent straight to the bytecode.
+
+class FSceneExpression::Compiler
+{
+public:
+
+	Compiler(const std::string& source, const FSceneAttributeEngine& engine, FSceneExpression& expression)
+		: m_source(source), m_engine(engine), m_expression(expression) {}
+
+	bool Compile(std::string& error)
+	{
+		if (Tokenize())
+		{
+			Scope scope = { &m_expression.m_program, Domain_Mesh, true, 0 };
+			m_scope = scope;
+			if (ParseComparison() && Peek().Type != Token_End)
+				Fail("Unexpected '" + Peek().Text + "'");
+		}
+
+		error = m_error;
+		return m_error.empty();
+	}
+
+private:
+
+	enum ETokenType
+	{
+		Token_End,
+		Token_Number,
+		Token_Identifier,
+		Token_Symbol
+	};
+
+	struct Token
+	{
+		ETokenType Type;
+		std::string Text;
+		float Value;
+		size_t Position;
+	};
+
+	// Program being emitted, aggregates open a new one.
+	struct Scope
+	{
+		Program* Target;
+		EDomain Domain;
+		bool bDomainKnown;
+		int32 Depth;
+	};
+
+	bool Tokenize()
+	{
+		size_t i = 0;
+		while (i < m_source.size())
+		{
+			char c = m_source[i];
+			if (std::isspace((unsigned char)c))
+			{
+				++i;
+				continue;
+			}
+
+			Token token = { Token_Symbol, "", 0.0f, i };
+			if (std::isdigit((unsigned char)c) || (c == '.' && i + 1 < m_source.size() && std::isdigit((unsigned char)m_source[i + 1])))
+			{
+				char* end = nullptr;
+				token.Type = Token_Number;
+				token.Value = std::strtof(m_source.c_str() + i, &end);
+				size_t length = end - (m_source.c_str() + i);
+				token.Text = m_source.substr(i, length);
+				i += length;
+			}
+			else if (std::isalpha((unsigned char)c) || c == '_')
+			{
+				size_t start = i;
+				while (i < m_source.size() && (std::isalnum((unsigned char)m_source[i]) || m_source[i] == '_'))
+					++i;
+				token.Type = Token_Identifier;
+				token.Text = m_source.substr(start, i - start);
+			}
+			else
+			{
+				static const char* twoChars[] = { "<=", ">=", "==", "!=" };
+				for (const char* symbol : twoChars)
+				{
+					if (m_source.compare(i, 2, symbol) == 0)
+						token.Text = symbol;
+				}
+				if (token.Text.empty())
+				{
+					if (std::string("+-*/()<>,.").find(c) == std::string::npos)
+						return Fail(std::string("Unknown character '") + c + "'", i);
+					token.Text = c;
+				}
+				i += token.Text.size();
+			}
+			m_tokens.push_back(token);
+		}
+
+		Token end = { Token_End, "end of expression", 0.0f, m_source.size() };
+		m_tokens.push_back(end);
+		return true;
+	}
+
+	const Token& Peek(size_t offset = 0) const { return m_tokens[(std::min)(m_current + offset, m_tokens.size() - 1)]; }
+	bool IsSymbol(const char* symbol, size_t offset = 0) const { return Peek(offset).Type == Token_Symbol && Peek(offset).Text == symbol; }
+
+	bool Accept(const char* symbol)
+	{
+		if (!IsSymbol(symbol))
+			return false;
+		m_current++;
+		return true;
+	}
+
+	bool Expect(const char* symbol)
+	{
+		if (Accept(symbol))
+			return true;
+		return Fail(std::string("Expected '") + symbol + "' but found '" + Peek().Text + "'");
+	}
+
+	bool Fail(const std::string& message) { return Fail(message, Peek().Position); }
+	bool Fail(const std::string& message, size_t position)
+	{
+		if (m_error.empty())
+			m_error = message + " (at " + std::to_string(position + 1) + ")";
+		return false;
+	}
+
+	void Emit(EOp op, int32 index = 0, float value = 0.0f)
+	{
+		if (op <= Op_Aggregate)
+			m_scope.Depth++;
+		else if (op >= Op_Add)
+			m_scope.Depth--;
+
+		Instruction instruction = { op, index, value };
+		m_scope.Target->Code.push_back(instruction);
+		m_scope.Target->MaxDepth = (std::max)(m_scope.Target->MaxDepth, m_scope.Depth);
+	}
+
+	bool ParseComparison()
+	{
+		if (!ParseAdditive())
+			return false;
+
+		static const struct { const char* Symbol; EOp Op; } comparisons[] =
+		{
+			{ "<", Op_Less }, { ">", Op_Greater }, { "<=", Op_LessEqual }, { ">=", Op_GreaterEqual }, { "==", Op_Equal }, { "!=", Op_NotEqual }
+		};
+		for (auto& comparison : comparisons)
+		{
+			if (Accept(comparison.Symbol))
+			{
+				if (!ParseAdditive())
+					return false;
+				Emit(comparison.Op);
+				break;
+			}
+		}
+		return true;
+	}
+
+	bool ParseAdditive()
+	{
+		if (!ParseMultiplicative())
+			return false;
+
+		while (IsSymbol("+") || IsSymbol("-"))
+		{
+			EOp op = Peek().Text == "+" ? Op_Add : Op_Sub;
+			m_current++;
+			if (!ParseMultiplicative())
+				return false;
+			Emit(op);
+		}
+		return true;
+	}
+
+	bool ParseMultiplicative()
+	{
+		if (!ParseUnary())
+			return false;
+
+		while (IsSymbol("*") || IsSymbol("/"))
+		{
+			EOp op = Peek().Text == "*" ? Op_Mul : Op_Div;
+			m_current++;
+			if (!ParseUnary())
+				return false;
+			Emit(op);
+		}
+		return true;
+	}
+
+	bool ParseUnary()
+	{
+		if (Accept("-"))
+		{
+			if (!ParseUnary())
+				return false;
+			Emit(Op_Neg);
+			return true;
+		}
+		return ParsePrimary();
+	}
+
+	bool ParsePrimary()
+	{
+		const Token& token = Peek();
+
+		if (token.Type == Token_Number)
+		{
+			m_current++;
+			Emit(Op_Constant, 0, token.Value);
+			return true;
+		}
+
+		if (Accept("("))
+			return ParseComparison() && Expect(")");
+
+		if (token.Type != Token_Identifier)
+			return Fail("Unexpected '" + token.Text + "'");
+
+		if (IsSymbol("(", 1))
+			return ParseCall();
+		return ParseField();
+	}
+
+	bool ParseField()
+	{
+		std::string scope;
+		std::string name = Peek().Text;
+		size_t position = Peek().Position;
+		m_current++;
+		if (Accept("."))
+		{
+			if (Peek().Type != Token_Identifier)
+				return Fail("Expected a field name after '" + name + ".'");
+			scope = name;
+			name = Peek().Text;
+			m_current++;
+		}
+
+		if (scope.empty() || scope == "Mesh")
+		{
+			int32 field = FindMeshField(name);
+			if (field < 0 && scope.empty() && m_engine.FindMaterialField(name) >= 0)
+				return Fail("'" + name + "' is a material field, e.g. sum(Material." + name + ")", position);
+			if (field < 0 && scope.empty() && m_engine.FindTextureField(name) >= 0)
+				return Fail("'" + name + "' is a texture field, e.g. sum(Texture." + name + ")", position);
+			if (field < 0)
+				return Fail("Unknown mesh field '" + name + "'", position);
+			if (m_scope.Domain != Domain_Mesh)
+				return Fail("Mesh field '" + name + "' inside an aggregate", position);
+			Emit(Op_MeshField, field);
+			return true;
+		}
+
+		EDomain domain;
+		int32 field;
+		if (scope == "Material")
+		{
+			domain = Domain_Material;
+			field = m_engine.FindMaterialField(name);
+		}
+		else if (scope == "Texture")
+		{
+			domain = Domain_Texture;
+			field = m_engine.FindTextureField(name);
+		}
+		else return Fail("Unknown scope '" + scope + "', use Mesh, Material or Texture", position);
+
+		if (field < 0)
+			return Fail("Unknown field '" + scope + "." + name + "'", position);
+		if (m_scope.Domain == Domain_Mesh)
+			return Fail("'" + scope + "." + name + "' must be aggregated, e.g. sum(" + scope + "." + name + ")", position);
+		if (m_scope.bDomainKnown && m_scope.Domain != domain)
+			return Fail("Material and Texture fields mixed in one aggregate", position);
+
+		m_scope.Domain = domain;
+		m_scope.bDomainKnown = true;
+		Emit(domain == Domain_Material ? Op_MaterialField : Op_TextureField, field);
+		return true;
+	}
+
+	bool ParseCall()
+	{
+		std::string name = Peek().Text;
+		size_t position = Peek().Position;
+		m_current += 2;
+
+		// min / max take two values, or one to aggregate.
+		bool bTwoArguments = HasTopLevelComma();
+		if (name == "min" || name == "max")
+		{
+			if (bTwoArguments)
+			{
+				if (!ParseComparison() || !Expect(",") || !ParseComparison() || !Expect(")"))
+					return false;
+				Emit(name == "min" ? Op_Min : Op_Max);
+				return true;
+			}
+			return ParseAggregate(name == "min" ? Aggregate_Min : Aggregate_Max, position);
+		}
+		if (bTwoArguments)
+			return Fail("'" + name + "' takes one argument", position);
+
+		if (name == "sum")
+			return ParseAggregate(Aggregate_Sum, position);
+		if (name == "avg")
+			return ParseAggregate(Aggregate_Avg, position);
+		if (name == "count")
+			return ParseAggregate(Aggregate_Count, position);
+
+		EOp op;
+		if (name == "abs")
+			op = Op_Abs;
+		else if (name == "sqrt")
+			op = Op_Sqrt;
+		else if (name == "log")
+			op = Op_Log;
+		else return Fail("Unknown function '" + name + "'", position);
+
+		if (!ParseComparison() || !Expect(")"))
+			return false;
+		Emit(op);
+		return true;
+	}
+
+	bool ParseAggregate(EAggregate type, size_t position)
+	{
+		if (m_scope.Domain != Domain_Mesh)
+			return Fail("Nested aggregates are not supported", position);
+
+		Aggregate aggregate;
+		aggregate.Type = type;
+		aggregate.Domain = Domain_Material;
+
+		// Any domain but Domain_Mesh marks an aggregate body, the first field tells which one.
+		Scope outer = m_scope;
+		Scope inner = { &aggregate.Body, Domain_Material, false, 0 };
+		m_scope = inner;
+		bool bParsed = ParseComparison();
+		bool bDomainKnown = m_scope.bDomainKnown;
+		aggregate.Domain = m_scope.Domain;
+		m_scope = outer;
+
+		if (!bParsed || !Expect(")"))
+			return false;
+		if (!bDomainKnown)
+			return Fail("Aggregate without any Material. or Texture. field", position);
+
+		m_expression.m_aggregates.push_back(std::move(aggregate));
+		Emit(Op_Aggregate, (int32)m_expression.m_aggregates.size() - 1);
+		return true;
+	}
+
+	bool HasTopLevelComma() const
+	{
+		int32 level = 0;
+		for (size_t i = m_current; i < m_tokens.size(); ++i)
+		{
+			const Token& token = m_tokens[i];
+			if (token.Type != Token_Symbol)
+				continue;
+			if (token.Text == "(")
+				level++;
+			else if (token.Text == ")" && level-- == 0)
+				return false;
+			else if (token.Text == "," && level == 0)
+				return true;
+		}
+		return false;
+	}
+
+	const std::string& m_source;
+	const FSceneAttributeEngine& m_engine;
+	FSceneExpression& m_expression;
+
+	std::vector<Token> m_tokens;
+	size_t m_current = 0;
+	Scope m_scope;
+	std::string m_error;
+};
+
+//////////////////////////////////////////////////////////////////////////
+// FSceneExpression.
+
+bool FSceneExpression::Compile(const std::string& source, const FSceneAttributeEngine& engine, std::string& error)
+{
+	m_source = source;
+	m_program = Program();
+	m_aggregates.clear();
+
+	Compiler compiler(m_source, engine, *this);
+	if (!compiler.Compile(error))
+		return false;
+
+	m_maxDepth = m_program.MaxDepth;
+	for (auto& aggregate : m_aggregates)
+		m_maxDepth = (std::max)(m_maxDepth, aggregate.Body.MaxDepth);
+	return true;
+}
+
+void FSceneExpression::Evaluate(const FSceneAttributeContext& context, uint32 begin, uint32 end, float* out) const
+{
+	// One more slot than needed, the first one is never read.
+	const uint32 batchSize = BatchSize;
+	std::vector<float> stack((m_maxDepth + 1) * batchSize);
+
+	// Scenes hold far fewer materials and textures than meshes, every chunk computes
+	// the aggregate bodies over all of them instead of sharing them between chunks.
+	std::vector<TArray<float>> aggregateValues(m_aggregates.size());
+	for (size_t a = 0; a < m_aggregates.size(); ++a)
+	{
+		const Aggregate& aggregate = m_aggregates[a];
+		uint32 count = aggregate.Domain == Domain_Material ? context.NumSceneMaterials : context.NumSceneTextures;
+		aggregateValues[a].resize(count);
+		for (uint32 first = 0; first < count; first += batchSize)
+		{
+			uint32 batch = (std::min)(count - first, batchSize);
+			const float* result = Run(aggregate.Body, context, first, batch, aggregateValues, stack.data());
+			std::copy(result, result + batch, aggregateValues[a].data() + first);
+		}
+	}
+
+	for (uint32 first = begin; first < end; first += batchSize)
+	{
+		uint32 batch = (std::min)(end - first, batchSize);
+		const float* result = Run(m_program, context, first, batch, aggregateValues, stack.data());
+		std::copy(result, result + batch, out + first);
+	}
+}
+
+const float* FSceneExpression::Run(const Program& program, const FSceneAttributeContext& context, uint32 first, uint32 count,
+	const std::vector<TArray<float>>& aggregateValues, float* stack) const
+{
+	// top is the slot of the value on top of the stack, binary ops write into the one below.
+	float* top = stack;
+	for (const Instruction& instruction : program.Code)
+	{
+		float* a = top - BatchSize;
+		switch (instruction.Op)
+		{
+		case Op_Constant:
+			top += BatchSize;
+			std::fill(top, top + count, instruction.Value);
+			break;
+		case Op_MeshField:
+		{
+			top += BatchSize;
+			const MeshField& field = g_meshFields[instruction.Index];
+			if (field.Column != nullptr)
+				std::copy((context.*field.Column).begin() + first, (context.*field.Column).begin() + first + count, top);
+			else
+			{
+				const int32* offsets = context.TextureOffsets.data() + first;
+				for (uint32 i = 0; i < count; ++i)
+					top[i] = (float)(offsets[i + 1] - offsets[i]);
+			}
+			break;
+		}
+		case Op_MaterialField:
+			top += BatchSize;
+			LoadColumn(context.MaterialColumns, instruction.Index, first, count, top);
+			break;
+		case Op_TextureField:
+			top += BatchSize;
+			LoadColumn(context.TextureColumns, instruction.Index, first, count, top);
+			break;
+		case Op_Aggregate:
+			top += BatchSize;
+			Reduce(m_aggregates[instruction.Index], context, first, count, aggregateValues[instruction.Index], top);
+			break;
+
+		case Op_Neg: for (uint32 i = 0; i < count; ++i) top[i] = -top[i]; break;
+		case Op_Abs: for (uint32 i = 0; i < count; ++i) top[i] = std::abs(top[i]); break;
+		case Op_Sqrt: for (uint32 i = 0; i < count; ++i) top[i] = top[i] > 0.0f ? std::sqrt(top[i]) : 0.0f; break;
+		case Op_Log: for (uint32 i = 0; i < count; ++i) top[i] = top[i] > 0.0f ? std::log(top[i]) : 0.0f; break;
+
+		case Op_Add: for (uint32 i = 0; i < count; ++i) a[i] += top[i]; top = a; break;
+		case Op_Sub: for (uint32 i = 0; i < count; ++i) a[i] -= top[i]; top = a; break;
+		case Op_Mul: for (uint32 i = 0; i < count; ++i) a[i] *= top[i]; top = a; break;
+		case Op_Div: for (uint32 i = 0; i < count; ++i) a[i] = top[i] != 0.0f ? a[i] / top[i] : 0.0f; top = a; break;
+		case Op_Min: for (uint32 i = 0; i < count; ++i) a[i] = (std::min)(a[i], top[i]); top = a; break;
+		case Op_Max: for (uint32 i = 0; i < count; ++i) a[i] = (std::max)(a[i], top[i]); top = a; break;
+		case Op_Less: for (uint32 i = 0; i < count; ++i) a[i] = a[i] < top[i] ? 1.0f : 0.0f; top = a; break;
+		case Op_Greater: for (uint32 i = 0; i < count; ++i) a[i] = a[i] > top[i] ? 1.0f : 0.0f; top = a; break;
+		case Op_LessEqual: for (uint32 i = 0; i < count; ++i) a[i] = a[i] <= top[i] ? 1.0f : 0.0f; top = a; break;
+		case Op_GreaterEqual: for (uint32 i = 0; i < count; ++i) a[i] = a[i] >= top[i] ? 1.0f : 0.0f; top = a; break;
+		case Op_Equal: for (uint32 i = 0; i < count; ++i) a[i] = a[i] == top[i] ? 1.0f : 0.0f; top = a; break;
+		case Op_NotEqual: for (uint32 i = 0; i < count; ++i) a[i] = a[i] != top[i] ? 1.0f : 0.0f; top = a; break;
+		}
+	}
+	return top;
+}
+
+void FSceneExpression::Reduce(const Aggregate& aggregate, const FSceneAttributeContext& context, uint32 first, uint32 count,
+	const TArray<float>& values, float* out) const
+{
+	const bool bMaterials = aggregate.Domain == Domain_Material;
+	const int32* offsets = (bMaterials ? context.MaterialOffsets : context.TextureOffsets).data() + first;
+	const int32* elements = (bMaterials ? context.Materials : context.Textures).data();
+
+	for (uint32 i = 0; i < count; ++i)
+	{
+		int32 k = offsets[i];
+		int32 end = offsets[i + 1];
+		float result = 0.0f;
+		switch (aggregate.Type)
+		{
+		case Aggregate_Sum:
+		case Aggregate_Avg:
+			for (; k < end; ++k)
+				result += values[elements[k]];
+			if (aggregate.Type == Aggregate_Avg && end > offsets[i])
+				result /= (float)(end - offsets[i]);
+			break;
+		case Aggregate_Min:
+		case Aggregate_Max:
+			// Meshes without materials / textures give 0.
+			if (k < end)
+				result = values[elements[k++]];
+			for (; k < end; ++k)
+				result = aggregate.Type == Aggregate_Min ? (std::min)(result, values[elements[k]]) : (std::max)(result, values[elements[k]]);
+			break;
+		case Aggregate_Count:
+			for (; k < end; ++k)
+				result += values[elements[k]] != 0.0f ? 1.0f : 0.0f;
+			break;
+		}
+		out[i] = result;
+	}
+}
@@ -0,0 +1,116 @@
+//
+// FSceneExpression.h
+//
+
+#pragma once
+
+#include "FSceneAttributeEngine.h"
+
+namespace UnrealEngine
+{
+	// Derived attribute compiled from a formula over the mesh, material and texture fields.
+	//
+	//   NumTriangles * NumInstances
+	//   sum(Texture.CurrentKB / Texture.NumRefs)
+	//   max(Material.BPSCount) * (sum(Material.TwoSided) > 0)
+	//
+	// Mesh fields: NumVertices, NumTriangles, NumInstances, NumLODs, NumMaterials, NumTextures (Mesh. prefix optional).
+	// Material. / Texture. fields are the ones registered on the engine, they are only read inside an
+	// aggregate over the materials / textures of the mesh: sum, avg, min, max, count (values other than 0).
+	// Operators: + - * / < > <= >= == != and unary -, comparisons give 1 or 0, x / 0 gives 0.
+	// Functions: min(a, b), max(a, b), abs, sqrt, log (sqrt / log of values <= 0 give 0).
+	//
+	// The source is compiled once to a stack bytecode, every instruction then runs over a batch of values.
+	class FSceneExpression
+	{
+	public:
+
+		bool Compile(const std::string& source, const FSceneAttributeEngine& engine, std::string& error);
+
+		// Per mesh values of the meshes [begin, end), out is the whole column (FSceneAttributeKernel contract).
+		void Evaluate(const FSceneAttributeContext& context, uint32 begin, uint32 end, float* out) const;
+
+		const std::string& GetSource() const { return m_source; }
+
+		static const uint32 BatchSize = 256;
+
+	private:
+
+		enum EOp : uint8
+		{
+			Op_Constant,
+			Op_MeshField,
+			Op_MaterialField,
+			Op_TextureField,
+			Op_Aggregate,
+			Op_Neg,
+			Op_Abs,
+			Op_Sqrt,
+			Op_Log,
+			Op_Add,
+			Op_Sub,
+			Op_Mul,
+			Op_Div,
+			Op_Min,
+			Op_Max,
+			Op_Less,
+			Op_Greater,
+			Op_LessEqual,
+			Op_GreaterEqual,
+			Op_Equal,
+			Op_NotEqual
+		};
+
+		enum EDomain
+		{
+			Domain_Mesh,
+			Domain_Material,
+			Domain_Texture
+		};
+
+		enum EAggregate
+		{
+			Aggregate_Sum,
+			Aggregate_Avg,
+			Aggregate_Min,
+			Aggregate_Max,
+			Aggregate_Count
+		};
+
+		struct Instruction
+		{
+			EOp Op;
+			int32 Index;
+			float Value;
+		};
+
+		struct Program
+		{
+			std::vector<Instruction> Code;
+			int32 MaxDepth = 0;
+		};
+
+		// Body runs over all the materials / textures of the scene, then is reduced per mesh.
+		struct Aggregate
+		{
+			EAggregate Type;
+			EDomain Domain;
+			Program Body;
+		};
+
+		class Compiler;
+
+		// Runs the program over count values from first, returns the slot holding the result.
+		// stack holds MaxDepth + 1 slots of BatchSize values.
+		const float* Run(const Program& program, const FSceneAttributeContext& context, uint32 first, uint32 count,
+			const std::vector<TArray<float>>& aggregateValues, float* stack) const;
+
+		void Reduce(const Aggregate& aggregate, const FSceneAttributeContext& context, uint32 first, uint32 count,
+			const TArray<float>& values, float* out) const;
+
+		std::string m_source;
+		Program m_program;
+		std::vector<Aggregate> m_aggregates;
+		int32 m_maxDepth = 0;
+	};
+}
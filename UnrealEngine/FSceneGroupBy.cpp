@@ -0,0 +1,257 @@
+//
+// FSceneGroupBy.cpp
+//
+
+#include "FSceneGroupBy.h"
+#include "../Common/StringManager.h"
+#include "../Common/ThreadManager.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using namespace UnrealEngine;
+using namespace DX::StringManager;
+using namespace DX::ThreadManager;
+
+namespace
+{
+	// Slice of a scene string.
+	struct GroupKey
+	{
+		const wchar_t* Data;
+		uint32 Length;
+
+		bool operator==(const GroupKey& other) const
+		{
+			return Length == other.Length && std::memcmp(Data, other.Data, Length * sizeof(wchar_t)) == 0;
+		}
+	};
+
+	struct GroupKeyHash
+	{
+		size_t operator()(const GroupKey& key) const
+		{
+			// FNV-1a.
+			uint64 hash = 14695981039346656037ull;
+			for (uint32 i = 0; i < key.Length; ++i)
+			{
+				hash ^= (uint64)key.Data[i];
+				hash *= 1099511628211ull;
+			}
+			return (size_t)hash;
+		}
+	};
+
+	struct GroupPartial
+	{
+		double Sum = 0.0;
+		double Count = 0.0;
+		float Min = std::numeric_limits<float>::max();
+		float Max = std::numeric_limits<float>::lowest();
+
+		void Add(float value, double count)
+		{
+			Sum += value * count;
+			Count += count;
+			Min = (std::min)(Min, value);
+			Max = (std::max)(Max, value);
+		}
+
+		void Merge(const GroupPartial& other)
+		{
+			Sum += other.Sum;
+			Count += other.Count;
+			Min = (std::min)(Min, other.Min);
+			Max = (std::max)(Max, other.Max);
+		}
+	};
+
+	using GroupTable = std::unordered_map<GroupKey, GroupPartial, GroupKeyHash>;
+
+	GroupKey MakeKey(const FString& str)
+	{
+		GroupKey key = { str.c_str(), (uint32)str.size() };
+		return key;
+	}
+
+	GroupKey MakeFolderKey(const FString& assetPath)
+	{
+		size_t slash = assetPath.find_last_of(L"/\\");
+		GroupKey key = { assetPath.c_str(), (uint32)(slash == FString::npos ? assetPath.size() : slash) };
+		return key;
+	}
+
+	// Named records (materials, textures) by name, path or folder.
+	template<typename TRecord>
+	GroupKey MakeRecordKey(const TRecord& record, EGroupByKey key)
+	{
+		switch (key)
+		{
+		case GK_AssetPath: return MakeKey(record.AssetPath);
+		case GK_AssetFolder: return MakeFolderKey(record.AssetPath);
+		default: return MakeKey(record.Name);
+		}
+	}
+
+	// Runs addRow(table, row) over [0, count) with one partial table per worker, merged into table.
+	template<typename TAddRow>
+	void Aggregate(uint32 count, GroupTable& table, const TAddRow& addRow)
+	{
+		const uint32 chunkSize = FSceneAttributeEngine::EvaluateChunkSize;
+		size_t numChunks = (count + chunkSize - 1) / chunkSize;
+		std::vector<GroupTable> partials(ThreadUtil::GetWorkerCount());
+		ThreadUtil::ParallelFor(numChunks, [&](size_t chunk, uint32 worker)
+		{
+			uint32 begin = (uint32)chunk * chunkSize;
+			uint32 end = (std::min)(begin + chunkSize, count);
+			for (uint32 row = begin; row < end; ++row)
+				addRow(partials[worker], row);
+		});
+
+		for (auto& partial : partials)
+		{
+			for (auto& group : partial)
+				table[group.first].Merge(group.second);
+		}
+	}
+}
+
+bool FSceneGroupBy::Run(const FSceneAttributeEngine& engine, const FSceneGroupByQuery& query,
+	const std::vector<FSceneDataSetPtr>& dataSets, const std::vector<std::shared_ptr<const FSceneAttributeContext>>& contexts,
+	std::vector<FSceneGroupRow>& rows, std::string& error)
+{
+	rows.clear();
+
+	const bool bMeshRows = query.Source == GS_Meshes || query.Source == GS_Instances;
+	if (!bMeshRows && (query.Key == GK_OwnerName || query.Key == GK_Material))
+	{
+		error = "OwnerName and Material keys need mesh or instance rows";
+		return false;
+	}
+
+	int32 field = -1;
+	if (query.Source == GS_Materials)
+		field = engine.FindMaterialField(query.Field);
+	else if (query.Source == GS_Textures)
+		field = engine.FindTextureField(query.Field);
+	if (!bMeshRows && field < 0)
+	{
+		error = "Unknown field '" + query.Field + "'";
+		return false;
+	}
+
+	GroupTable table;
+	for (size_t scene = 0; scene < contexts.size(); ++scene)
+	{
+		const FSceneDataSet& dataSet = *dataSets[scene];
+		const FSceneAttributeContext& context = *contexts[scene];
+
+		if (query.Source == GS_Materials)
+		{
+			const TArray<float>& values = context.MaterialColumns[field];
+			Aggregate(context.NumSceneMaterials, table, [&](GroupTable& partial, uint32 row)
+			{
+				partial[MakeRecordKey(dataSet.MaterialsTable[row], query.Key)].Add(values[row], 1.0);
+			});
+			continue;
+		}
+		if (query.Source == GS_Textures)
+		{
+			const TArray<float>& values = context.TextureColumns[field];
+			Aggregate(context.NumSceneTextures, table, [&](GroupTable& partial, uint32 row)
+			{
+				partial[MakeRecordKey(dataSet.TexturesTable[row], query.Key)].Add(values[row], 1.0);
+			});
+			continue;
+		}
+
+		// Instances share the value of their mesh, they only weight it.
+		TArray<float> meshValues(context.NumMeshes);
+		engine.EvaluateMeshes(query.Attribute, context, meshValues.data());
+		Aggregate(context.NumMeshes, table, [&](GroupTable& partial, uint32 mesh)
+		{
+			double count = 1.0;
+			if (query.Source == GS_Instances)
+			{
+				count = (double)(context.InstanceOffsets[mesh + 1] - context.InstanceOffsets[mesh]);
+				if (count == 0.0)
+					return;
+			}
+
+			if (query.Key == GK_Material)
+			{
+				for (int32 k = context.MaterialOffsets[mesh]; k < context.MaterialOffsets[mesh + 1]; ++k)
+					partial[MakeKey(dataSet.MaterialsTable[context.Materials[k]].Name)].Add(meshValues[mesh], count);
+				return;
+			}
+
+			auto addMesh = [&](const auto& record)
+			{
+				GroupKey key = query.Key == GK_OwnerName ? MakeKey(record.OwnerName) : MakeRecordKey(record, query.Key);
+				partial[key].Add(meshValues[mesh], count);
+			};
+			if (mesh < context.NumStaticMeshes)
+				addMesh(dataSet.StaticMeshesTable[mesh]);
+			else addMesh(dataSet.SkeletalMeshesTable[mesh - context.NumStaticMeshes]);
+		});
+	}
+
+	rows.reserve(table.size());
+	for (auto& group : table)
+	{
+		const GroupPartial& partial = group.second;
+		FSceneGroupRow row;
+		row.Key = StringUtil::WStringToString(FString(group.first.Data, group.first.Length));
+		row.Count = partial.Count;
+		switch (query.Aggregate)
+		{
+		case GA_Sum: row.Value = partial.Sum; break;
+		case GA_Count: row.Value = partial.Count; break;
+		case GA_Min: row.Value = partial.Min; break;
+		case GA_Max: row.Value = partial.Max; break;
+		case GA_Avg: row.Value = partial.Count > 0.0 ? partial.Sum / partial.Count : 0.0; break;
+		}
+		rows.push_back(row);
+	}
+	std::sort(rows.begin(), rows.end(), [](const FSceneGroupRow& a, const FSceneGroupRow& b)
+	{
+		return a.Value > b.Value || (a.Value == b.Value && a.Key < b.Key);
+	});
+
+	error.clear();
+	return true;
+}
+
+bool FSceneGroupBy::WriteCsv(const std::wstring& path, const std::vector<FSceneGroupRow>& rows, const std::string& keyName, const std::string& valueName)
+{
+	std::ofstream fout(path, std::ofstream::out | std::ofstream::trunc);
+	if (!fout.good())
+		return false;
+
+	// Keys are quoted, embedded quotes doubled.
+	auto quote = [](const std::string& str)
+	{
+		std::string quoted = "\"";
+		for (char c : str)
+		{
+			if (c == '"')
+				quoted += '"';
+			quoted += c;
+		}
+		return quoted + "\"";
+	};
+
+	fout.precision(10);
+	fout << quote(keyName) << "," << quote(valueName) << ",\"Count\"\n";
+	for (auto& row : rows)
+		fout << quote(row.Key) << "," << row.Value << "," << row.Count << "\n";
+	fout.close();
+
+	return true;
+}
+
+FString FSceneGroupBy::GetAssetFolder(const FString& assetPath)
+{
+	GroupKey key = MakeFolderKey(assetPath);
+	return FString(key.Data, key.Length);
+}
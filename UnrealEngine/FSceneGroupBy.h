@@ -0,0 +1,40 @@
+//
+// FSceneGroupBy.h
+//
+
+#pragma once
+
+#include "FSceneAttributeEngine.h"
+
+namespace UnrealEngine
+{
+	struct FSceneGroupByQuery
+	{
+		EGroupBySource Source = GS_Instances;
+		EGroupByKey Key = GK_OwnerName;
+		EGroupByAggregate Aggregate = GA_Sum;
+
+		// Value of the mesh / instance rows.
+		EVisualizationAttribute Attribute = VA_NumTriangles;
+		// Value of the material / texture rows, a field registered on the engine.
+		std::string Field;
+	};
+
+	// Hash aggregation over the scene tables. Rows are split in chunks on all the cores, every
+	// worker fills its own partial table and the partial tables are merged at the end. Keys point
+	// into the scene strings (nothing is copied per row), equal keys of different scenes merge.
+	class FSceneGroupBy
+	{
+	public:
+
+		// Rows sorted by value, heaviest first.
+		static bool Run(const FSceneAttributeEngine& engine, const FSceneGroupByQuery& query,
+			const std::vector<FSceneDataSetPtr>& dataSets, const std::vector<std::shared_ptr<const FSceneAttributeContext>>& contexts,
+			std::vector<FSceneGroupRow>& rows, std::string& error);
+
+		static bool WriteCsv(const std::wstring& path, const std::vector<FSceneGroupRow>& rows, const std::string& keyName, const std::string& valueName);
+
+		// "/Game/Props/SM_Chair.SM_Chair" -> "/Game/Props".
+		static FString GetAssetFolder(const FString& assetPath);
+	};
+}
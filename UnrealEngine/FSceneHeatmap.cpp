@@ -0,0 +1,255 @@
+//
+// FSceneHeatmap.cpp
+//
+
+#include "FSceneHeatmap.h"
+#include "../Common/ImageManager.h"
+#include "../Common/ReductionManager.h"
+#include "../Common/ThreadManager.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace UnrealEngine;
+using namespace DX::ImageManager;
+using namespace DX::ReductionManager;
+using namespace DX::ThreadManager;
+
+const float FSceneHeatmap::ClipValue = 0.001f;
+
+namespace
+{
+	// Boxes are binned by chunks, the unit of work of the binning passes.
+	const uint32 ChunkSize = 64 * 1024;
+
+	inline uint32 ClampCell(float cell, uint32 numCells)
+	{
+		float clamped = (std::min)((std::max)(std::floor(cell), 0.0f), (float)(numCells - 1));
+		return (uint32)clamped;
+	}
+
+	inline float Saturate(float value)
+	{
+		return (std::min)((std::max)(value, 0.0f), 1.0f);
+	}
+
+	inline uint8 ToUNorm8(float value)
+	{
+		return (uint8)(Saturate(value) * 255.0f + 0.5f);
+	}
+}
+
+void FSceneHeatmap::Build(const FSceneAttributeEngine& engine, const FSceneDataSet& dataSet, const std::vector<const FSceneDataSet*>& lods,
+	const FSceneHeatmapOptions& options)
+{
+	std::unique_ptr<FSceneAttributeContext> context = engine.BuildContext(dataSet, lods);
+	TArray<float> values(context->NumInstances);
+	engine.Evaluate(options.Attribute, *context, values.data());
+
+	// Same slot order as the values.
+	std::vector<BVHBounds> bounds;
+	FSceneSpatialIndex::GetInstanceBounds(dataSet, bounds);
+	Build(bounds, values.data(), options);
+}
+
+void FSceneHeatmap::Build(const std::vector<BVHBounds>& bounds, const float* values, const FSceneHeatmapOptions& options)
+{
+	const uint32 numBoxes = (uint32)bounds.size();
+	auto isUsable = [&](uint32 i)
+	{
+		const BVHBounds& box = bounds[i];
+		return box.IsValid() && std::isfinite(values[i]) &&
+			std::isfinite(box.Min[0]) && std::isfinite(box.Max[0]) && std::isfinite(box.Min[2]) && std::isfinite(box.Max[2]);
+	};
+
+	// Extent of the usable boxes on XZ, the grid covers it with square cells.
+	float minX = std::numeric_limits<float>::max(), maxX = std::numeric_limits<float>::lowest();
+	float minZ = std::numeric_limits<float>::max(), maxZ = std::numeric_limits<float>::lowest();
+	for (uint32 i = 0; i < numBoxes; ++i)
+	{
+		if (!isUsable(i))
+			continue;
+		minX = (std::min)(minX, bounds[i].Min[0]);
+		maxX = (std::max)(maxX, bounds[i].Max[0]);
+		minZ = (std::min)(minZ, bounds[i].Min[2]);
+		maxZ = (std::max)(maxZ, bounds[i].Max[2]);
+	}
+
+	m_cells.clear();
+	m_width = m_height = 0;
+	if (minX > maxX)
+		return;
+
+	const uint32 resolution = (std::min)((std::max)(options.Resolution, 1u), MaxResolution);
+	m_cellSize = (std::max)(maxX - minX, maxZ - minZ) / (float)resolution;
+	if (!(m_cellSize > 0.0f))
+		m_cellSize = 1.0f;
+	m_width = (std::min)((std::max)((uint32)std::ceil((maxX - minX) / m_cellSize), 1u), resolution);
+	m_height = (std::min)((std::max)((uint32)std::ceil((maxZ - minZ) / m_cellSize), 1u), resolution);
+	m_cells.assign((size_t)m_width * m_height, 0.0f);
+
+	// Footprint of a box in cell units, y grows towards -Z.
+	const float invCellSize = 1.0f / m_cellSize;
+	const bool bCenter = options.Splat == HS_Center;
+	auto getFootprint = [&](uint32 i, float& x0, float& x1, float& y0, float& y1)
+	{
+		x0 = (bounds[i].Min[0] - minX) * invCellSize;
+		x1 = (bounds[i].Max[0] - minX) * invCellSize;
+		y0 = (maxZ - bounds[i].Max[2]) * invCellSize;
+		y1 = (maxZ - bounds[i].Min[2]) * invCellSize;
+	};
+
+	// Inclusive cell range a box touches, false if it adds nothing.
+	auto getCellRange = [&](uint32 i, uint32& c0, uint32& c1, uint32& r0, uint32& r1)
+	{
+		if (!isUsable(i))
+			return false;
+		float x0, x1, y0, y1;
+		getFootprint(i, x0, x1, y0, y1);
+		if (bCenter)
+		{
+			c0 = c1 = ClampCell((x0 + x1) * 0.5f, m_width);
+			r0 = r1 = ClampCell((y0 + y1) * 0.5f, m_height);
+			return true;
+		}
+		// No area, nothing to cover (the box pass draws nothing either).
+		if (!(x1 > x0) || !(y1 > y0))
+			return false;
+		c0 = ClampCell(x0, m_width);
+		c1 = ClampCell(std::ceil(x1) - 1.0f, m_width);
+		r0 = ClampCell(y0, m_height);
+		r1 = ClampCell(std::ceil(y1) - 1.0f, m_height);
+		return true;
+	};
+
+	// Bin the boxes to the tiles they touch: count per chunk and tile, prefix sum, fill.
+	// The lists of a tile keep the box order, the result does not depend on the thread count.
+	const uint32 tilesX = (m_width + TileSize - 1) / TileSize;
+	const uint32 tilesY = (m_height + TileSize - 1) / TileSize;
+	const size_t numTiles = (size_t)tilesX * tilesY;
+	const size_t numChunks = (numBoxes + ChunkSize - 1) / ChunkSize;
+	std::vector<size_t> offsets(numTiles * numChunks + 1, 0);
+
+	auto forEachTile = [&](uint32 i, const auto& lambda)
+	{
+		uint32 c0, c1, r0, r1;
+		if (!getCellRange(i, c0, c1, r0, r1))
+			return;
+		for (uint32 ty = r0 / TileSize; ty <= r1 / TileSize; ++ty)
+		{
+			for (uint32 tx = c0 / TileSize; tx <= c1 / TileSize; ++tx)
+				lambda((size_t)ty * tilesX + tx);
+		}
+	};
+
+	ThreadUtil::ParallelFor(numChunks, [&](size_t chunk, uint32)
+	{
+		uint32 end = (std::min)((uint32)(chunk + 1) * ChunkSize, numBoxes);
+		for (uint32 i = (uint32)chunk * ChunkSize; i < end; ++i)
+			forEachTile(i, [&](size_t tile) { ++offsets[tile * numChunks + chunk + 1]; });
+	});
+	for (size_t slot = 1; slot < offsets.size(); ++slot)
+		offsets[slot] += offsets[slot - 1];
+
+	std::vector<uint32> entries(offsets.back());
+	ThreadUtil::ParallelFor(numChunks, [&](size_t chunk, uint32)
+	{
+		std::vector<size_t> cursors(numTiles);
+		for (size_t tile = 0; tile < numTiles; ++tile)
+			cursors[tile] = offsets[tile * numChunks + chunk];
+		uint32 end = (std::min)((uint32)(chunk + 1) * ChunkSize, numBoxes);
+		for (uint32 i = (uint32)chunk * ChunkSize; i < end; ++i)
+			forEachTile(i, [&](size_t tile) { entries[cursors[tile]++] = i; });
+	});
+
+	// Every tile in its worker's buffer (doubles, a cell can sum millions of boxes), then copied to the grid.
+	std::vector<std::vector<double>> workerTiles(ThreadUtil::GetWorkerCount());
+	ThreadUtil::ParallelFor(numTiles, [&](size_t tile, uint32 worker)
+	{
+		const uint32 tileX0 = (uint32)(tile % tilesX) * TileSize, tileY0 = (uint32)(tile / tilesX) * TileSize;
+		const uint32 tileX1 = (std::min)(tileX0 + TileSize, m_width), tileY1 = (std::min)(tileY0 + TileSize, m_height);
+		std::vector<double>& buffer = workerTiles[worker];
+		buffer.assign((size_t)TileSize * TileSize, 0.0);
+
+		for (size_t entry = offsets[tile * numChunks]; entry < offsets[(tile + 1) * numChunks]; ++entry)
+		{
+			const uint32 i = entries[entry];
+			const double value = values[i];
+			uint32 c0, c1, r0, r1;
+			getCellRange(i, c0, c1, r0, r1);
+			c0 = (std::max)(c0, tileX0);
+			c1 = (std::min)(c1, tileX1 - 1);
+			r0 = (std::max)(r0, tileY0);
+			r1 = (std::min)(r1, tileY1 - 1);
+
+			if (bCenter)
+			{
+				buffer[(size_t)(r0 - tileY0) * TileSize + (c0 - tileX0)] += value;
+				continue;
+			}
+
+			// Part of every cell inside the footprint.
+			float x0, x1, y0, y1;
+			getFootprint(i, x0, x1, y0, y1);
+			for (uint32 row = r0; row <= r1; ++row)
+			{
+				double weightY = (std::min)(y1, (float)(row + 1)) - (std::max)(y0, (float)row);
+				double* cells = buffer.data() + (size_t)(row - tileY0) * TileSize - tileX0;
+				for (uint32 col = c0; col <= c1; ++col)
+				{
+					double weightX = (std::min)(x1, (float)(col + 1)) - (std::max)(x0, (float)col);
+					cells[col] += value * weightX * weightY;
+				}
+			}
+		}
+
+		for (uint32 row = tileY0; row < tileY1; ++row)
+		{
+			const double* source = buffer.data() + (size_t)(row - tileY0) * TileSize;
+			float* target = m_cells.data() + (size_t)row * m_width + tileX0;
+			for (uint32 col = 0; col < tileX1 - tileX0; ++col)
+				target[col] = (float)source[col];
+		}
+	});
+}
+
+float FSceneHeatmap::GetAutoOverflow() const
+{
+	float overflow = ReduceUtil::Percentile(m_cells.data(), m_cells.size(), 0.99f, ClipValue);
+	return overflow > 0.0f ? overflow : 1.0f;
+}
+
+bool FSceneHeatmap::WritePFM(const std::wstring& path) const
+{
+	return ImageUtil::WritePFM(path, m_width, m_height, 1, m_cells.data());
+}
+
+bool FSceneHeatmap::WritePNG(const std::wstring& path, float overflow) const
+{
+	if (!(overflow > 0.0f))
+		overflow = GetAutoOverflow();
+
+	// RGBPS, blue -> green -> red over [0, overflow].
+	std::vector<uint8> pixels(m_cells.size() * 4);
+	ThreadUtil::ParallelFor(m_height, [&](size_t row, uint32)
+	{
+		for (uint32 col = 0; col < m_width; ++col)
+		{
+			size_t cell = row * m_width + col;
+			float value = m_cells[cell];
+			uint8* pixel = pixels.data() + cell * 4;
+			if (!(value >= ClipValue))
+			{
+				pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
+				continue;
+			}
+			float smooth = Saturate(value / overflow);
+			pixel[0] = ToUNorm8(smooth * 2.0f - 1.0f);
+			pixel[1] = ToUNorm8(std::abs(std::abs(smooth * 2.0f - 1.0f) - 1.0f));
+			pixel[2] = ToUNorm8(1.0f - Saturate(smooth * 2.0f));
+			pixel[3] = 255;
+		}
+	});
+
+	return ImageUtil::WritePNG(path, m_width, m_height, 4, pixels.data());
+}
@@ -0,0 +1,63 @@
+//
+// FSceneHeatmap.h
+//
+
+#pragma once
+
+#include "FSceneAttributeEngine.h"
+#include "FSceneSpatialIndex.h"
+
+namespace UnrealEngine
+{
+	struct FSceneHeatmapOptions
+	{
+		EVisualizationAttribute Attribute = VA_NumActors;
+		EHeatmapSplat Splat = HS_Coverage;
+		// Cells along the longer side of the scene, the cells are square.
+		uint32 Resolution = 1024;
+		// Value at the top of the colour ramp, 0 picks the P99 of the non-empty cells.
+		float Overflow = 0.0f;
+	};
+
+	// Top-down heatmap of an attribute on the XZ plane of render space, the CPU counterpart of the
+	// BoxBlendAdd pass seen from above. Row 0 is the max Z edge, columns go along +X.
+	//
+	// The instances are binned to tiles of TileSize^2 cells, then every tile is accumulated by one worker
+	// in its own buffer and copied to the grid, so no cell is ever written by two threads.
+	class FSceneHeatmap
+	{
+	public:
+
+		void Build(const FSceneAttributeEngine& engine, const FSceneDataSet& dataSet, const std::vector<const FSceneDataSet*>& lods,
+			const FSceneHeatmapOptions& options);
+
+		// values holds one value per box, non finite values and invalid boxes are skipped.
+		void Build(const std::vector<BVHBounds>& bounds, const float* values, const FSceneHeatmapOptions& options);
+
+		uint32 GetWidth() const { return m_width; }
+		uint32 GetHeight() const { return m_height; }
+		const std::vector<float>& GetCells() const { return m_cells; }
+		float GetCellSize() const { return m_cellSize; }
+
+		// P99 of the cells RGBPS would not clip.
+		float GetAutoOverflow() const;
+
+		// Raw accumulated values, one channel.
+		bool WritePFM(const std::wstring& path) const;
+
+		// RGBPS ramp over [0, overflow] (GetAutoOverflow when 0), the cells RGBPS clips are transparent.
+		bool WritePNG(const std::wstring& path, float overflow) const;
+
+		static const uint32 TileSize = 256;
+		static const uint32 MaxResolution = 16384;
+		// Cells below it are the background, like clip(color - 0.001) in RGBPS.
+		static const float ClipValue;
+
+	private:
+
+		uint32 m_width = 0;
+		uint32 m_height = 0;
+		float m_cellSize = 1.0f;
+		std::vector<float> m_cells;
+	};
+}
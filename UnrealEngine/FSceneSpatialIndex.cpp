@@ -0,0 +1,52 @@
+//
+// FSceneSpatialIndex.cpp
+//
+
+#include "FSceneSpatialIndex.h"
+
+using namespace UnrealEngine;
+
+namespace
+{
+	BVHBounds ToRenderSpace(const FBoxSphereBounds& bounds)
+	{
+		const XMFLOAT3& center = bounds.BoxBounds.Center;
+		const XMFLOAT3& extents = bounds.BoxBounds.Extents;
+		BVHBounds box;
+		box.Min[0] = -(center.x + extents.x);
+		box.Max[0] = -(center.x - extents.x);
+		box.Min[1] = center.z - extents.z;
+		box.Max[1] = center.z + extents.z;
+		box.Min[2] = center.y - extents.y;
+		box.Max[2] = center.y + extents.y;
+		return box;
+	}
+}
+
+FSceneSpatialIndex::FSceneSpatialIndex(const FSceneDataSet& dataSet)
+{
+	std::vector<BVHBounds> bounds;
+	GetInstanceBounds(dataSet, bounds);
+	m_bvh.Build(bounds);
+
+	m_bounds.Resize(bounds.size());
+	for (size_t i = 0; i < bounds.size(); ++i)
+		m_bounds.Set(i, bounds[i].Min, bounds[i].Max);
+}
+
+void FSceneSpatialIndex::GetInstanceBounds(const FSceneDataSet& dataSet, std::vector<BVHBounds>& bounds)
+{
+	size_t numInstances = dataSet.SkeletalMeshesTable.size();
+	for (auto& staticMesh : dataSet.StaticMeshesTable)
+		numInstances += staticMesh.BoundsIndices.size();
+
+	bounds.clear();
+	bounds.reserve(numInstances);
+	for (auto& staticMesh : dataSet.StaticMeshesTable)
+	{
+		for (auto& boundsIndex : staticMesh.BoundsIndices)
+			bounds.push_back(ToRenderSpace(dataSet.BoundsTable[boundsIndex]));
+	}
+	for (auto& skeletalMesh : dataSet.SkeletalMeshesTable)
+		bounds.push_back(ToRenderSpace(dataSet.BoundsTable[skeletalMesh.BoundsIndex]));
+}
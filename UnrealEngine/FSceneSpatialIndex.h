@@ -0,0 +1,37 @@
+//
+// FSceneSpatialIndex.h
+//
+
+#pragma once
+
+#include "../AppData.h"
+#include "../Common/BVHManager.h"
+#include "../Common/CullingManager.h"
+
+namespace UnrealEngine
+{
+	using DX::BVHManager::BVH;
+	using DX::BVHManager::BVHBounds;
+	using DX::BVHManager::BVHRayHit;
+	using DX::CullingManager::BoundsSoA;
+
+	// BVH over the instance boxes of one scene, built once at import. Primitive ids are the instance slots
+	// (structure buffer order, see FSceneAttributeContext). Boxes are in render space, UE4 (x, y, z) -> (-x, z, y)
+	// like RightHandToLeft, before FSceneScale. The same boxes are kept as SoA arrays (slot order) for the frustum culling.
+	class FSceneSpatialIndex
+	{
+	public:
+
+		explicit FSceneSpatialIndex(const FSceneDataSet& dataSet);
+
+		const BVH& GetBVH() const { return m_bvh; }
+		const BoundsSoA& GetBounds() const { return m_bounds; }
+
+		static void GetInstanceBounds(const FSceneDataSet& dataSet, std::vector<BVHBounds>& bounds);
+
+	private:
+
+		BVH m_bvh;
+		BoundsSoA m_bounds;
+	};
+}